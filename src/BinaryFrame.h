@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtEndian>
+#include <string.h>
+
+// Every binary websocket frame starts with this fixed 8 byte little-endian header:
+//
+//   uint8   frameType   (BinaryFrameType)
+//   uint8   version     (currently 1)
+//   uint16  channelId   (logical session the frame belongs to)
+//   uint32  streamId    (frame type specific, Eg. a sequence number or a transfer ID)
+//
+// followed by the frame type specific payload.
+enum class BinaryFrameType: uint8_t {
+	// Payload: uint64 timestamp (ns), uint16 width, uint16 height, encoded image bytes
+	ProgramThumbnail = 1,
+	// Payload: uint64 timestamp (ns), uint8 meter count, then per meter:
+	//   uint8 meter index (into `sourceNames`), uint8 flags (1 = audio active, 2 = muted), uint8 channel count,
+	//   then per channel int16 peak and int16 RMS in hundredths of a dB (-10000 = silence)
+	AudioLevels = 2,
+	// Payload: uint64 offset of the chunk in the file, uint64 file size, uint8 flags (1 = last chunk, 2 = transfer aborted),
+	//   chunk bytes. The stream ID is the transfer ID.
+	FileChunk = 3,
+	// Payload: uint32 fragment index, uint8 flags (1 = final fragment), next slice of the response's UTF-8 JSON.
+	//   The stream ID identifies the response. Concatenating its slices gives the complete response message.
+	ResponseFragment = 4,
+};
+
+static const uint8_t BinaryFrameVersion = 1;
+static const int BinaryFrameHeaderSize = 8;
+
+// For senders that write their payload straight into the frame instead of copying it from a separate buffer
+static inline void WriteBinaryFrameHeader(uchar *data, BinaryFrameType frameType, uint16_t channelId, uint32_t streamId)
+{
+	data[0] = (uint8_t)frameType;
+	data[1] = BinaryFrameVersion;
+	qToLittleEndian<quint16>(channelId, data + 2);
+	qToLittleEndian<quint32>(streamId, data + 4);
+}
+
+static inline QByteArray BuildBinaryFrame(BinaryFrameType frameType, uint16_t channelId, uint32_t streamId, const QByteArray &payload)
+{
+	QByteArray frame(BinaryFrameHeaderSize + payload.size(), Qt::Uninitialized);
+	uchar *data = (uchar*)frame.data();
+
+	WriteBinaryFrameHeader(data, frameType, channelId, streamId);
+	if (!payload.isEmpty())
+		memcpy(data + BinaryFrameHeaderSize, payload.constData(), payload.size());
+
+	return frame;
+}
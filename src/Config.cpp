@@ -2,13 +2,20 @@
 
 #include <QtCore/QCryptographicHash>
 #include <QtCore/QTime>
+#include <QtCore/QThread>
 #include <QtWidgets/QSystemTrayIcon>
 
 #define SECTION_NAME "IRLTKSelfHost"
 #define PARAM_CONNECTONLOAD "ConnectOnLoad"
 #define PARAM_SESSIONKEY "SessionKey"
+#define PARAM_ADDITIONALSESSIONKEYS "AdditionalSessionKeys"
 #define PARAM_CONNECTURL "ConnectUrl"
 #define PARAM_AUTORECONNECT "AutoReconnect"
+#define PARAM_WORKERTHREADCOUNT "WorkerThreadCount"
+#define PARAM_WORKERTHREADPRIORITY "WorkerThreadPriority"
+#define PARAM_WORKERCPUAFFINITY "WorkerCpuAffinity"
+#define PARAM_WORKERNICENESS "WorkerNiceness"
+#define PARAM_WORKEREXPIRYTIMEOUT "WorkerExpiryTimeout"
 
 #include "plugin-main.h"
 #include "Config.h"
@@ -16,8 +23,14 @@
 Config::Config() :
 	ConnectOnLoad(true),
 	SessionKey(""),
+	AdditionalSessionKeys(),
 	ConnectUrl(""),
-	AutoReconnect(true)
+	AutoReconnect(true),
+	WorkerThreadCount(0),
+	WorkerThreadPriority(QThread::LowPriority),
+	WorkerCpuAffinity(""),
+	WorkerNiceness(0),
+	WorkerExpiryTimeout(30000)
 {
 	qsrand(QTime::currentTime().msec());
 
@@ -33,13 +46,21 @@ void Config::Load()
 
 	ConnectOnLoad = config_get_bool(obsConfig, SECTION_NAME, PARAM_CONNECTONLOAD);
 	SessionKey = config_get_string(obsConfig, SECTION_NAME, PARAM_SESSIONKEY);
+	AdditionalSessionKeys = QString(config_get_string(obsConfig, SECTION_NAME, PARAM_ADDITIONALSESSIONKEYS)).split(',', QString::SkipEmptyParts);
 	ConnectUrl = config_get_string(obsConfig, SECTION_NAME, PARAM_CONNECTURL);
 	AutoReconnect = config_get_bool(obsConfig, SECTION_NAME, PARAM_AUTORECONNECT);
+	WorkerThreadCount = config_get_int(obsConfig, SECTION_NAME, PARAM_WORKERTHREADCOUNT);
+	WorkerThreadPriority = config_get_int(obsConfig, SECTION_NAME, PARAM_WORKERTHREADPRIORITY);
+	WorkerCpuAffinity = config_get_string(obsConfig, SECTION_NAME, PARAM_WORKERCPUAFFINITY);
+	WorkerNiceness = config_get_int(obsConfig, SECTION_NAME, PARAM_WORKERNICENESS);
+	WorkerExpiryTimeout = config_get_int(obsConfig, SECTION_NAME, PARAM_WORKEREXPIRYTIMEOUT);
 #ifdef DEBUG_MODE
     blog(LOG_INFO, "Connect on load: %d", ConnectOnLoad);
 	blog(LOG_INFO, "Session Key: %s", SessionKey.toStdString().c_str());
+	blog(LOG_INFO, "Additional session keys: %d", AdditionalSessionKeys.size());
 	blog(LOG_INFO, "Websocket connect URL: %s", ConnectUrl.toStdString().c_str());
 	blog(LOG_INFO, "Auto reconnect: %d", AutoReconnect);
+	blog(LOG_INFO, "Worker threads: %d | Priority: %d | Affinity: %s | Niceness: %d | Expiry: %d", WorkerThreadCount, WorkerThreadPriority, WorkerCpuAffinity.toStdString().c_str(), WorkerNiceness, WorkerExpiryTimeout);
 	blog(LOG_INFO, "Finished loading settings!");
 #endif
 }
@@ -52,10 +73,22 @@ void Config::Save()
 		ConnectOnLoad);
 	config_set_string(obsConfig, SECTION_NAME, PARAM_SESSIONKEY,
 		QT_TO_UTF8(SessionKey));
+	config_set_string(obsConfig, SECTION_NAME, PARAM_ADDITIONALSESSIONKEYS,
+		QT_TO_UTF8(AdditionalSessionKeys.join(',')));
 	config_set_string(obsConfig, SECTION_NAME, PARAM_CONNECTURL,
 		QT_TO_UTF8(ConnectUrl));
 	config_set_bool(obsConfig, SECTION_NAME, PARAM_AUTORECONNECT,
 		AutoReconnect);
+	config_set_int(obsConfig, SECTION_NAME, PARAM_WORKERTHREADCOUNT,
+		WorkerThreadCount);
+	config_set_int(obsConfig, SECTION_NAME, PARAM_WORKERTHREADPRIORITY,
+		WorkerThreadPriority);
+	config_set_string(obsConfig, SECTION_NAME, PARAM_WORKERCPUAFFINITY,
+		QT_TO_UTF8(WorkerCpuAffinity));
+	config_set_int(obsConfig, SECTION_NAME, PARAM_WORKERNICENESS,
+		WorkerNiceness);
+	config_set_int(obsConfig, SECTION_NAME, PARAM_WORKEREXPIRYTIMEOUT,
+		WorkerExpiryTimeout);
 
 	config_save(obsConfig);
 
@@ -73,13 +106,36 @@ void Config::SetDefaults()
 			PARAM_CONNECTONLOAD, ConnectOnLoad);
 		config_set_default_string(obsConfig,
 			SECTION_NAME, PARAM_SESSIONKEY, QT_TO_UTF8(SessionKey));
+		config_set_default_string(obsConfig,
+			SECTION_NAME, PARAM_ADDITIONALSESSIONKEYS, "");
 		config_set_default_string(obsConfig,
 			SECTION_NAME, PARAM_CONNECTURL, QT_TO_UTF8(ConnectUrl));
 		config_set_default_bool(obsConfig, SECTION_NAME,
 			PARAM_AUTORECONNECT, AutoReconnect);
+		config_set_default_int(obsConfig, SECTION_NAME,
+			PARAM_WORKERTHREADCOUNT, WorkerThreadCount);
+		config_set_default_int(obsConfig, SECTION_NAME,
+			PARAM_WORKERTHREADPRIORITY, WorkerThreadPriority);
+		config_set_default_string(obsConfig, SECTION_NAME,
+			PARAM_WORKERCPUAFFINITY, QT_TO_UTF8(WorkerCpuAffinity));
+		config_set_default_int(obsConfig, SECTION_NAME,
+			PARAM_WORKERNICENESS, WorkerNiceness);
+		config_set_default_int(obsConfig, SECTION_NAME,
+			PARAM_WORKEREXPIRYTIMEOUT, WorkerExpiryTimeout);
 	}
 }
 
+WorkerPoolSettings Config::GetWorkerPoolSettings()
+{
+	WorkerPoolSettings settings;
+	settings.ThreadCount = WorkerThreadCount;
+	settings.ThreadPriority = WorkerThreadPriority;
+	settings.CpuAffinity = WorkerCpuAffinity;
+	settings.Niceness = WorkerNiceness;
+	settings.ExpiryTimeout = WorkerExpiryTimeout;
+	return settings;
+}
+
 config_t* Config::GetConfigStore()
 {
 	return obs_frontend_get_global_config();
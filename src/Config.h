@@ -3,9 +3,11 @@
 #include <obs-frontend-api.h>
 #include <util/config-file.h>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 #include <QtCore/QSharedPointer>
 
 #include "plugin-main.h"
+#include "WorkerPool.h"
 
 class Config {
 	public:
@@ -17,8 +19,16 @@ class Config {
 
 		bool ConnectOnLoad;
 		QString SessionKey;
+		QStringList AdditionalSessionKeys;
 		QString ConnectUrl;
 		bool AutoReconnect;
+		int WorkerThreadCount;
+		int WorkerThreadPriority;
+		QString WorkerCpuAffinity;
+		int WorkerNiceness;
+		int WorkerExpiryTimeout;
+
+		WorkerPoolSettings GetWorkerPoolSettings();
 
 	private:
 		;
@@ -0,0 +1,92 @@
+#include <util/platform.h>
+
+#include "ConnectionStateMachine.h"
+
+ConnectionStateMachine::ConnectionStateMachine() :
+	_state((uint8_t)ConnectionState::Closed),
+	_stateEnteredAt(os_gettime_ns()),
+	_connectStartedAt(0),
+	_lastConnectDuration(0)
+{
+	for (size_t i = 0; i < StateCount; i++) {
+		_transitionCount[i] = 0;
+		_lastEnteredAt[i] = 0;
+		_lastDuration[i] = 0;
+		_totalDuration[i] = 0;
+	}
+}
+
+bool ConnectionStateMachine::Transition(ConnectionState newState)
+{
+	QMutexLocker locker(&_mutex);
+
+	uint8_t oldState = _state.load(std::memory_order_relaxed);
+	if (oldState == (uint8_t)newState)
+		return false;
+
+	uint64_t now = os_gettime_ns();
+	uint64_t enteredAt = _stateEnteredAt.load(std::memory_order_relaxed);
+	uint64_t duration = now > enteredAt ? now - enteredAt : 0;
+	_stateEnteredAt.store(now, std::memory_order_release);
+	_state.store((uint8_t)newState, std::memory_order_release);
+
+	_lastDuration[oldState] = duration;
+	_totalDuration[oldState] += duration;
+	_transitionCount[(size_t)newState]++;
+	_lastEnteredAt[(size_t)newState] = now;
+
+	if (newState == ConnectionState::Connecting)
+		_connectStartedAt = now;
+	else if (newState == ConnectionState::Identified && _connectStartedAt)
+		_lastConnectDuration = now - _connectStartedAt;
+
+	return true;
+}
+
+QJsonObject ConnectionStateMachine::GetStats() const
+{
+	QJsonObject ret;
+
+	QMutexLocker locker(&_mutex);
+	uint64_t now = os_gettime_ns();
+
+	ret["state"] = StateName(State());
+	uint64_t enteredAt = _stateEnteredAt.load(std::memory_order_relaxed);
+	ret["stateDuration"] = (double)((now > enteredAt ? now - enteredAt : 0) / 1000000);
+	// Session machines start at `Handshaking`, their socket's connect time is reported by the main machine
+	if (_transitionCount[(size_t)ConnectionState::Connecting])
+		ret["lastConnectDuration"] = (double)(_lastConnectDuration / 1000000);
+
+	QJsonObject states;
+	for (size_t i = 0; i < StateCount; i++) {
+		QJsonObject stateStats;
+		stateStats["transitionCount"] = (double)_transitionCount[i];
+		// Milliseconds since the state was last entered, left out if it never was
+		if (_lastEnteredAt[i])
+			stateStats["lastEnteredAgo"] = (double)((now - _lastEnteredAt[i]) / 1000000);
+		stateStats["lastDuration"] = (double)(_lastDuration[i] / 1000000);
+		stateStats["totalDuration"] = (double)(_totalDuration[i] / 1000000);
+		states[StateName((ConnectionState)i)] = stateStats;
+	}
+	ret["states"] = states;
+
+	return ret;
+}
+
+const char *ConnectionStateMachine::StateName(ConnectionState state)
+{
+	switch (state) {
+		case ConnectionState::Closed:
+			return "closed";
+		case ConnectionState::Connecting:
+			return "connecting";
+		case ConnectionState::Handshaking:
+			return "handshaking";
+		case ConnectionState::Identified:
+			return "identified";
+		case ConnectionState::Draining:
+			return "draining";
+		default:
+			return "unknown";
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <QtCore/QMutex>
+#include <QMetaType>
+#include <QJsonObject>
+
+#include "plugin-main.h"
+
+enum class ConnectionState: uint8_t {
+	// No connection exists (initial state)
+	Closed = 0,
+	// The socket is being opened
+	Connecting,
+	// The socket is open and `Identify` has been or is about to be sent
+	Handshaking,
+	// The server accepted the `Identify`
+	Identified,
+	// A local disconnect was requested and the socket is closing
+	Draining,
+
+	Count
+};
+
+// The current state and the time it was entered are atomics so that either can be read from any thread without locking.
+// Transitions and the telemetry they update are serialized by a mutex, which `GetStats()` also takes so that it reports
+// a state together with the time that state was entered.
+class ConnectionStateMachine {
+	public:
+		ConnectionStateMachine();
+
+		ConnectionState State() const
+		{
+			return (ConnectionState)_state.load(std::memory_order_acquire);
+		}
+
+		bool IsIdentified() const
+		{
+			return State() == ConnectionState::Identified;
+		}
+
+		// Returns false if the machine was already in `newState`
+		bool Transition(ConnectionState newState);
+
+		uint64_t StateEnteredAt() const
+		{
+			return _stateEnteredAt.load(std::memory_order_acquire);
+		}
+
+		// `lastConnectDuration` is only reported by machines that go through `Connecting`
+		QJsonObject GetStats() const;
+
+		static const char *StateName(ConnectionState state);
+
+	private:
+		static const size_t StateCount = (size_t)ConnectionState::Count;
+
+		mutable QMutex _mutex;
+		std::atomic<uint8_t> _state;
+		std::atomic<uint64_t> _stateEnteredAt;
+		uint64_t _connectStartedAt;
+		uint64_t _lastConnectDuration;
+		uint64_t _transitionCount[StateCount];
+		uint64_t _lastEnteredAt[StateCount];
+		uint64_t _lastDuration[StateCount];
+		uint64_t _totalDuration[StateCount];
+};
+
+Q_DECLARE_METATYPE(ConnectionState)
@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <string.h>
+#include <util/platform.h>
+#include <QtEndian>
+
+#include "FileTransfers.h"
+#include "WebsocketManager.h"
+
+// Bytes the socket may have queued before transfers pause
+#define TRANSFER_WINDOW (2 * 1024 * 1024)
+// Longest wait for the socket backlog to drain before checking whether transfers were stopped
+#define FLOW_CONTROL_TIMEOUT 100
+// Bytes of the file mapped at a time. Must be at least the largest chunk size.
+#define MAP_WINDOW_SIZE (64ULL * 1024 * 1024)
+// uint64 offset, uint64 file size, uint8 flags
+#define CHUNK_HEADER_SIZE 17
+
+// Seconds of the bandwidth cap that may be sent in one burst after transfers were idle
+#define BANDWIDTH_BURST 0.25
+
+#define CHUNK_FLAG_LAST 1
+#define CHUNK_FLAG_ABORTED 2
+
+FileTransfers::FileTransfers() :
+	_running(true),
+	_nextId(0),
+	_tokens(0.0),
+	_tokensUpdatedAt(0),
+	_started(0),
+	_completed(0),
+	_aborted(0),
+	_bytesSent(0),
+	_flowControlWaits(0),
+	_bandwidthWaits(0)
+{
+	_transferThread = std::thread(&FileTransfers::_TransferLoop, this);
+}
+
+FileTransfers::~FileTransfers()
+{
+	{
+		QMutexLocker locker(&_mutex);
+		_running = false;
+		_condition.wakeAll();
+	}
+	_transferThread.join();
+
+	for (auto &transfer : _transfers) {
+		if (transfer->Map)
+			transfer->File.unmap(transfer->Map);
+	}
+}
+
+RequestStatus FileTransfers::StartTransfer(uint16_t channelId, const QString &path, uint64_t offset, uint64_t length, int chunkSize, QJsonObject &transferJson, QString &comment)
+{
+	TransferPtr transfer = std::make_shared<Transfer>();
+	transfer->File.setFileName(path);
+	if (!transfer->File.open(QIODevice::ReadOnly)) {
+		comment = QString("Unable to open the file: %1").arg(transfer->File.errorString());
+		return RequestStatus::RequestProcessingFailed;
+	}
+
+	transfer->FileSize = (uint64_t)transfer->File.size();
+	if (offset > transfer->FileSize) {
+		comment = "Parameter: offset\nThe offset is past the end of the file.";
+		return RequestStatus::RequestParameterOutOfRange;
+	}
+
+	transfer->ChannelId = channelId;
+	transfer->Path = path;
+	transfer->StartOffset = offset;
+	transfer->EndOffset = (length && length < transfer->FileSize - offset) ? offset + length : transfer->FileSize;
+	transfer->Offset = offset;
+	transfer->ChunkSize = chunkSize;
+	transfer->StartedAt = os_gettime_ns();
+
+	{
+		QMutexLocker locker(&_mutex);
+		transfer->Id = ++_nextId;
+		transferJson = TransferToJson(*transfer);
+		_transfers.push_back(transfer);
+		_condition.wakeAll();
+	}
+	_started++;
+
+	return RequestStatus::NoError;
+}
+
+bool FileTransfers::CancelTransfer(uint32_t transferId)
+{
+	QMutexLocker locker(&_mutex);
+	for (auto &transfer : _transfers) {
+		if (transfer->Id != transferId)
+			continue;
+		transfer->Cancelled = true;
+		_condition.wakeAll();
+		return true;
+	}
+	return false;
+}
+
+QJsonArray FileTransfers::GetTransfers()
+{
+	QMutexLocker locker(&_mutex);
+	QJsonArray ret;
+	for (auto &transfer : _transfers)
+		ret.append(TransferToJson(*transfer));
+	return ret;
+}
+
+void FileTransfers::SetSettings(const FileTransferSettings &settings)
+{
+	QMutexLocker locker(&_mutex);
+	_settings = settings;
+	_condition.wakeAll();
+}
+
+FileTransferSettings FileTransfers::GetSettings()
+{
+	QMutexLocker locker(&_mutex);
+	return _settings;
+}
+
+QJsonObject FileTransfers::GetStats()
+{
+	QJsonObject ret;
+	{
+		QMutexLocker locker(&_mutex);
+		ret["activeTransfers"] = (int)_transfers.size();
+	}
+	ret["startedTransfers"] = (double)_started;
+	ret["completedTransfers"] = (double)_completed;
+	ret["abortedTransfers"] = (double)_aborted;
+	ret["bytesSent"] = (double)_bytesSent;
+	ret["flowControlWaits"] = (double)_flowControlWaits;
+	ret["bandwidthWaits"] = (double)_bandwidthWaits;
+	return ret;
+}
+
+void FileTransfers::_TransferLoop()
+{
+	size_t next = 0;
+	QMutexLocker locker(&_mutex);
+	while (_running) {
+		if (_transfers.empty()) {
+			_condition.wait(&_mutex);
+			continue;
+		}
+
+		auto websocketManager = GetWebsocketManager();
+		if (websocketManager && websocketManager->GetOutgoingBytes() >= TRANSFER_WINDOW) {
+			_flowControlWaits++;
+			// Woken by the socket thread as it drains, so cancels and new transfers are not held up by `_mutex`
+			locker.unlock();
+			websocketManager->WaitForOutgoingBytesBelow(TRANSFER_WINDOW, FLOW_CONTROL_TIMEOUT);
+			locker.relock();
+			continue;
+		}
+
+		double bytesPerSecond = (double)_settings.MaxBandwidth * 1000.0 / 8.0;
+		if (bytesPerSecond > 0.0) {
+			uint64_t now = os_gettime_ns();
+			double refill = _tokensUpdatedAt ? (double)(now - _tokensUpdatedAt) / 1000000000.0 * bytesPerSecond : 0.0;
+			_tokens = std::min(_tokens + refill, bytesPerSecond * BANDWIDTH_BURST);
+			_tokensUpdatedAt = now;
+			if (_tokens < 0.0) {
+				_bandwidthWaits++;
+				_condition.wait(&_mutex, (unsigned long)(-_tokens / bytesPerSecond * 1000.0) + 1);
+				continue;
+			}
+		}
+
+		// Every transfer gets one chunk in turn, so a large file does not hold back the others
+		next %= _transfers.size();
+		TransferPtr transfer = _transfers[next++];
+
+		locker.unlock();
+		bool pending;
+		uint64_t sentBytes = 0;
+		if (transfer->Cancelled) {
+			_SendAbort(*transfer);
+			pending = false;
+		} else {
+			pending = _SendChunk(*transfer, sentBytes);
+		}
+		locker.relock();
+
+		if (bytesPerSecond > 0.0)
+			_tokens -= (double)sentBytes;
+
+		if (!pending)
+			_Remove(transfer);
+	}
+}
+
+bool FileTransfers::_SendChunk(Transfer &transfer, uint64_t &sentBytes)
+{
+	uint64_t offset = transfer.Offset;
+	uint64_t length = std::min<uint64_t>((uint64_t)transfer.ChunkSize, transfer.EndOffset - offset);
+	bool last = offset + length >= transfer.EndOffset;
+
+	QByteArray frame(BinaryFrameHeaderSize + CHUNK_HEADER_SIZE + (int)length, Qt::Uninitialized);
+	uchar *data = (uchar*)frame.data();
+	WriteBinaryFrameHeader(data, BinaryFrameType::FileChunk, transfer.ChannelId, transfer.Id);
+	qToLittleEndian<quint64>(offset, data + BinaryFrameHeaderSize);
+	qToLittleEndian<quint64>(transfer.FileSize, data + BinaryFrameHeaderSize + 8);
+	data[BinaryFrameHeaderSize + 16] = last ? CHUNK_FLAG_LAST : 0;
+	uchar *chunk = data + BinaryFrameHeaderSize + CHUNK_HEADER_SIZE;
+
+	if (length) {
+		// Move the window once the chunk leaves it
+		if (!transfer.Map || offset < transfer.MapOffset || offset + length > transfer.MapOffset + transfer.MapSize) {
+			if (transfer.Map)
+				transfer.File.unmap(transfer.Map);
+			transfer.MapOffset = offset;
+			transfer.MapSize = std::min<uint64_t>(MAP_WINDOW_SIZE, transfer.EndOffset - offset);
+			transfer.Map = transfer.File.map((qint64)transfer.MapOffset, (qint64)transfer.MapSize);
+		}
+
+		if (transfer.Map) {
+			memcpy(chunk, transfer.Map + (offset - transfer.MapOffset), (size_t)length);
+		} else if (!transfer.File.seek((qint64)offset) || transfer.File.read((char*)chunk, (qint64)length) != (qint64)length) {
+			// Only reached on file systems that do not support mapping
+			blog(LOG_WARNING, "[FileTransfers::_SendChunk] Reading `%s` failed: %s", QT_TO_UTF8(transfer.Path), QT_TO_UTF8(transfer.File.errorString()));
+			_SendAbort(transfer);
+			return false;
+		}
+	}
+
+	auto websocketManager = GetWebsocketManager();
+	if (!websocketManager || !websocketManager->SendSessionBinary(transfer.ChannelId, frame)) {
+		// The session went away. The client resumes from the last offset it received.
+		_aborted++;
+		return false;
+	}
+
+	transfer.Offset = offset + length;
+	sentBytes = length;
+	_bytesSent += length;
+
+	if (last) {
+		_completed++;
+#ifdef DEBUG_MODE
+		blog(LOG_INFO, "[FileTransfers::_SendChunk] Transfer %u of `%s` completed.", transfer.Id, QT_TO_UTF8(transfer.Path));
+#endif
+		return false;
+	}
+	return true;
+}
+
+void FileTransfers::_SendAbort(Transfer &transfer)
+{
+	QByteArray frame(BinaryFrameHeaderSize + CHUNK_HEADER_SIZE, Qt::Uninitialized);
+	uchar *data = (uchar*)frame.data();
+	WriteBinaryFrameHeader(data, BinaryFrameType::FileChunk, transfer.ChannelId, transfer.Id);
+	qToLittleEndian<quint64>(transfer.Offset, data + BinaryFrameHeaderSize);
+	qToLittleEndian<quint64>(transfer.FileSize, data + BinaryFrameHeaderSize + 8);
+	data[BinaryFrameHeaderSize + 16] = CHUNK_FLAG_ABORTED;
+
+	auto websocketManager = GetWebsocketManager();
+	if (websocketManager)
+		websocketManager->SendSessionBinary(transfer.ChannelId, frame);
+	_aborted++;
+}
+
+void FileTransfers::_Remove(const TransferPtr &transfer)
+{
+	_transfers.erase(std::remove(_transfers.begin(), _transfers.end(), transfer), _transfers.end());
+	if (transfer->Map) {
+		transfer->File.unmap(transfer->Map);
+		transfer->Map = nullptr;
+	}
+}
+
+QJsonObject FileTransfers::TransferToJson(const Transfer &transfer)
+{
+	QJsonObject ret;
+	ret["transferId"] = (double)transfer.Id;
+	ret["filePath"] = transfer.Path;
+	ret["fileSize"] = (double)transfer.FileSize;
+	ret["startOffset"] = (double)transfer.StartOffset;
+	ret["endOffset"] = (double)transfer.EndOffset;
+	ret["offset"] = (double)transfer.Offset;
+	ret["chunkSize"] = transfer.ChunkSize;
+	ret["duration"] = (double)((os_gettime_ns() - transfer.StartedAt) / 1000000);
+	return ret;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QWaitCondition>
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include "rpc/Request.h"
+#include "plugin-main.h"
+
+struct FileTransferSettings {
+	// Kilobits per second shared by all transfers. 0 leaves transfers limited by the socket only.
+	int MaxBandwidth = 0;
+};
+
+// Sends files to a single session as `FileChunk` binary frames. Chunks are copied straight from a memory mapped
+// window of the file into the outgoing frame. Transfers are served round-robin by one thread, which only queues a
+// chunk while the socket's backlog is below `TRANSFER_WINDOW`, so replies and events are never stuck behind a file.
+// A transfer that was aborted (Eg. by a disconnect) is resumed by starting a new one at the last received offset.
+// The first chunks may arrive before the response to the request that started the transfer. The optional bandwidth
+// cap is a token bucket over all transfers, so uploads can be kept clear of the bandwidth the live stream needs.
+class FileTransfers {
+	public:
+		static const int DefaultChunkSize = 256 * 1024;
+
+		FileTransfers();
+		~FileTransfers();
+
+		// Starts sending `length` bytes of `path` from `offset` to the session on `channelId`. A `length` of 0 sends the
+		// rest of the file. On success, `transferJson` describes the transfer.
+		RequestStatus StartTransfer(uint16_t channelId, const QString &path, uint64_t offset, uint64_t length, int chunkSize, QJsonObject &transferJson, QString &comment);
+		// Returns false if no transfer with that id is running
+		bool CancelTransfer(uint32_t transferId);
+
+		QJsonArray GetTransfers();
+
+		void SetSettings(const FileTransferSettings &settings);
+		FileTransferSettings GetSettings();
+
+		QJsonObject GetStats();
+
+	private:
+		struct Transfer {
+			uint32_t Id = 0;
+			uint16_t ChannelId = 0;
+			QString Path;
+			QFile File;
+			uint64_t FileSize = 0;
+			uint64_t StartOffset = 0;
+			// Offset the transfer ends at, at most `FileSize`
+			uint64_t EndOffset = 0;
+			// Offset of the next chunk
+			std::atomic<uint64_t> Offset{0};
+			int ChunkSize = DefaultChunkSize;
+			uint64_t StartedAt = 0;
+			std::atomic<bool> Cancelled{false};
+
+			// Current mapped window of the file
+			uchar *Map = nullptr;
+			uint64_t MapOffset = 0;
+			uint64_t MapSize = 0;
+		};
+		typedef std::shared_ptr<Transfer> TransferPtr;
+
+		void _TransferLoop();
+		// Returns false once the transfer is over, either completed or aborted. `sentBytes` is the size of the chunk sent.
+		bool _SendChunk(Transfer &transfer, uint64_t &sentBytes);
+		void _SendAbort(Transfer &transfer);
+		void _Remove(const TransferPtr &transfer);
+		static QJsonObject TransferToJson(const Transfer &transfer);
+
+		QMutex _mutex;
+		QWaitCondition _condition;
+		bool _running;
+		FileTransferSettings _settings;
+		uint32_t _nextId;
+		std::vector<TransferPtr> _transfers;
+		std::thread _transferThread;
+
+		// Bandwidth cap bucket in bytes, only touched by the transfer thread. Negative while paying off the last chunk.
+		double _tokens;
+		uint64_t _tokensUpdatedAt;
+
+		std::atomic<uint64_t> _started;
+		std::atomic<uint64_t> _completed;
+		std::atomic<uint64_t> _aborted;
+		std::atomic<uint64_t> _bytesSent;
+		std::atomic<uint64_t> _flowControlWaits;
+		std::atomic<uint64_t> _bandwidthWaits;
+};
+
+typedef std::shared_ptr<FileTransfers> FileTransfersPtr;
@@ -0,0 +1,74 @@
+#include <util/platform.h>
+
+#include "RequestCoalescer.h"
+
+RequestCoalescer::RequestCoalescer() :
+	_executed(0),
+	_coalesced(0),
+	_maxWaiters(0)
+{
+}
+
+RequestResult RequestCoalescer::Run(const QString &key, const Request &request, std::function<RequestResult()> handler)
+{
+	QMutexLocker locker(&_mutex);
+
+	auto it = _executions.find(key);
+	// An execution that started before the request arrived may have read state the request must see changed
+	if (it != _executions.end() && (*it)->StartedAt >= request.ReceivedAt()) {
+		ExecutionPtr execution = *it;
+		execution->Waiters++;
+		_coalesced++;
+		_coalescedByType[request.RequestType()]++;
+
+		uint64_t maxWaiters = _maxWaiters.load();
+		while (execution->Waiters > maxWaiters && !_maxWaiters.compare_exchange_weak(maxWaiters, execution->Waiters));
+
+		while (!execution->Done)
+			_condition.wait(&_mutex);
+
+		if (execution->Status == RequestStatus::Success)
+			return RequestResult::BuildSuccess(request, execution->AdditionalFields, execution->SerializedFields);
+		return RequestResult::BuildFailure(request, execution->Status, execution->Comment);
+	}
+
+	ExecutionPtr execution = std::make_shared<Execution>();
+	execution->StartedAt = os_gettime_ns();
+	// Replaces an older execution of the same key, which keeps running for the requests that joined it
+	_executions.insert(key, execution);
+	locker.unlock();
+
+	RequestResult result = handler();
+
+	locker.relock();
+	execution->Status = result.StatusCode();
+	execution->Comment = result.Comment();
+	execution->AdditionalFields = result.AdditionalFields();
+	execution->SerializedFields = result.SerializedFields();
+	execution->Done = true;
+	it = _executions.find(key);
+	if (it != _executions.end() && *it == execution)
+		_executions.erase(it);
+	_executed++;
+	// Waiters hold their own reference to the execution, so it outlives its removal from the map
+	if (execution->Waiters)
+		_condition.wakeAll();
+
+	return result;
+}
+
+QJsonObject RequestCoalescer::GetStats()
+{
+	QJsonObject ret;
+	ret["executedRequests"] = (double)_executed;
+	ret["coalescedRequests"] = (double)_coalesced;
+	ret["maxWaiters"] = (double)_maxWaiters;
+
+	QMutexLocker locker(&_mutex);
+	ret["inFlight"] = _executions.size();
+	QJsonObject coalescedByType;
+	for (auto it = _coalescedByType.constBegin(); it != _coalescedByType.constEnd(); ++it)
+		coalescedByType[it.key()] = (double)it.value();
+	ret["coalescedByType"] = coalescedByType;
+	return ret;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QWaitCondition>
+#include <QJsonObject>
+
+#include "rpc/Request.h"
+
+// Lets identical read-only requests share an execution. A request only joins an execution of its key that started
+// after the request was received, so the result it gets reflects state at least as new as its own arrival. It then
+// waits for that result and gets a copy carrying its own `requestId`. Otherwise it runs the handler itself, and later
+// arrivals join the newer execution. Results are never kept once the execution finished.
+class RequestCoalescer {
+	public:
+		RequestCoalescer();
+
+		// `key` must cover everything the result depends on (Eg. the request type and its normalized `requestData`)
+		RequestResult Run(const QString &key, const Request &request, std::function<RequestResult()> handler);
+
+		QJsonObject GetStats();
+
+	private:
+		struct Execution {
+			// `os_gettime_ns()` right before the handler was called
+			uint64_t StartedAt = 0;
+			bool Done = false;
+			RequestStatus Status = RequestStatus::Unknown;
+			QString Comment;
+			QJsonObject AdditionalFields;
+			QByteArray SerializedFields;
+			uint64_t Waiters = 0;
+		};
+		typedef std::shared_ptr<Execution> ExecutionPtr;
+
+		QMutex _mutex;
+		QWaitCondition _condition;
+		QHash<QString, ExecutionPtr> _executions;
+		// Requests served from another execution, per request type
+		QHash<QString, uint64_t> _coalescedByType;
+
+		std::atomic<uint64_t> _executed;
+		std::atomic<uint64_t> _coalesced;
+		std::atomic<uint64_t> _maxWaiters;
+};
@@ -1,202 +1,393 @@
-#include <inttypes.h>
-#include "RequestHandler.h"
-
-const QHash<QString, MethodHandler> RequestHandler::RequestHandlerMap
-{
-	// General
-	{ "GetVersion", &RequestHandler::GetVersion },
-	{ "Sleep", &RequestHandler::Sleep },
-	{ "CacheUpdate", &RequestHandler::CacheUpdate },
-	{ "LogDump", &RequestHandler::LogDump },
-
-	// Config
-	{ "GetSceneCollectionList", &RequestHandler::GetSceneCollectionList },
-	{ "SetCurrentSceneCollection", &RequestHandler::SetCurrentSceneCollection },
-	{ "GetProfileList", &RequestHandler::GetProfileList },
-	{ "SetCurrentProfile", &RequestHandler::SetCurrentProfile },
-	{ "GetVideoSettings", &RequestHandler::GetVideoSettings },
-#ifdef IRLTK_CLOUD
-	{ "SetVideoSettings", &RequestHandler::SetVideoSettings },
-#endif
-
-	// Scenes
-	{ "SetCurrentProgramScene", &RequestHandler::SetCurrentProgramScene },
-
-	// Stream
-	{ "GetStreamStatus", &RequestHandler::GetStreamStatus },
-	{ "StartStream", &RequestHandler::StartStream },
-	{ "StopStream", &RequestHandler::StopStream },
-	{ "GetStreamServiceSettings", &RequestHandler::GetStreamServiceSettings },
-	{ "SetStreamServiceSettings", &RequestHandler::SetStreamServiceSettings },
-
-	// Record
-	{ "GetRecordStatus", &RequestHandler::GetRecordStatus },
-	{ "StartRecord", &RequestHandler::StartRecord },
-	{ "StopRecord", &RequestHandler::StopRecord },
-};
-
-RequestHandler::RequestHandler()
-{
-}
-
-RequestResult RequestHandler::ProcessIncomingMessage(QJsonObject parsedMessage)
-{
-	RequestStatus errorCode = RequestStatus::NoError;
-	QString requestType = parsedMessage["requestType"].toString();
-    QString requestId;
-	if (parsedMessage.contains("requestId"))
-		requestId = parsedMessage["requestId"].toString();
-
-	QJsonObject requestData;
-	if (parsedMessage.contains("requestData")) {
-		if (parsedMessage["requestData"].isObject())
-			requestData = parsedMessage["requestData"].toObject();
-		else
-			errorCode = RequestStatus::InvalidRequestParameterDataType;
-	}
-
-	Request request(requestType, requestId, requestData);
-	if (errorCode != RequestStatus::NoError)
-		return RequestResult::BuildFailure(request, errorCode);
-
-	MethodHandler handler = RequestHandlerMap[requestType];
-	if (!handler)
-		return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestType);
-
-	return std::bind(handler, this, std::placeholders::_1)(request);
-}
-
-QJsonObject RequestHandler::GetResultJson(const RequestResult requestResult)
-{
-	QJsonObject result;
-
-	result["requestType"] = requestResult.RequestType();
-	result["requestId"] = requestResult.requestId();
-
-	QJsonObject status;
-	status["code"] = requestResult.StatusCode();
-	if (requestResult.StatusCode() == RequestStatus::Success) {
-		status["result"] = true;
-		QJsonObject additionalFields = requestResult.AdditionalFields();
-		if (!additionalFields.empty())
-			result["responseData"] = additionalFields;
-	} else {
-		result["result"] = false;
-		QString comment = requestResult.Comment();
-		if (!comment.isEmpty() && !comment.isNull())
-			status["comment"] = comment;
-	}
-	result["requestStatus"] = status;
-
-	return result;
-}
-
-//============================================ UTILS BELOW ============================================
-
-QString RequestHandler::UtilsGetObsVersion()
-{
-	uint32_t version = obs_get_version();
-
-	uint8_t major, minor, patch;
-	major = (version >> 24) & 0xFF;
-	minor = (version >> 16) & 0xFF;
-	patch = version & 0xFF;
-
-	QString result = QString("%1.%2.%3")
-		.arg(major).arg(minor).arg(patch);
-
-	return result;
-}
-
-QJsonObject RequestHandler::UtilsObsDataToQt(obs_data_t *data) // Simple and dirty way to convert obs_data_t to QJsonObject
-{
-	QJsonObject returnJson;
-	if (!data)
-		return returnJson;
-
-	const char* jsonText = obs_data_get_json(data);
-	return QJsonDocument::fromJson(jsonText).object();
-}
-
-obs_data_t *RequestHandler::UtilsQtToObsData(QJsonObject data)
-{
-	QString resultText = QJsonDocument(data).toJson();
-	return obs_data_create_from_json(QT_TO_UTF8(resultText));
-}
-
-QString RequestHandler::UtilsGetOutputTimecode(obs_output_t *output)
-{
-	if (!output || !obs_output_active(output))
-		return "00:00:00.000";
-
-	video_t* video = obs_output_video(output);
-	uint64_t frameTimeNs = video_output_get_frame_time(video);
-	int totalFrames = obs_output_get_total_frames(output);
-
-	uint64_t ms = (((uint64_t)totalFrames) * frameTimeNs) / 1000000ULL;
-	uint64_t secs = ms / 1000ULL;
-	uint64_t minutes = secs / 60ULL;
-
-	uint64_t hoursPart = minutes / 60ULL;
-	uint64_t minutesPart = minutes % 60ULL;
-	uint64_t secsPart = secs % 60ULL;
-	uint64_t msPart = ms % 1000ULL;
-
-	return QString::asprintf("%02" PRIu64 ":%02" PRIu64 ":%02" PRIu64 ".%03" PRIu64, hoursPart, minutesPart, secsPart, msPart);
-}
-
-uint64_t RequestHandler::UtilsGetOutputDuration(obs_output_t *output)
-{
-	if (!output || !obs_output_active(output))
-		return 0;
-
-	video_t* video = obs_output_video(output);
-	uint64_t frameTimeNs = video_output_get_frame_time(video);
-	int totalFrames = obs_output_get_total_frames(output);
-
-	return (((uint64_t)totalFrames) * frameTimeNs) / 1000000ULL;
-}
-
-QString RequestHandler::UtilsGetSourceMediaState(obs_source_t *source)
-{
-	enum obs_media_state mstate = obs_source_media_get_state(source);
-	switch (mstate) {
-		case OBS_MEDIA_STATE_NONE:
-			return QString("none");
-		case OBS_MEDIA_STATE_PLAYING:
-			return QString("playing");
-		case OBS_MEDIA_STATE_OPENING:
-			return QString("opening");
-		case OBS_MEDIA_STATE_BUFFERING:
-			return QString("buffering");
-		case OBS_MEDIA_STATE_PAUSED:
-			return QString("paused");
-		case OBS_MEDIA_STATE_STOPPED:
-			return QString("stopped");
-		case OBS_MEDIA_STATE_ENDED:
-			return QString("ended");
-		case OBS_MEDIA_STATE_ERROR:
-			return QString("error");
-		default:
-			return QString("unknown");
-	}
-}
-
-QJsonArray RequestHandler::UtilsStringListToQt(char **list)
-{
-	QJsonArray result;
-	if (!list)
-		return result;
-
-	size_t index = 0;
-	char* value = nullptr;
-	do {
-		value = list[index];
-		if (value) {
-			result.append(QString(value));
-		}
-		index++;
-	} while (value != nullptr);
-
-	return result;
+#include <inttypes.h>
+#include "RequestHandler.h"
+#include "WebsocketManager.h"
+#include "ResponseCache.h"
+
+const QHash<QString, MethodHandler> RequestHandler::RequestHandlerMap
+{
+	// General
+	{ "GetVersion", &RequestHandler::GetVersion },
+	{ "Sleep", &RequestHandler::Sleep },
+	{ "CacheUpdate", &RequestHandler::CacheUpdate },
+	{ "LogDump", &RequestHandler::LogDump },
+	{ "GetStats", &RequestHandler::GetStats },
+
+	// Config
+	{ "GetSceneCollectionList", &RequestHandler::GetSceneCollectionList },
+	{ "SetCurrentSceneCollection", &RequestHandler::SetCurrentSceneCollection },
+	{ "GetProfileList", &RequestHandler::GetProfileList },
+	{ "SetCurrentProfile", &RequestHandler::SetCurrentProfile },
+	{ "GetVideoSettings", &RequestHandler::GetVideoSettings },
+#ifdef IRLTK_CLOUD
+	{ "SetVideoSettings", &RequestHandler::SetVideoSettings },
+#endif
+
+	// Scenes
+	{ "SetCurrentProgramScene", &RequestHandler::SetCurrentProgramScene },
+
+	// Scene Items
+	{ "GetSceneItemList", &RequestHandler::GetSceneItemList },
+	{ "SetSceneItemTransforms", &RequestHandler::SetSceneItemTransforms },
+
+	// Sources
+	{ "GetSourceList", &RequestHandler::GetSourceList },
+
+	// Inputs
+	{ "GetInputList", &RequestHandler::GetInputList },
+	{ "SetInputAudioSettings", &RequestHandler::SetInputAudioSettings },
+
+	// Media Inputs
+	{ "GetMediaInputStatus", &RequestHandler::GetMediaInputStatus },
+	{ "GetMediaInputStatuses", &RequestHandler::GetMediaInputStatuses },
+	{ "TriggerMediaInputAction", &RequestHandler::TriggerMediaInputAction },
+	{ "SetMediaInputCursor", &RequestHandler::SetMediaInputCursor },
+	{ "OffsetMediaInputCursor", &RequestHandler::OffsetMediaInputCursor },
+
+	// Transitions
+	{ "GetSceneTransitionList", &RequestHandler::GetSceneTransitionList },
+	{ "SetCurrentSceneTransition", &RequestHandler::SetCurrentSceneTransition },
+	{ "SetCurrentSceneTransitionDuration", &RequestHandler::SetCurrentSceneTransitionDuration },
+	{ "GetSceneSwitchHistory", &RequestHandler::GetSceneSwitchHistory },
+
+	// Filters
+	{ "GetSourceFilterList", &RequestHandler::GetSourceFilterList },
+	{ "CreateSourceFilter", &RequestHandler::CreateSourceFilter },
+	{ "RemoveSourceFilter", &RequestHandler::RemoveSourceFilter },
+	{ "SetSourceFilterIndex", &RequestHandler::SetSourceFilterIndex },
+	{ "SetSourceFilterEnabled", &RequestHandler::SetSourceFilterEnabled },
+	{ "SetSourceFilterSettings", &RequestHandler::SetSourceFilterSettings },
+
+	// Outputs
+	{ "GetSimulcastOutputList", &RequestHandler::GetSimulcastOutputList },
+	{ "CreateSimulcastOutput", &RequestHandler::CreateSimulcastOutput },
+	{ "RemoveSimulcastOutput", &RequestHandler::RemoveSimulcastOutput },
+	{ "StartSimulcastOutput", &RequestHandler::StartSimulcastOutput },
+	{ "StopSimulcastOutput", &RequestHandler::StopSimulcastOutput },
+
+	// Stream
+	{ "GetStreamStatus", &RequestHandler::GetStreamStatus },
+	{ "StartStream", &RequestHandler::StartStream },
+	{ "StopStream", &RequestHandler::StopStream },
+	{ "GetStreamStartHistory", &RequestHandler::GetStreamStartHistory },
+	{ "GetStreamServiceSettings", &RequestHandler::GetStreamServiceSettings },
+	{ "SetStreamServiceSettings", &RequestHandler::SetStreamServiceSettings },
+
+	// Record
+	{ "GetRecordStatus", &RequestHandler::GetRecordStatus },
+	{ "StartRecord", &RequestHandler::StartRecord },
+	{ "StopRecord", &RequestHandler::StopRecord },
+	{ "GetRecordingList", &RequestHandler::GetRecordingList },
+	{ "TransferRecording", &RequestHandler::TransferRecording },
+
+	// Replay Buffer
+	{ "GetReplayBufferStatus", &RequestHandler::GetReplayBufferStatus },
+	{ "StartReplayBuffer", &RequestHandler::StartReplayBuffer },
+	{ "StopReplayBuffer", &RequestHandler::StopReplayBuffer },
+	{ "SaveReplayBuffer", &RequestHandler::SaveReplayBuffer },
+	{ "GetLastReplayBufferReplay", &RequestHandler::GetLastReplayBufferReplay },
+	{ "TransferLastReplayBufferReplay", &RequestHandler::TransferLastReplayBufferReplay },
+
+	// Transfers
+	{ "GetFileTransferList", &RequestHandler::GetFileTransferList },
+	{ "CancelFileTransfer", &RequestHandler::CancelFileTransfer },
+	{ "GetFileTransferSettings", &RequestHandler::GetFileTransferSettings },
+	{ "SetFileTransferSettings", &RequestHandler::SetFileTransferSettings },
+
+	// Monitoring
+	{ "GetProgramThumbnailSettings", &RequestHandler::GetProgramThumbnailSettings },
+	{ "SetProgramThumbnailSettings", &RequestHandler::SetProgramThumbnailSettings },
+	{ "GetProgramThumbnail", &RequestHandler::GetProgramThumbnail },
+	{ "GetAudioMeterSettings", &RequestHandler::GetAudioMeterSettings },
+	{ "SetAudioMeterSettings", &RequestHandler::SetAudioMeterSettings },
+	{ "GetAudioLevels", &RequestHandler::GetAudioLevels },
+	{ "GetIngestHealthSettings", &RequestHandler::GetIngestHealthSettings },
+	{ "SetIngestHealthSettings", &RequestHandler::SetIngestHealthSettings },
+	{ "GetIngestHealth", &RequestHandler::GetIngestHealth },
+	{ "GetOutputStatsSettings", &RequestHandler::GetOutputStatsSettings },
+	{ "SetOutputStatsSettings", &RequestHandler::SetOutputStatsSettings },
+
+	// Automation
+	{ "GetAutoSceneSwitchRules", &RequestHandler::GetAutoSceneSwitchRules },
+	{ "SetAutoSceneSwitchRules", &RequestHandler::SetAutoSceneSwitchRules },
+	{ "GetIngestWatchdogs", &RequestHandler::GetIngestWatchdogs },
+	{ "SetIngestWatchdog", &RequestHandler::SetIngestWatchdog },
+	{ "RemoveIngestWatchdog", &RequestHandler::RemoveIngestWatchdog },
+	{ "GetBitrateControllerStatus", &RequestHandler::GetBitrateControllerStatus },
+	{ "SetBitrateControllerSettings", &RequestHandler::SetBitrateControllerSettings },
+};
+
+const QSet<QString> RequestHandler::CoalescedRequests
+{
+	"GetVersion",
+	"CacheUpdate",
+	"GetStats",
+	"GetSceneCollectionList",
+	"GetProfileList",
+	"GetVideoSettings",
+	"GetSceneItemList",
+	"GetSourceList",
+	"GetInputList",
+	"GetMediaInputStatus",
+	"GetMediaInputStatuses",
+	"GetSceneTransitionList",
+	"GetSourceFilterList",
+	"GetStreamStatus",
+	"GetRecordStatus",
+	"GetRecordingList",
+	"GetReplayBufferStatus",
+	"GetAudioLevels",
+	"GetIngestHealth",
+	"GetBitrateControllerStatus",
+};
+
+const QHash<QString, uint32_t> RequestHandler::CachedRequests
+{
+	{ "GetVersion", ResponseCacheDependency::None },
+	{ "GetSceneCollectionList", ResponseCacheDependency::SceneCollection | ResponseCacheDependency::SceneCollectionList },
+	{ "GetProfileList", ResponseCacheDependency::Profile | ResponseCacheDependency::ProfileList },
+	{ "GetVideoSettings", ResponseCacheDependency::Profile | ResponseCacheDependency::Video },
+};
+
+RequestHandler::RequestHandler()
+{
+}
+
+RequestResult RequestHandler::ProcessIncomingMessage(QJsonObject parsedMessage, uint64_t receivedAt, uint16_t channelId)
+{
+	RequestStatus errorCode = RequestStatus::NoError;
+	QString requestType = parsedMessage["requestType"].toString();
+    QString requestId;
+	if (parsedMessage.contains("requestId"))
+		requestId = parsedMessage["requestId"].toString();
+
+	QJsonObject requestData;
+	if (parsedMessage.contains("requestData")) {
+		if (parsedMessage["requestData"].isObject())
+			requestData = parsedMessage["requestData"].toObject();
+		else
+			errorCode = RequestStatus::InvalidRequestParameterDataType;
+	}
+
+	Request request(requestType, requestId, requestData, receivedAt, channelId);
+	if (errorCode != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, errorCode);
+
+	MethodHandler handler = RequestHandlerMap[requestType];
+	if (!handler)
+		return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestType);
+
+	std::function<RequestResult()> execute = [&]() {
+		return std::bind(handler, this, std::placeholders::_1)(request);
+	};
+
+	auto websocketManager = GetWebsocketManager();
+	if (websocketManager && CoalescedRequests.contains(requestType)) {
+		// Object keys are serialized in sorted order, so equal request data always gives the same key
+		QString key = requestType + '\n' + QJsonDocument(request.RequestData()).toJson(QJsonDocument::Compact);
+		std::function<RequestResult()> handle = execute;
+		execute = [=, &request]() {
+			return websocketManager->GetRequestCoalescer()->Run(key, request, handle);
+		};
+	}
+
+	// A miss still goes through the coalescer, so a burst after an invalidation runs the handler once
+	auto responseCache = GetResponseCache();
+	if (responseCache && CachedRequests.contains(requestType))
+		return responseCache->Get(requestType, CachedRequests[requestType], request, execute);
+
+	return execute();
+}
+
+RequestResult RequestHandler::BuildRateLimitedResult(QJsonObject parsedMessage)
+{
+	QString requestType = parsedMessage["requestType"].toString();
+	QString requestId;
+	if (parsedMessage.contains("requestId"))
+		requestId = parsedMessage["requestId"].toString();
+
+	Request request(requestType, requestId, QJsonObject());
+	return RequestResult::BuildFailure(request, RequestStatus::RateLimited, "The session request rate limit was exceeded.");
+}
+
+QJsonObject RequestHandler::GetResultJson(const RequestResult requestResult)
+{
+	QJsonObject result;
+
+	result["requestType"] = requestResult.RequestType();
+	result["requestId"] = requestResult.requestId();
+
+	QJsonObject status;
+	status["code"] = requestResult.StatusCode();
+	if (requestResult.StatusCode() == RequestStatus::Success) {
+		status["result"] = true;
+		QJsonObject additionalFields = requestResult.AdditionalFields();
+		if (!additionalFields.empty())
+			result["responseData"] = additionalFields;
+	} else {
+		result["result"] = false;
+		QString comment = requestResult.Comment();
+		if (!comment.isEmpty() && !comment.isNull())
+			status["comment"] = comment;
+	}
+	result["requestStatus"] = status;
+
+	return result;
+}
+
+//============================================ UTILS BELOW ============================================
+
+QString RequestHandler::UtilsGetObsVersion()
+{
+	uint32_t version = obs_get_version();
+
+	uint8_t major, minor, patch;
+	major = (version >> 24) & 0xFF;
+	minor = (version >> 16) & 0xFF;
+	patch = version & 0xFF;
+
+	QString result = QString("%1.%2.%3")
+		.arg(major).arg(minor).arg(patch);
+
+	return result;
+}
+
+QJsonObject RequestHandler::UtilsObsDataToQt(obs_data_t *data) // Simple and dirty way to convert obs_data_t to QJsonObject
+{
+	QJsonObject returnJson;
+	if (!data)
+		return returnJson;
+
+	const char* jsonText = obs_data_get_json(data);
+	return QJsonDocument::fromJson(jsonText).object();
+}
+
+obs_data_t *RequestHandler::UtilsQtToObsData(QJsonObject data)
+{
+	QString resultText = QJsonDocument(data).toJson();
+	return obs_data_create_from_json(QT_TO_UTF8(resultText));
+}
+
+QString RequestHandler::UtilsGetOutputTimecode(obs_output_t *output)
+{
+	if (!output || !obs_output_active(output))
+		return "00:00:00.000";
+
+	video_t* video = obs_output_video(output);
+	uint64_t frameTimeNs = video_output_get_frame_time(video);
+	int totalFrames = obs_output_get_total_frames(output);
+
+	uint64_t ms = (((uint64_t)totalFrames) * frameTimeNs) / 1000000ULL;
+	uint64_t secs = ms / 1000ULL;
+	uint64_t minutes = secs / 60ULL;
+
+	uint64_t hoursPart = minutes / 60ULL;
+	uint64_t minutesPart = minutes % 60ULL;
+	uint64_t secsPart = secs % 60ULL;
+	uint64_t msPart = ms % 1000ULL;
+
+	return QString::asprintf("%02" PRIu64 ":%02" PRIu64 ":%02" PRIu64 ".%03" PRIu64, hoursPart, minutesPart, secsPart, msPart);
+}
+
+uint64_t RequestHandler::UtilsGetOutputDuration(obs_output_t *output)
+{
+	if (!output || !obs_output_active(output))
+		return 0;
+
+	video_t* video = obs_output_video(output);
+	uint64_t frameTimeNs = video_output_get_frame_time(video);
+	int totalFrames = obs_output_get_total_frames(output);
+
+	return (((uint64_t)totalFrames) * frameTimeNs) / 1000000ULL;
+}
+
+QString RequestHandler::UtilsGetSourceMediaState(obs_source_t *source)
+{
+	enum obs_media_state mstate = obs_source_media_get_state(source);
+	switch (mstate) {
+		case OBS_MEDIA_STATE_NONE:
+			return QString("none");
+		case OBS_MEDIA_STATE_PLAYING:
+			return QString("playing");
+		case OBS_MEDIA_STATE_OPENING:
+			return QString("opening");
+		case OBS_MEDIA_STATE_BUFFERING:
+			return QString("buffering");
+		case OBS_MEDIA_STATE_PAUSED:
+			return QString("paused");
+		case OBS_MEDIA_STATE_STOPPED:
+			return QString("stopped");
+		case OBS_MEDIA_STATE_ENDED:
+			return QString("ended");
+		case OBS_MEDIA_STATE_ERROR:
+			return QString("error");
+		default:
+			return QString("unknown");
+	}
+}
+
+QJsonArray RequestHandler::UtilsStringListToQt(char **list)
+{
+	QJsonArray result;
+	if (!list)
+		return result;
+
+	size_t index = 0;
+	char* value = nullptr;
+	do {
+		value = list[index];
+		if (value) {
+			result.append(QString(value));
+		}
+		index++;
+	} while (value != nullptr);
+
+	return result;
+}
+
+QJsonObject RequestHandler::UtilsGetMediaInputStatus(obs_source_t *input)
+{
+	QJsonObject result;
+	result["inputName"] = obs_source_get_name(input);
+	result["mediaState"] = UtilsGetSourceMediaState(input);
+	// Both are in milliseconds. Live media reports a duration of -1 or 0.
+	result["mediaDuration"] = (double)obs_source_media_get_duration(input);
+	result["mediaCursor"] = (double)obs_source_media_get_time(input);
+
+	return result;
+}
+
+obs_source_t *RequestHandler::UtilsGetTransitionByName(QString transitionName)
+{
+	// Transitions are private sources, so they are only found through the frontend's list
+	QByteArray name = transitionName.toUtf8();
+	obs_source_t *ret = nullptr;
+
+	struct obs_frontend_source_list transitions = {};
+	obs_frontend_get_transitions(&transitions);
+	for (size_t i = 0; i < transitions.sources.num; i++) {
+		obs_source_t *transition = transitions.sources.array[i];
+		if (name == obs_source_get_name(transition)) {
+			obs_source_addref(transition);
+			ret = transition;
+			break;
+		}
+	}
+	obs_frontend_source_list_free(&transitions);
+
+	return ret;
+}
+
+QString RequestHandler::UtilsGetRecordDirectory()
+{
+	config_t *config = obs_frontend_get_profile_config();
+	if (!config)
+		return QString();
+
+	if (QString(config_get_string(config, "Output", "Mode")) == "Advanced") {
+		// Custom FFmpeg output recordings have their own path
+		if (QString(config_get_string(config, "AdvOut", "RecType")) == "FFmpeg")
+			return config_get_string(config, "AdvOut", "FFFilePath");
+		return config_get_string(config, "AdvOut", "RecFilePath");
+	}
+	return config_get_string(config, "SimpleOutput", "FilePath");
 }
\ No newline at end of file
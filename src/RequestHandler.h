@@ -1,64 +1,152 @@
-#pragma once
-
-#include <obs.hpp>
-#include <obs-frontend-api.h>
-#include <obs-data.h>
-#include <util/config-file.h>
-
-#include <QJsonObject>
-#include <QJsonArray>
-#include <QtCore/QString>
-#include <QtCore/QHash>
-
-#include "rpc/Request.h"
-#include "plugin-main.h"
-
-class RequestHandler;
-typedef RequestResult(RequestHandler::*MethodHandler)(const Request&);
-
-class RequestHandler {
-	public:
-		RequestHandler();
-		RequestResult ProcessIncomingMessage(QJsonObject parsedMessage);
-		static QJsonObject GetResultJson(const RequestResult requestResult);
-	private:
-		static const QHash<QString, MethodHandler> RequestHandlerMap;
-		QString UtilsGetObsVersion();
-		QJsonObject UtilsObsDataToQt(obs_data_t *data);
-		obs_data_t *UtilsQtToObsData(QJsonObject data);
-		QString UtilsGetOutputTimecode(obs_output_t *output);
-		uint64_t UtilsGetOutputDuration(obs_output_t *output);
-		QString UtilsGetSourceMediaState(obs_source_t *source);
-		QJsonArray UtilsStringListToQt(char **list);
-
-		// General
-		RequestResult GetVersion(const Request&);
-		RequestResult Sleep(const Request&);
-		RequestResult CacheUpdate(const Request&);
-		RequestResult LogDump(const Request&);
-
-		// Config
-		RequestResult GetProfileList(const Request&);
-		RequestResult SetCurrentProfile(const Request&);
-		RequestResult GetSceneCollectionList(const Request&);
-		RequestResult SetCurrentSceneCollection(const Request&);
-		RequestResult GetVideoSettings(const Request&);
-#ifdef IRLTK_CLOUD // Pending newer OBS version
-		RequestResult SetVideoSettings(const Request&);
-#endif
-
-		// Scenes
-		RequestResult SetCurrentProgramScene(const Request&);
-
-		// Stream
-		RequestResult GetStreamStatus(const Request&);
-		RequestResult StartStream(const Request&);
-		RequestResult StopStream(const Request&);
-		RequestResult GetStreamServiceSettings(const Request&);
-		RequestResult SetStreamServiceSettings(const Request&);
-
-		// Record
-		RequestResult GetRecordStatus(const Request&);
-		RequestResult StartRecord(const Request&);
-		RequestResult StopRecord(const Request&);
+#pragma once
+
+#include <obs.hpp>
+#include <obs-frontend-api.h>
+#include <obs-data.h>
+#include <util/config-file.h>
+
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtCore/QString>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+
+#include "rpc/Request.h"
+#include "plugin-main.h"
+
+class RequestHandler;
+typedef RequestResult(RequestHandler::*MethodHandler)(const Request&);
+
+class RequestHandler {
+	public:
+		RequestHandler();
+		RequestResult ProcessIncomingMessage(QJsonObject parsedMessage, uint64_t receivedAt = 0, uint16_t channelId = 0);
+		RequestResult BuildRateLimitedResult(QJsonObject parsedMessage);
+		static QJsonObject GetResultJson(const RequestResult requestResult);
+	private:
+		static const QHash<QString, MethodHandler> RequestHandlerMap;
+		// Read-only requests whose concurrent identical calls share one execution
+		static const QSet<QString> CoalescedRequests;
+		// Parameterless requests whose results are cached, with the `ResponseCacheDependency` flags that invalidate them
+		static const QHash<QString, uint32_t> CachedRequests;
+		QString UtilsGetObsVersion();
+		QJsonObject UtilsObsDataToQt(obs_data_t *data);
+		obs_data_t *UtilsQtToObsData(QJsonObject data);
+		QString UtilsGetOutputTimecode(obs_output_t *output);
+		uint64_t UtilsGetOutputDuration(obs_output_t *output);
+		QString UtilsGetSourceMediaState(obs_source_t *source);
+		QJsonArray UtilsStringListToQt(char **list);
+		QJsonObject UtilsGetMediaInputStatus(obs_source_t *input);
+		obs_source_t *UtilsGetTransitionByName(QString transitionName);
+		QString UtilsGetRecordDirectory();
+
+		// General
+		RequestResult GetVersion(const Request&);
+		RequestResult Sleep(const Request&);
+		RequestResult CacheUpdate(const Request&);
+		RequestResult LogDump(const Request&);
+		RequestResult GetStats(const Request&);
+
+		// Config
+		RequestResult GetProfileList(const Request&);
+		RequestResult SetCurrentProfile(const Request&);
+		RequestResult GetSceneCollectionList(const Request&);
+		RequestResult SetCurrentSceneCollection(const Request&);
+		RequestResult GetVideoSettings(const Request&);
+#ifdef IRLTK_CLOUD // Pending newer OBS version
+		RequestResult SetVideoSettings(const Request&);
+#endif
+
+		// Scenes
+		RequestResult SetCurrentProgramScene(const Request&);
+
+		// Scene Items
+		RequestResult GetSceneItemList(const Request&);
+		RequestResult SetSceneItemTransforms(const Request&);
+
+		// Sources
+		RequestResult GetSourceList(const Request&);
+
+		// Inputs
+		RequestResult GetInputList(const Request&);
+		RequestResult SetInputAudioSettings(const Request&);
+
+		// Media Inputs
+		RequestResult GetMediaInputStatus(const Request&);
+		RequestResult GetMediaInputStatuses(const Request&);
+		RequestResult TriggerMediaInputAction(const Request&);
+		RequestResult SetMediaInputCursor(const Request&);
+		RequestResult OffsetMediaInputCursor(const Request&);
+
+		// Transitions
+		RequestResult GetSceneTransitionList(const Request&);
+		RequestResult SetCurrentSceneTransition(const Request&);
+		RequestResult SetCurrentSceneTransitionDuration(const Request&);
+		RequestResult GetSceneSwitchHistory(const Request&);
+
+		// Filters
+		RequestResult GetSourceFilterList(const Request&);
+		RequestResult CreateSourceFilter(const Request&);
+		RequestResult RemoveSourceFilter(const Request&);
+		RequestResult SetSourceFilterIndex(const Request&);
+		RequestResult SetSourceFilterEnabled(const Request&);
+		RequestResult SetSourceFilterSettings(const Request&);
+
+		// Outputs
+		RequestResult GetSimulcastOutputList(const Request&);
+		RequestResult CreateSimulcastOutput(const Request&);
+		RequestResult RemoveSimulcastOutput(const Request&);
+		RequestResult StartSimulcastOutput(const Request&);
+		RequestResult StopSimulcastOutput(const Request&);
+
+		// Stream
+		RequestResult GetStreamStatus(const Request&);
+		RequestResult StartStream(const Request&);
+		RequestResult StopStream(const Request&);
+		RequestResult GetStreamStartHistory(const Request&);
+		RequestResult GetStreamServiceSettings(const Request&);
+		RequestResult SetStreamServiceSettings(const Request&);
+
+		// Record
+		RequestResult GetRecordStatus(const Request&);
+		RequestResult StartRecord(const Request&);
+		RequestResult StopRecord(const Request&);
+		RequestResult GetRecordingList(const Request&);
+		RequestResult TransferRecording(const Request&);
+
+		// Replay Buffer
+		RequestResult GetReplayBufferStatus(const Request&);
+		RequestResult StartReplayBuffer(const Request&);
+		RequestResult StopReplayBuffer(const Request&);
+		RequestResult SaveReplayBuffer(const Request&);
+		RequestResult GetLastReplayBufferReplay(const Request&);
+		RequestResult TransferLastReplayBufferReplay(const Request&);
+
+		// Transfers
+		RequestResult GetFileTransferList(const Request&);
+		RequestResult CancelFileTransfer(const Request&);
+		RequestResult GetFileTransferSettings(const Request&);
+		RequestResult SetFileTransferSettings(const Request&);
+
+		// Monitoring
+		RequestResult GetProgramThumbnailSettings(const Request&);
+		RequestResult SetProgramThumbnailSettings(const Request&);
+		RequestResult GetProgramThumbnail(const Request&);
+		RequestResult GetAudioMeterSettings(const Request&);
+		RequestResult SetAudioMeterSettings(const Request&);
+		RequestResult GetAudioLevels(const Request&);
+		RequestResult GetIngestHealthSettings(const Request&);
+		RequestResult SetIngestHealthSettings(const Request&);
+		RequestResult GetIngestHealth(const Request&);
+		RequestResult GetOutputStatsSettings(const Request&);
+		RequestResult SetOutputStatsSettings(const Request&);
+
+		// Automation
+		RequestResult GetAutoSceneSwitchRules(const Request&);
+		RequestResult SetAutoSceneSwitchRules(const Request&);
+		RequestResult GetIngestWatchdogs(const Request&);
+		RequestResult SetIngestWatchdog(const Request&);
+		RequestResult RemoveIngestWatchdog(const Request&);
+		RequestResult GetBitrateControllerStatus(const Request&);
+		RequestResult SetBitrateControllerSettings(const Request&);
 };
\ No newline at end of file
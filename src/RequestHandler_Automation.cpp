@@ -0,0 +1,207 @@
+#include "RequestHandler.h"
+#include "automation/AutoSceneSwitcher.h"
+#include "automation/IngestWatchdog.h"
+#include "automation/BitrateController.h"
+
+RequestResult RequestHandler::GetAutoSceneSwitchRules(const Request& request)
+{
+	auto autoSceneSwitcher = GetAutoSceneSwitcher();
+
+	QJsonObject resultJson;
+	resultJson["enabled"] = autoSceneSwitcher->GetSettings().Enabled;
+	resultJson["rules"] = autoSceneSwitcher->GetRules();
+
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::SetAutoSceneSwitchRules(const Request& request)
+{
+	auto autoSceneSwitcher = GetAutoSceneSwitcher();
+	AutoSceneSwitchSettings settings = autoSceneSwitcher->GetSettings();
+
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+
+	checkStatus = request.ValidateBool("enabled", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.Enabled = request.RequestData()["enabled"].toBool();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	checkStatus = request.ValidateArray("rules", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.Rules.clear();
+		for (auto ruleValue : request.RequestData()["rules"].toArray()) {
+			if (!ruleValue.isObject())
+				return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameterDataType, "Parameter: rules\nAll rules must be objects.");
+			QJsonObject ruleJson = ruleValue.toObject();
+
+			SceneSwitchRule rule;
+			if (!ruleJson["ingestName"].isString() || !ruleJson["liveScene"].isString() || !ruleJson["fallbackScene"].isString())
+				return RequestResult::BuildFailure(request, RequestStatus::MissingRequestParameter, "Parameter: rules\nEvery rule requires the `ingestName`, `liveScene` and `fallbackScene` strings.");
+			rule.IngestName = ruleJson["ingestName"].toString();
+			rule.LiveScene = ruleJson["liveScene"].toString();
+			rule.FallbackScene = ruleJson["fallbackScene"].toString();
+			if (rule.LiveScene == rule.FallbackScene)
+				return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameter, "Parameter: rules\nThe live and fallback scenes of a rule must differ.");
+
+			// A value of the wrong type must not silently fall back to the default (Eg. a string `minBitrate` disabling the check)
+			if (ruleJson.contains("switchOnStall") && !ruleJson["switchOnStall"].isBool())
+				return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameterDataType, "Parameter: rules\n`switchOnStall` must be a boolean.");
+			for (auto fieldName : {"minBitrate", "recoveryBitrate", "triggerDelay", "recoveryDelay"}) {
+				if (ruleJson.contains(fieldName) && !ruleJson[fieldName].isDouble())
+					return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameterDataType, QString("Parameter: rules\n`%1` must be a number.").arg(fieldName));
+			}
+
+			rule.SwitchOnStall = ruleJson["switchOnStall"].toBool(rule.SwitchOnStall);
+			rule.MinBitrate = ruleJson["minBitrate"].toDouble(rule.MinBitrate);
+			rule.RecoveryBitrate = ruleJson["recoveryBitrate"].toDouble(rule.RecoveryBitrate);
+			rule.TriggerDelay = ruleJson["triggerDelay"].toInt(rule.TriggerDelay);
+			rule.RecoveryDelay = ruleJson["recoveryDelay"].toInt(rule.RecoveryDelay);
+			if (rule.MinBitrate < 0 || rule.RecoveryBitrate < 0 || rule.TriggerDelay < 0 || rule.TriggerDelay > 600000 || rule.RecoveryDelay < 0 || rule.RecoveryDelay > 600000)
+				return RequestResult::BuildFailure(request, RequestStatus::RequestParameterOutOfRange, "Parameter: rules\nBitrates must not be negative and delays must be within 0-600000ms.");
+
+			settings.Rules.push_back(rule);
+		}
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	autoSceneSwitcher->SetSettings(settings);
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::GetIngestWatchdogs(const Request& request)
+{
+	QJsonObject resultJson;
+	resultJson["watchdogs"] = GetIngestWatchdog()->GetWatchdogs();
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::SetIngestWatchdog(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = request.ValidateString("sourceName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	QString sourceName = request.RequestData()["sourceName"].toString();
+	IngestWatchdogSettings settings;
+
+	checkStatus = request.ValidateDouble("stallTimeout", &comment, 500, 600000);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.StallTimeout = request.RequestData()["stallTimeout"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+	checkStatus = request.ValidateDouble("initialBackoff", &comment, 0, 600000);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.InitialBackoff = request.RequestData()["initialBackoff"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+	checkStatus = request.ValidateDouble("maxBackoff", &comment, 0, 3600000);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.MaxBackoff = request.RequestData()["maxBackoff"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+	checkStatus = request.ValidateDouble("maxRestarts", &comment, 0, 10000);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.MaxRestarts = request.RequestData()["maxRestarts"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+	checkStatus = request.ValidateDouble("stableDuration", &comment, 0, 3600000);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.StableDuration = request.RequestData()["stableDuration"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	if (settings.MaxBackoff < settings.InitialBackoff)
+		return RequestResult::BuildFailure(request, RequestStatus::RequestParameterOutOfRange, "Parameter: maxBackoff\nThe maximum backoff must not be lower than the initial backoff.");
+
+	GetIngestWatchdog()->SetWatchdog(sourceName, settings);
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::RemoveIngestWatchdog(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = request.ValidateString("sourceName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	if (!GetIngestWatchdog()->RemoveWatchdog(request.RequestData()["sourceName"].toString()))
+		return RequestResult::BuildFailure(request, RequestStatus::SourceNotFound, "No watchdog exists for that source.");
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::GetBitrateControllerStatus(const Request& request)
+{
+	return RequestResult::BuildSuccess(request, GetBitrateController()->GetStatus());
+}
+
+RequestResult RequestHandler::SetBitrateControllerSettings(const Request& request)
+{
+	auto bitrateController = GetBitrateController();
+	BitrateControllerSettings settings = bitrateController->GetSettings();
+
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+
+	checkStatus = request.ValidateBool("enabled", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.Enabled = request.RequestData()["enabled"].toBool();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	struct IntParameter {
+		const char *Name;
+		int *Value;
+		double MinValue;
+		double MaxValue;
+	};
+	IntParameter intParameters[] = {
+		{"minBitrate", &settings.MinBitrate, 100, 500000},
+		{"maxBitrate", &settings.MaxBitrate, 0, 500000},
+		{"decreaseStep", &settings.DecreaseStep, 1, 90},
+		{"increaseStep", &settings.IncreaseStep, 1, 100000},
+		{"decreaseInterval", &settings.DecreaseInterval, 0, 600000},
+		{"increaseInterval", &settings.IncreaseInterval, 0, 600000},
+	};
+	for (auto &parameter : intParameters) {
+		checkStatus = request.ValidateDouble(parameter.Name, &comment, parameter.MinValue, parameter.MaxValue);
+		if (checkStatus == RequestStatus::NoError) {
+			*parameter.Value = request.RequestData()[parameter.Name].toInt();
+		} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+			return RequestResult::BuildFailure(request, checkStatus, comment);
+		}
+	}
+
+	checkStatus = request.ValidateDouble("congestionThreshold", &comment, 0.01, 1);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.CongestionThreshold = request.RequestData()["congestionThreshold"].toDouble();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+	checkStatus = request.ValidateDouble("dropRateThreshold", &comment, 0.0001, 1);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.DropRateThreshold = request.RequestData()["dropRateThreshold"].toDouble();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	if (settings.MaxBitrate > 0 && settings.MaxBitrate < settings.MinBitrate)
+		return RequestResult::BuildFailure(request, RequestStatus::RequestParameterOutOfRange, "Parameter: maxBitrate\nThe maximum bitrate must not be lower than the minimum bitrate.");
+
+	bitrateController->SetSettings(settings);
+
+	return RequestResult::BuildSuccess(request);
+}
@@ -1,4 +1,5 @@
 #include "RequestHandler.h"
+#include "ResponseCache.h"
 
 RequestResult RequestHandler::GetSceneCollectionList(const Request& request)
 {
@@ -178,6 +179,7 @@ RequestResult RequestHandler::SetVideoSettings(const Request& request)
 	if (videoChanged) {
 		config_save_safe(config, "tmp", nullptr);
 		obs_frontend_irltk_reset_video();
+		GetResponseCache()->Invalidate(ResponseCacheDependency::Video);
 	}
 
 	return RequestResult::BuildSuccess(request);
@@ -1 +1,208 @@
+#include <algorithm>
+
 #include "RequestHandler.h"
+#include "media/FilterSettingsCoalescer.h"
+
+// Resolves the `sourceName` and `filterName` parameters
+static RequestStatus ValidateFilter(const Request& request, OBSSourceAutoRelease &source, OBSSourceAutoRelease &filter, QString &comment)
+{
+	RequestStatus checkStatus = request.ValidateString("sourceName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return checkStatus;
+
+	checkStatus = request.ValidateString("filterName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return checkStatus;
+
+	source = obs_get_source_by_name(QT_TO_UTF8(request.RequestData()["sourceName"].toString()));
+	if (!source)
+		return RequestStatus::SourceNotFound;
+
+	filter = obs_source_get_filter_by_name(source, QT_TO_UTF8(request.RequestData()["filterName"].toString()));
+	if (!filter)
+		return RequestStatus::FilterNotFound;
+
+	return RequestStatus::NoError;
+}
+
+RequestResult RequestHandler::GetSourceFilterList(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = request.ValidateString("sourceName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	OBSSourceAutoRelease source = obs_get_source_by_name(QT_TO_UTF8(request.RequestData()["sourceName"].toString()));
+	if (!source)
+		return RequestResult::BuildFailure(request, RequestStatus::SourceNotFound);
+
+	// Filters are enumerated in the order they are shown and applied, starting with the first
+	struct EnumParam {
+		RequestHandler *Handler;
+		QJsonArray Filters;
+	} enumParam = {this, QJsonArray()};
+	obs_source_enum_filters(source, [](obs_source_t *, obs_source_t *filter, void *param) {
+		auto enumParam = static_cast<EnumParam*>(param);
+
+		QJsonObject filterJson;
+		filterJson["filterName"] = obs_source_get_name(filter);
+		filterJson["filterKind"] = obs_source_get_id(filter);
+		filterJson["filterIndex"] = enumParam->Filters.size();
+		filterJson["filterEnabled"] = obs_source_enabled(filter);
+		OBSDataAutoRelease filterSettings = obs_source_get_settings(filter);
+		filterJson["filterSettings"] = enumParam->Handler->UtilsObsDataToQt(filterSettings);
+		enumParam->Filters.append(filterJson);
+	}, &enumParam);
+
+	QJsonObject resultJson;
+	resultJson["filters"] = enumParam.Filters;
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::CreateSourceFilter(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+
+	checkStatus = request.ValidateString("sourceName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	checkStatus = request.ValidateString("filterName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	checkStatus = request.ValidateString("filterKind", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	OBSDataAutoRelease filterSettings;
+	checkStatus = request.ValidateObject("filterSettings", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		filterSettings = UtilsQtToObsData(request.RequestData()["filterSettings"].toObject());
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	OBSSourceAutoRelease source = obs_get_source_by_name(QT_TO_UTF8(request.RequestData()["sourceName"].toString()));
+	if (!source)
+		return RequestResult::BuildFailure(request, RequestStatus::SourceNotFound);
+
+	QString filterName = request.RequestData()["filterName"].toString();
+	OBSSourceAutoRelease existingFilter = obs_source_get_filter_by_name(source, QT_TO_UTF8(filterName));
+	if (existingFilter)
+		return RequestResult::BuildFailure(request, RequestStatus::SourceAlreadyExists, "A filter with that name already exists on the source.");
+
+	QByteArray filterKind = request.RequestData()["filterKind"].toString().toUtf8();
+	bool filterKindExists = false;
+	const char *filterType;
+	for (size_t i = 0; !filterKindExists && obs_enum_filter_types(i, &filterType); i++)
+		filterKindExists = filterKind == filterType;
+	if (!filterKindExists)
+		return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameter, "Parameter: filterKind\nThe filter kind does not exist.");
+
+	OBSSourceAutoRelease filter = obs_source_create(filterKind.constData(), QT_TO_UTF8(filterName), filterSettings, nullptr);
+	if (!filter)
+		return RequestResult::BuildFailure(request, RequestStatus::RequestProcessingFailed, "Creating the filter failed.");
+
+	obs_source_filter_add(source, filter);
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::RemoveSourceFilter(const Request& request)
+{
+	QString comment;
+	OBSSourceAutoRelease source;
+	OBSSourceAutoRelease filter;
+	RequestStatus checkStatus = ValidateFilter(request, source, filter, comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	obs_source_filter_remove(source, filter);
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::SetSourceFilterIndex(const Request& request)
+{
+	QString comment;
+	OBSSourceAutoRelease source;
+	OBSSourceAutoRelease filter;
+	RequestStatus checkStatus = ValidateFilter(request, source, filter, comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	checkStatus = request.ValidateDouble("filterIndex", &comment, 0);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	struct EnumParam {
+		obs_source_t *Filter;
+		int Count;
+		int Index;
+	} enumParam = {filter, 0, -1};
+	obs_source_enum_filters(source, [](obs_source_t *, obs_source_t *filter, void *param) {
+		auto enumParam = static_cast<EnumParam*>(param);
+		if (filter == enumParam->Filter)
+			enumParam->Index = enumParam->Count;
+		enumParam->Count++;
+	}, &enumParam);
+	if (enumParam.Index < 0)
+		return RequestResult::BuildFailure(request, RequestStatus::FilterNotFound);
+
+	// libobs only moves filters one step at a time. Indexes past the end move the filter to the end.
+	int filterIndex = std::min(request.RequestData()["filterIndex"].toInt(), enumParam.Count - 1);
+	for (int i = enumParam.Index; i > filterIndex; i--)
+		obs_source_filter_set_order(source, filter, OBS_ORDER_MOVE_UP);
+	for (int i = enumParam.Index; i < filterIndex; i++)
+		obs_source_filter_set_order(source, filter, OBS_ORDER_MOVE_DOWN);
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::SetSourceFilterEnabled(const Request& request)
+{
+	QString comment;
+	OBSSourceAutoRelease source;
+	OBSSourceAutoRelease filter;
+	RequestStatus checkStatus = ValidateFilter(request, source, filter, comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	checkStatus = request.ValidateBool("filterEnabled", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	obs_source_set_enabled(filter, request.RequestData()["filterEnabled"].toBool());
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::SetSourceFilterSettings(const Request& request)
+{
+	QString comment;
+	OBSSourceAutoRelease source;
+	OBSSourceAutoRelease filter;
+	RequestStatus checkStatus = ValidateFilter(request, source, filter, comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	checkStatus = request.ValidateObject("filterSettings", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	bool overlay = true;
+	checkStatus = request.ValidateBool("overlay", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		overlay = request.RequestData()["overlay"].toBool();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	// Applied on the next rendered frame, together with any other update to this filter that arrives before it
+	OBSDataAutoRelease filterSettings = UtilsQtToObsData(request.RequestData()["filterSettings"].toObject());
+	GetFilterSettingsCoalescer()->Queue(filter, filterSettings, overlay);
+
+	return RequestResult::BuildSuccess(request);
+}
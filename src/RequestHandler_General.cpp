@@ -4,6 +4,20 @@
 #include <QtGui/QImageWriter>
 
 #include "RequestHandler.h"
+#include "WebsocketManager.h"
+#include "FileTransfers.h"
+#include "ResponseCache.h"
+#include "media/ThumbnailStream.h"
+#include "media/AudioMeters.h"
+#include "media/FilterSettingsCoalescer.h"
+#include "stats/IngestHealthSampler.h"
+#include "stats/OutputStatsSampler.h"
+#include "stats/StreamSupervisor.h"
+#include "stats/SceneSwitchTracker.h"
+#include "outputs/SimulcastOutputs.h"
+#include "outputs/ReplayBuffer.h"
+#include "automation/AutoSceneSwitcher.h"
+#include "automation/IngestWatchdog.h"
 
 RequestResult RequestHandler::GetVersion(const Request& request)
 {
@@ -44,75 +58,118 @@ RequestResult RequestHandler::Sleep(const Request& request)
 
 RequestResult RequestHandler::CacheUpdate(const Request& request)
 {
+	// With a `fieldMask`, only the requested subtrees are queried from libobs. `streamSettings` must be asked for.
 	QString comment;
-	RequestStatus checkStatus = request.ValidateArray("ingestSources", &comment);
+	RequestStatus checkStatus = request.ValidateFieldMask(&comment);
 	if (checkStatus != RequestStatus::NoError)
 		return RequestResult::BuildFailure(request, checkStatus, comment);
 
+	bool wantsIngests = request.WantsField("ingestSources");
+	if (wantsIngests) {
+		checkStatus = request.ValidateArray("ingestSources", &comment);
+		if (checkStatus != RequestStatus::NoError)
+			return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
 	QJsonObject resultJson;
 
-	OBSSourceAutoRelease currentScene = obs_frontend_get_current_scene();
-	resultJson["currentScene"] = obs_source_get_name(currentScene);
-
-	obs_frontend_source_list sceneList = {};
-	obs_frontend_get_scenes(&sceneList);
-	QJsonArray scenes;
-	for (size_t i = 0; i < sceneList.sources.num; i++) {
-		obs_source_t* scene = sceneList.sources.array[i];
-		scenes.append(QJsonValue(obs_source_get_name(scene)));
+	if (request.WantsField("currentScene")) {
+		OBSSourceAutoRelease currentScene = obs_frontend_get_current_scene();
+		resultJson["currentScene"] = obs_source_get_name(currentScene);
 	}
-	obs_frontend_source_list_free(&sceneList);
-	resultJson["sceneList"] = scenes;
-
-	QJsonArray ingests;
-	for (auto ingest : request.RequestData()["ingestSources"].toArray()) {
-		QJsonObject ingestObject;
-		QString ingestSourceName = ingest.toString();
-		if (ingestSourceName.isEmpty() || ingestSourceName.isNull())
-			continue;
-		ingestObject["sourceName"] = ingestSourceName;
-		OBSSourceAutoRelease ingestSource = obs_get_source_by_name(ingestSourceName.toUtf8());
-		if (!ingestSource) {
-			ingestObject["sourceOk"] = false;
-			ingests.append(ingestObject);
-			continue;
-		}
-		ingestObject["sourceOk"] = true;
-		double volume = obs_mul_to_db(obs_source_get_volume(ingestSource));
-		if (volume == -INFINITY) {
-			volume = -100.0;
+
+	if (request.WantsField("sceneList")) {
+		obs_frontend_source_list sceneList = {};
+		obs_frontend_get_scenes(&sceneList);
+		QJsonArray scenes;
+		for (size_t i = 0; i < sceneList.sources.num; i++) {
+			obs_source_t* scene = sceneList.sources.array[i];
+			scenes.append(QJsonValue(obs_source_get_name(scene)));
 		}
-		ingestObject["volume"] = volume;
-		ingestObject["muted"] = obs_source_muted(ingestSource);
-		QString sourceKind = obs_source_get_id(ingestSource);
-		ingestObject["sourceKind"] = sourceKind;
+		obs_frontend_source_list_free(&sceneList);
+		resultJson["sceneList"] = scenes;
+	}
+
+	if (wantsIngests) {
+		bool wantsVolume = request.WantsField("ingestSources.volume");
+		bool wantsMuted = request.WantsField("ingestSources.muted");
+		bool wantsAudioLevels = request.WantsField("ingestSources.audioLevels");
+		bool wantsSourceKind = request.WantsField("ingestSources.sourceKind");
+		bool wantsStatsData = request.WantsField("ingestSources.statsData");
+		bool wantsMediaState = request.WantsField("ingestSources.mediaState");
 
-		if (sourceKind == "vlc_source") {
-			OBSDataAutoRelease statsData = obs_data_create();
+		QJsonArray ingests;
+		for (auto ingest : request.RequestData()["ingestSources"].toArray()) {
+			QJsonObject ingestObject;
+			QString ingestSourceName = ingest.toString();
+			if (ingestSourceName.isEmpty() || ingestSourceName.isNull())
+				continue;
+			ingestObject["sourceName"] = ingestSourceName;
+			OBSSourceAutoRelease ingestSource = obs_get_source_by_name(ingestSourceName.toUtf8());
+			if (!ingestSource) {
+				ingestObject["sourceOk"] = false;
+				ingests.append(ingestObject);
+				continue;
+			}
+			ingestObject["sourceOk"] = true;
+			if (wantsVolume) {
+				double volume = obs_mul_to_db(obs_source_get_volume(ingestSource));
+				if (volume == -INFINITY) {
+					volume = -100.0;
+				}
+				ingestObject["volume"] = volume;
+			}
+			if (wantsMuted)
+				ingestObject["muted"] = obs_source_muted(ingestSource);
+			if (wantsAudioLevels) {
+				QJsonObject audioLevels;
+				if (GetAudioMeters()->GetLevels(ingestSourceName, audioLevels))
+					ingestObject["audioLevels"] = audioLevels;
+			}
+			QString sourceKind = obs_source_get_id(ingestSource);
+			if (wantsSourceKind)
+				ingestObject["sourceKind"] = sourceKind;
+
+			if (sourceKind == "vlc_source") {
 #ifdef IRLTK_CLOUD
-			obs_source_media_irltk_get_stats(ingestSource, statsData);
-			ingestObject["statsData"] = UtilsObsDataToQt(statsData);
+				if (wantsStatsData) {
+					OBSDataAutoRelease statsData = obs_data_create();
+					obs_source_media_irltk_get_stats(ingestSource, statsData);
+					ingestObject["statsData"] = UtilsObsDataToQt(statsData);
+				}
 #endif
-			ingestObject["mediaState"] = UtilsGetSourceMediaState(ingestSource);
+				if (wantsMediaState)
+					ingestObject["mediaState"] = UtilsGetSourceMediaState(ingestSource);
+			}
+			ingests.append(ingestObject);
 		}
-		ingests.append(ingestObject);
+		resultJson["ingestSources"] = ingests;
 	}
-	resultJson["ingestSources"] = ingests;
 
-	if (obs_frontend_streaming_active()) {
-		resultJson["isStreaming"] = true;
-		OBSOutputAutoRelease streamingOutput = obs_frontend_get_streaming_output();
-		resultJson["streamTimecode"] = UtilsGetOutputTimecode(streamingOutput);
-	} else {
-		resultJson["isStreaming"] = false;
-		resultJson["streamTimecode"] = "00:00:00.000";
+	bool wantsIsStreaming = request.WantsField("isStreaming");
+	bool wantsStreamTimecode = request.WantsField("streamTimecode");
+	if (wantsIsStreaming || wantsStreamTimecode) {
+		bool streaming = obs_frontend_streaming_active();
+		if (wantsIsStreaming)
+			resultJson["isStreaming"] = streaming;
+		if (wantsStreamTimecode) {
+			if (streaming) {
+				OBSOutputAutoRelease streamingOutput = obs_frontend_get_streaming_output();
+				resultJson["streamTimecode"] = UtilsGetOutputTimecode(streamingOutput);
+			} else {
+				resultJson["streamTimecode"] = "00:00:00.000";
+			}
+		}
 	}
 
-	QJsonObject streamSettings;
-	OBSService service = obs_frontend_get_streaming_service();
-	streamSettings["serviceType"] = obs_service_get_type(service);
-	OBSDataAutoRelease serviceSettings = obs_service_get_settings(service);
-	streamSettings["settings"] = UtilsObsDataToQt(serviceSettings);
+	if (request.WantsField("streamSettings", false)) {
+		QJsonObject streamSettings;
+		OBSService service = obs_frontend_get_streaming_service();
+		streamSettings["serviceType"] = obs_service_get_type(service);
+		OBSDataAutoRelease serviceSettings = obs_service_get_settings(service);
+		streamSettings["settings"] = UtilsObsDataToQt(serviceSettings);
+		resultJson["streamSettings"] = streamSettings;
+	}
 
 	return RequestResult::BuildSuccess(request, resultJson);
 }
@@ -146,3 +203,60 @@ RequestResult RequestHandler::LogDump(const Request& request)
 
 	return RequestResult::BuildSuccess(request);
 }
+
+RequestResult RequestHandler::GetStats(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = request.ValidateFieldMask(&comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	QJsonObject resultJson;
+	auto websocketManager = GetWebsocketManager();
+
+	if (request.WantsField("connection"))
+		resultJson["connection"] = websocketManager->GetConnectionStats();
+
+	if (request.WantsField("sessions")) {
+		QJsonArray sessions;
+		for (auto session : websocketManager->GetSessions())
+			sessions.append(session->GetStats());
+		resultJson["sessions"] = sessions;
+	}
+
+	if (request.WantsField("workerPool"))
+		resultJson["workerPool"] = websocketManager->GetWorkerPool()->GetStats();
+	if (request.WantsField("requestSequencer"))
+		resultJson["requestSequencer"] = websocketManager->GetRequestSequencer()->GetStats();
+	if (request.WantsField("requestCoalescer"))
+		resultJson["requestCoalescer"] = websocketManager->GetRequestCoalescer()->GetStats();
+	if (request.WantsField("responseCache"))
+		resultJson["responseCache"] = GetResponseCache()->GetStats();
+
+	if (request.WantsField("programThumbnail"))
+		resultJson["programThumbnail"] = GetThumbnailStream()->GetStats();
+	if (request.WantsField("audioMeters"))
+		resultJson["audioMeters"] = GetAudioMeters()->GetStats();
+	if (request.WantsField("filterSettings"))
+		resultJson["filterSettings"] = GetFilterSettingsCoalescer()->GetStats();
+	if (request.WantsField("ingestHealth"))
+		resultJson["ingestHealth"] = GetIngestHealthSampler()->GetStats();
+	if (request.WantsField("outputStats"))
+		resultJson["outputStats"] = GetOutputStatsSampler()->GetStats();
+	if (request.WantsField("streamSupervisor"))
+		resultJson["streamSupervisor"] = GetStreamSupervisor()->GetStats();
+	if (request.WantsField("simulcastOutputs"))
+		resultJson["simulcastOutputs"] = GetSimulcastOutputs()->GetStats();
+	if (request.WantsField("sceneSwitches"))
+		resultJson["sceneSwitches"] = GetSceneSwitchTracker()->GetStats();
+	if (request.WantsField("replayBuffer"))
+		resultJson["replayBuffer"] = GetReplayBuffer()->GetStats();
+	if (request.WantsField("fileTransfers"))
+		resultJson["fileTransfers"] = GetFileTransfers()->GetStats();
+	if (request.WantsField("autoSceneSwitcher"))
+		resultJson["autoSceneSwitcher"] = GetAutoSceneSwitcher()->GetStats();
+	if (request.WantsField("ingestWatchdog"))
+		resultJson["ingestWatchdog"] = GetIngestWatchdog()->GetStats();
+
+	return RequestResult::BuildSuccess(request, resultJson);
+}
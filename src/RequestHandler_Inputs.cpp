@@ -1 +1,180 @@
+#include <vector>
+
 #include "RequestHandler.h"
+
+static const char *MonitorTypeNames[] = {
+	"OBS_MONITORING_TYPE_NONE",
+	"OBS_MONITORING_TYPE_MONITOR_ONLY",
+	"OBS_MONITORING_TYPE_MONITOR_AND_OUTPUT",
+};
+
+struct InputAudioChange {
+	OBSSourceAutoRelease Input;
+	bool VolumeChanged = false;
+	float VolumeMul = 1.0f;
+	bool MutedChanged = false;
+	bool Muted = false;
+	bool MonitorTypeChanged = false;
+	enum obs_monitoring_type MonitorType = OBS_MONITORING_TYPE_NONE;
+	bool SyncOffsetChanged = false;
+	int64_t SyncOffset = 0;
+};
+
+RequestResult RequestHandler::GetInputList(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+
+	struct EnumParam {
+		QByteArray InputKind;
+		QJsonArray Inputs;
+	} enumParam;
+
+	checkStatus = request.ValidateString("inputKind", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		enumParam.InputKind = request.RequestData()["inputKind"].toString().toUtf8();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	// One pass over the source list. The callback runs with the list locked, so it only reads.
+	obs_enum_sources([](void *param, obs_source_t *input) {
+		auto enumParam = static_cast<EnumParam*>(param);
+		const char *inputKind = obs_source_get_id(input);
+		if (!enumParam->InputKind.isEmpty() && enumParam->InputKind != inputKind)
+			return true;
+
+		QJsonObject inputJson;
+		inputJson["inputName"] = obs_source_get_name(input);
+		inputJson["inputKind"] = inputKind;
+
+		bool hasAudio = (obs_source_get_output_flags(input) & OBS_SOURCE_AUDIO) != 0;
+		inputJson["hasAudio"] = hasAudio;
+		if (hasAudio) {
+			float volumeMul = obs_source_get_volume(input);
+			double volumeDb = obs_mul_to_db(volumeMul);
+			if (volumeDb == -INFINITY)
+				volumeDb = -100.0;
+			inputJson["inputVolumeMul"] = volumeMul;
+			inputJson["inputVolumeDb"] = volumeDb;
+			inputJson["inputMuted"] = obs_source_muted(input);
+			size_t monitorType = (size_t)obs_source_get_monitoring_type(input);
+			inputJson["monitorType"] = monitorType < sizeof(MonitorTypeNames) / sizeof(MonitorTypeNames[0]) ? MonitorTypeNames[monitorType] : MonitorTypeNames[0];
+			inputJson["syncOffset"] = (double)(obs_source_get_sync_offset(input) / 1000000);
+		}
+
+		enumParam->Inputs.append(inputJson);
+		return true;
+	}, &enumParam);
+
+	QJsonObject resultJson;
+	resultJson["inputs"] = enumParam.Inputs;
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::SetInputAudioSettings(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = request.ValidateArray("inputs", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	QJsonArray inputsJson = request.RequestData()["inputs"].toArray();
+	std::vector<InputAudioChange> changes(inputsJson.size());
+	QHash<QString, std::vector<size_t>> changesByName;
+
+	// Everything is validated before any input is touched
+	for (int i = 0; i < inputsJson.size(); i++) {
+		if (!inputsJson[i].isObject())
+			return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameterDataType, "Parameter: inputs\nAll inputs must be objects.");
+		QJsonObject inputJson = inputsJson[i].toObject();
+		InputAudioChange &change = changes[i];
+
+		if (!inputJson["inputName"].isString() || inputJson["inputName"].toString().isEmpty())
+			return RequestResult::BuildFailure(request, RequestStatus::MissingRequestParameter, QString("Parameter: inputs\nInput %1 requires an `inputName` string.").arg(i));
+		changesByName[inputJson["inputName"].toString()].push_back(i);
+
+		if (inputJson.contains("inputVolumeDb") && inputJson.contains("inputVolumeMul"))
+			return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameter, QString("Parameter: inputs\nInput %1 may only specify one of `inputVolumeDb` and `inputVolumeMul`.").arg(i));
+		if (inputJson.contains("inputVolumeDb")) {
+			double volumeDb = inputJson["inputVolumeDb"].toDouble(NAN);
+			if (!(volumeDb >= -100.0 && volumeDb <= 26.0))
+				return RequestResult::BuildFailure(request, RequestStatus::RequestParameterOutOfRange, QString("Parameter: inputs\nInput %1: `inputVolumeDb` must be a number within -100 and 26.").arg(i));
+			// -100dB is what the cache reports for silence
+			change.VolumeMul = volumeDb <= -100.0 ? 0.0f : obs_db_to_mul((float)volumeDb);
+			change.VolumeChanged = true;
+		}
+		if (inputJson.contains("inputVolumeMul")) {
+			double volumeMul = inputJson["inputVolumeMul"].toDouble(NAN);
+			if (!(volumeMul >= 0.0 && volumeMul <= 20.0))
+				return RequestResult::BuildFailure(request, RequestStatus::RequestParameterOutOfRange, QString("Parameter: inputs\nInput %1: `inputVolumeMul` must be a number within 0 and 20.").arg(i));
+			change.VolumeMul = (float)volumeMul;
+			change.VolumeChanged = true;
+		}
+
+		if (inputJson.contains("inputMuted")) {
+			if (!inputJson["inputMuted"].isBool())
+				return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameterDataType, QString("Parameter: inputs\nInput %1: `inputMuted` must be a boolean.").arg(i));
+			change.Muted = inputJson["inputMuted"].toBool();
+			change.MutedChanged = true;
+		}
+
+		if (inputJson.contains("monitorType")) {
+			QString monitorTypeName = inputJson["monitorType"].toString();
+			size_t monitorTypeCount = sizeof(MonitorTypeNames) / sizeof(MonitorTypeNames[0]);
+			size_t monitorType = 0;
+			while (monitorType < monitorTypeCount && monitorTypeName != MonitorTypeNames[monitorType])
+				monitorType++;
+			if (monitorType == monitorTypeCount)
+				return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameter, QString("Parameter: inputs\nInput %1: `monitorType` is not a valid monitoring type.").arg(i));
+			change.MonitorType = (enum obs_monitoring_type)monitorType;
+			change.MonitorTypeChanged = true;
+		}
+
+		if (inputJson.contains("syncOffset")) {
+			double syncOffset = inputJson["syncOffset"].toDouble(NAN);
+			if (!(syncOffset >= -950.0 && syncOffset <= 20000.0))
+				return RequestResult::BuildFailure(request, RequestStatus::RequestParameterOutOfRange, QString("Parameter: inputs\nInput %1: `syncOffset` must be a number of milliseconds within -950 and 20000.").arg(i));
+			change.SyncOffset = (int64_t)(syncOffset * 1000000.0);
+			change.SyncOffsetChanged = true;
+		}
+	}
+
+	// Resolve every name in one pass instead of one lookup per input
+	struct EnumParam {
+		QHash<QString, std::vector<size_t>> *ChangesByName;
+		std::vector<InputAudioChange> *Changes;
+	} enumParam = {&changesByName, &changes};
+	obs_enum_sources([](void *param, obs_source_t *input) {
+		auto enumParam = static_cast<EnumParam*>(param);
+		auto it = enumParam->ChangesByName->constFind(QString::fromUtf8(obs_source_get_name(input)));
+		if (it == enumParam->ChangesByName->constEnd())
+			return true;
+		for (size_t index : it.value()) {
+			obs_source_addref(input);
+			(*enumParam->Changes)[index].Input = input;
+		}
+		return true;
+	}, &enumParam);
+
+	for (size_t i = 0; i < changes.size(); i++) {
+		if (!changes[i].Input)
+			return RequestResult::BuildFailure(request, RequestStatus::InputNotFound, QString("Parameter: inputs\nInput %1 (`%2`) was not found.").arg(i).arg(inputsJson[(int)i].toObject()["inputName"].toString()));
+	}
+
+	// Applied in request order, so a later entry for the same input wins
+	for (auto &change : changes) {
+		if (change.VolumeChanged)
+			obs_source_set_volume(change.Input, change.VolumeMul);
+		if (change.MutedChanged)
+			obs_source_set_muted(change.Input, change.Muted);
+		if (change.MonitorTypeChanged)
+			obs_source_set_monitoring_type(change.Input, change.MonitorType);
+		if (change.SyncOffsetChanged)
+			obs_source_set_sync_offset(change.Input, change.SyncOffset);
+	}
+
+	QJsonObject resultJson;
+	resultJson["inputsChanged"] = (int)changes.size();
+	return RequestResult::BuildSuccess(request, resultJson);
+}
@@ -1 +1,159 @@
+#include <vector>
+#include <QtCore/QSet>
+
 #include "RequestHandler.h"
+
+// Resolves the `inputName` parameter to an input which supports media controls
+static RequestStatus ValidateMediaInput(const Request& request, OBSSourceAutoRelease &input, QString &comment)
+{
+	RequestStatus checkStatus = request.ValidateString("inputName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return checkStatus;
+
+	input = obs_get_source_by_name(QT_TO_UTF8(request.RequestData()["inputName"].toString()));
+	if (!input)
+		return RequestStatus::InputNotFound;
+
+	if (!(obs_source_get_output_flags(input) & OBS_SOURCE_CONTROLLABLE_MEDIA)) {
+		comment = "The specified input does not support media controls.";
+		return RequestStatus::InvalidInputKind;
+	}
+
+	return RequestStatus::NoError;
+}
+
+RequestResult RequestHandler::GetMediaInputStatus(const Request& request)
+{
+	QString comment;
+	OBSSourceAutoRelease input;
+	RequestStatus checkStatus = ValidateMediaInput(request, input, comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	QJsonObject resultJson;
+	resultJson["mediaInput"] = UtilsGetMediaInputStatus(input);
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::GetMediaInputStatuses(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+
+	QSet<QString> inputNames;
+	checkStatus = request.ValidateArray("inputNames", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		for (auto inputName : request.RequestData()["inputNames"].toArray())
+			inputNames.insert(inputName.toString());
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	struct EnumParam {
+		QSet<QString> *InputNames;
+		std::vector<OBSSourceAutoRelease> Inputs;
+	} enumParam;
+	enumParam.InputNames = &inputNames;
+
+	// The callback runs with the source list locked, so the media state is only queried once it returns
+	obs_enum_sources([](void *param, obs_source_t *input) {
+		auto enumParam = static_cast<EnumParam*>(param);
+		if (!(obs_source_get_output_flags(input) & OBS_SOURCE_CONTROLLABLE_MEDIA))
+			return true;
+		if (!enumParam->InputNames->isEmpty() && !enumParam->InputNames->contains(QString::fromUtf8(obs_source_get_name(input))))
+			return true;
+		obs_source_addref(input);
+		enumParam->Inputs.emplace_back(input);
+		return true;
+	}, &enumParam);
+
+	QJsonArray mediaInputs;
+	for (auto &input : enumParam.Inputs)
+		mediaInputs.append(UtilsGetMediaInputStatus(input));
+
+	QJsonObject resultJson;
+	resultJson["mediaInputs"] = mediaInputs;
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::TriggerMediaInputAction(const Request& request)
+{
+	QString comment;
+	OBSSourceAutoRelease input;
+	RequestStatus checkStatus = ValidateMediaInput(request, input, comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	checkStatus = request.ValidateString("mediaAction", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	QString mediaAction = request.RequestData()["mediaAction"].toString();
+	if (mediaAction == "play") {
+		// Unpausing does nothing once the media ended or was stopped, so it is started over like obs-websocket does
+		enum obs_media_state mediaState = obs_source_media_get_state(input);
+		if (mediaState == OBS_MEDIA_STATE_ENDED || mediaState == OBS_MEDIA_STATE_STOPPED)
+			obs_source_media_restart(input);
+		else
+			obs_source_media_play_pause(input, false);
+	} else if (mediaAction == "pause")
+		obs_source_media_play_pause(input, true);
+	else if (mediaAction == "stop")
+		obs_source_media_stop(input);
+	else if (mediaAction == "restart")
+		obs_source_media_restart(input);
+	else if (mediaAction == "next")
+		obs_source_media_next(input);
+	else if (mediaAction == "previous")
+		obs_source_media_previous(input);
+	else
+		return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameter, "Parameter: mediaAction\nMust be one of `play`, `pause`, `stop`, `restart`, `next` or `previous`.");
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::SetMediaInputCursor(const Request& request)
+{
+	QString comment;
+	OBSSourceAutoRelease input;
+	RequestStatus checkStatus = ValidateMediaInput(request, input, comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	checkStatus = request.ValidateDouble("mediaCursor", &comment, 0);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	// Seeking before the media has opened would be lost
+	if (obs_source_media_get_state(input) == OBS_MEDIA_STATE_NONE || obs_source_media_get_state(input) == OBS_MEDIA_STATE_OPENING)
+		return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameter, "The media input is not ready to seek.");
+
+	obs_source_media_set_time(input, (int64_t)request.RequestData()["mediaCursor"].toDouble());
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::OffsetMediaInputCursor(const Request& request)
+{
+	QString comment;
+	OBSSourceAutoRelease input;
+	RequestStatus checkStatus = ValidateMediaInput(request, input, comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	checkStatus = request.ValidateDouble("mediaCursorOffset", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	if (obs_source_media_get_state(input) == OBS_MEDIA_STATE_NONE || obs_source_media_get_state(input) == OBS_MEDIA_STATE_OPENING)
+		return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameter, "The media input is not ready to seek.");
+
+	int64_t mediaCursor = obs_source_media_get_time(input) + (int64_t)request.RequestData()["mediaCursorOffset"].toDouble();
+	if (mediaCursor < 0)
+		mediaCursor = 0;
+	obs_source_media_set_time(input, mediaCursor);
+
+	QJsonObject resultJson;
+	resultJson["mediaInput"] = UtilsGetMediaInputStatus(input);
+	return RequestResult::BuildSuccess(request, resultJson);
+}
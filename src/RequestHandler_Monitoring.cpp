@@ -0,0 +1,279 @@
+#include <QtGui/QImageWriter>
+
+#include "RequestHandler.h"
+#include "media/ThumbnailStream.h"
+#include "media/AudioMeters.h"
+#include "stats/IngestHealthSampler.h"
+#include "stats/OutputStatsSampler.h"
+
+RequestResult RequestHandler::GetProgramThumbnailSettings(const Request& request)
+{
+	auto thumbnailStream = GetThumbnailStream();
+	ThumbnailSettings settings = thumbnailStream->GetSettings();
+
+	QJsonObject resultJson;
+	resultJson["enabled"] = settings.Enabled;
+	resultJson["fps"] = settings.Fps;
+	resultJson["imageWidth"] = settings.Width;
+	resultJson["imageHeight"] = settings.Height;
+	resultJson["imageFormat"] = settings.Format;
+	resultJson["imageCompressionQuality"] = settings.Quality;
+
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::SetProgramThumbnailSettings(const Request& request)
+{
+	auto thumbnailStream = GetThumbnailStream();
+	ThumbnailSettings settings = thumbnailStream->GetSettings();
+
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+
+	checkStatus = request.ValidateBool("enabled", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.Enabled = request.RequestData()["enabled"].toBool();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+	checkStatus = request.ValidateDouble("fps", &comment, 0.1, 30);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.Fps = request.RequestData()["fps"].toDouble();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+	checkStatus = request.ValidateDouble("imageWidth", &comment, 32, 1920);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.Width = request.RequestData()["imageWidth"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+	checkStatus = request.ValidateDouble("imageHeight", &comment, 0, 1080);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.Height = request.RequestData()["imageHeight"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+	checkStatus = request.ValidateDouble("imageCompressionQuality", &comment, -1, 100);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.Quality = request.RequestData()["imageCompressionQuality"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+	checkStatus = request.ValidateString("imageFormat", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		QString imageFormat = request.RequestData()["imageFormat"].toString();
+		if (!QImageWriter::supportedImageFormats().contains(imageFormat.toLatin1()))
+			return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameter, "Parameter: imageFormat\nThe image format is not supported. See `supportedImageFormats` in `GetVersion`.");
+		settings.Format = imageFormat;
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	thumbnailStream->SetSettings(settings);
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::GetProgramThumbnail(const Request& request)
+{
+	int timeoutMs = 1000;
+
+	QString comment;
+	RequestStatus checkStatus = request.ValidateDouble("timeoutMs", &comment, 0, 10000);
+	if (checkStatus == RequestStatus::NoError) {
+		timeoutMs = request.RequestData()["timeoutMs"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	auto thumbnailStream = GetThumbnailStream();
+	Thumbnail thumbnail;
+	if (!thumbnailStream->GetThumbnail(thumbnail, timeoutMs)) {
+		if (thumbnailStream->LastEncodeFailed())
+			return RequestResult::BuildFailure(request, RequestStatus::ScreenshotEncodeFailed);
+		return RequestResult::BuildFailure(request, RequestStatus::ScreenshotRenderFailed);
+	}
+
+	QJsonObject resultJson;
+	resultJson["imageFormat"] = thumbnail.Format;
+	resultJson["imageWidth"] = thumbnail.Width;
+	resultJson["imageHeight"] = thumbnail.Height;
+	resultJson["imageTimestamp"] = (double)(thumbnail.Timestamp / 1000000);
+	resultJson["imageData"] = QString("data:image/%1;base64,%2").arg(thumbnail.Format).arg(QString(thumbnail.Data.toBase64()));
+
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::GetAudioMeterSettings(const Request& request)
+{
+	auto audioMeters = GetAudioMeters();
+	AudioMeterSettings settings = audioMeters->GetSettings();
+
+	QJsonObject resultJson;
+	resultJson["enabled"] = settings.Enabled;
+	resultJson["rate"] = settings.Rate;
+	resultJson["sourceNames"] = QJsonArray::fromStringList(settings.SourceNames);
+
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::SetAudioMeterSettings(const Request& request)
+{
+	auto audioMeters = GetAudioMeters();
+	AudioMeterSettings settings = audioMeters->GetSettings();
+
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+
+	checkStatus = request.ValidateBool("enabled", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.Enabled = request.RequestData()["enabled"].toBool();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+	checkStatus = request.ValidateDouble("rate", &comment, 1, 60);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.Rate = request.RequestData()["rate"].toDouble();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+	checkStatus = request.ValidateArray("sourceNames", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		QJsonArray sourceNames = request.RequestData()["sourceNames"].toArray();
+		if (sourceNames.size() > 255)
+			return RequestResult::BuildFailure(request, RequestStatus::RequestParameterOutOfRange, "Parameter: sourceNames\nAt most 255 sources can be metered.");
+		settings.SourceNames.clear();
+		for (auto sourceName : sourceNames) {
+			if (!sourceName.isString() || sourceName.toString().isEmpty())
+				return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameterDataType, "Parameter: sourceNames\nAll entries must be non-empty strings.");
+			if (!settings.SourceNames.contains(sourceName.toString()))
+				settings.SourceNames.append(sourceName.toString());
+		}
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	audioMeters->SetSettings(settings);
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::GetAudioLevels(const Request& request)
+{
+	QJsonObject resultJson;
+	resultJson["sources"] = GetAudioMeters()->GetAllLevels();
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::GetIngestHealthSettings(const Request& request)
+{
+	IngestHealthSettings settings = GetIngestHealthSampler()->GetSettings();
+
+	QJsonObject resultJson;
+	resultJson["enabled"] = settings.Enabled;
+	resultJson["sampleInterval"] = settings.Interval;
+	resultJson["windowSize"] = settings.WindowSize;
+
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::SetIngestHealthSettings(const Request& request)
+{
+	auto ingestHealthSampler = GetIngestHealthSampler();
+	IngestHealthSettings settings = ingestHealthSampler->GetSettings();
+
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+
+	checkStatus = request.ValidateBool("enabled", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.Enabled = request.RequestData()["enabled"].toBool();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+	checkStatus = request.ValidateDouble("sampleInterval", &comment, 100, 60000);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.Interval = request.RequestData()["sampleInterval"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+	checkStatus = request.ValidateDouble("windowSize", &comment, 2, IngestHealthSampler::HistorySize / 2);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.WindowSize = request.RequestData()["windowSize"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	ingestHealthSampler->SetSettings(settings);
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::GetIngestHealth(const Request& request)
+{
+	QString sourceName;
+	size_t sampleCount = 0;
+
+	QString comment;
+	RequestStatus checkStatus = request.ValidateString("sourceName", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		sourceName = request.RequestData()["sourceName"].toString();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+	checkStatus = request.ValidateDouble("sampleCount", &comment, 0, IngestHealthSampler::HistorySize);
+	if (checkStatus == RequestStatus::NoError) {
+		sampleCount = request.RequestData()["sampleCount"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	QJsonArray ingests = GetIngestHealthSampler()->GetIngestHealth(sourceName, sampleCount);
+	if (!sourceName.isEmpty() && ingests.isEmpty())
+		return RequestResult::BuildFailure(request, RequestStatus::SourceNotFound, "No ingest health is being recorded for that source.");
+
+	QJsonObject resultJson;
+	resultJson["ingests"] = ingests;
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::GetOutputStatsSettings(const Request& request)
+{
+	OutputStatsSettings settings = GetOutputStatsSampler()->GetSettings();
+
+	QJsonObject resultJson;
+	resultJson["sampleInterval"] = settings.Interval;
+	resultJson["windowDuration"] = settings.Window;
+
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::SetOutputStatsSettings(const Request& request)
+{
+	auto outputStatsSampler = GetOutputStatsSampler();
+	OutputStatsSettings settings = outputStatsSampler->GetSettings();
+
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+
+	checkStatus = request.ValidateDouble("sampleInterval", &comment, 100, 10000);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.Interval = request.RequestData()["sampleInterval"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+	checkStatus = request.ValidateDouble("windowDuration", &comment, 1000, 300000);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.Window = request.RequestData()["windowDuration"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	if ((size_t)(settings.Window / settings.Interval) >= OutputStatsSampler::HistorySize)
+		return RequestResult::BuildFailure(request, RequestStatus::RequestParameterOutOfRange, QString("The window must not span more than %1 samples. Raise `sampleInterval` or lower `windowDuration`.").arg(OutputStatsSampler::HistorySize - 1));
+
+	outputStatsSampler->SetSettings(settings);
+
+	return RequestResult::BuildSuccess(request);
+}
@@ -1 +1,110 @@
 #include "RequestHandler.h"
+#include "outputs/SimulcastOutputs.h"
+
+RequestResult RequestHandler::GetSimulcastOutputList(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+
+	QString outputName;
+	checkStatus = request.ValidateString("outputName", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		outputName = request.RequestData()["outputName"].toString();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	QJsonArray outputs = GetSimulcastOutputs()->GetOutputs(outputName);
+	if (!outputName.isEmpty() && outputs.isEmpty())
+		return RequestResult::BuildFailure(request, RequestStatus::OutputNotFound);
+
+	QJsonObject resultJson;
+	resultJson["outputs"] = outputs;
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::CreateSimulcastOutput(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+	SimulcastOutputSettings settings;
+
+	checkStatus = request.ValidateString("outputName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	checkStatus = request.ValidateString("serverUrl", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	settings.ServerUrl = request.RequestData()["serverUrl"].toString();
+
+	checkStatus = request.ValidateString("streamKey", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.StreamKey = request.RequestData()["streamKey"].toString();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	checkStatus = request.ValidateDouble("maxRetries", &comment, 0, 10000);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.MaxRetries = request.RequestData()["maxRetries"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	checkStatus = request.ValidateDouble("retryDelay", &comment, 1, 60);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.RetryDelay = request.RequestData()["retryDelay"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	checkStatus = GetSimulcastOutputs()->CreateOutput(request.RequestData()["outputName"].toString(), settings, comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::RemoveSimulcastOutput(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = request.ValidateString("outputName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	checkStatus = GetSimulcastOutputs()->RemoveOutput(request.RequestData()["outputName"].toString());
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus);
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::StartSimulcastOutput(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = request.ValidateString("outputName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	comment.clear();
+	checkStatus = GetSimulcastOutputs()->StartOutput(request.RequestData()["outputName"].toString(), comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::StopSimulcastOutput(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = request.ValidateString("outputName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	checkStatus = GetSimulcastOutputs()->StopOutput(request.RequestData()["outputName"].toString());
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus);
+
+	return RequestResult::BuildSuccess(request);
+}
@@ -1,14 +1,48 @@
+#include <algorithm>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+
 #include "RequestHandler.h"
+#include "FileTransfers.h"
+#include "stats/OutputStatsSampler.h"
+
+// Extensions of the container formats the frontend can record to
+static const QStringList RecordingNameFilters = {"*.mkv", "*.mp4", "*.mov", "*.flv", "*.ts", "*.m3u8", "*.fragmented.mp4", "*.fragmented.mov"};
+
+// The file the recording output is currently writing, empty when not recording
+static QString GetActiveRecordingPath()
+{
+	OBSOutputAutoRelease recordOutput = obs_frontend_get_recording_output();
+	if (!obs_output_active(recordOutput))
+		return QString();
+
+	OBSDataAutoRelease outputSettings = obs_output_get_settings(recordOutput);
+	QString path = obs_data_get_string(outputSettings, "path");
+	if (path.isEmpty())
+		return path;
+	return QFileInfo(path).absoluteFilePath();
+}
 
 RequestResult RequestHandler::GetRecordStatus(const Request& request)
 {
+	QString comment;
+	RequestStatus checkStatus = request.ValidateFieldMask(&comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
 	QJsonObject resultJson;
 
 	OBSOutputAutoRelease recordOutput = obs_frontend_get_recording_output();
-	resultJson["outputActive"] = obs_output_active(recordOutput);
-	resultJson["outputPaused"] = obs_output_paused(recordOutput);
-	resultJson["outputTimecode"] = UtilsGetOutputTimecode(recordOutput);
-	resultJson["outputDuration"] = (qint64)UtilsGetOutputDuration(recordOutput);
+	if (request.WantsField("outputActive"))
+		resultJson["outputActive"] = obs_output_active(recordOutput);
+	if (request.WantsField("outputPaused"))
+		resultJson["outputPaused"] = obs_output_paused(recordOutput);
+	if (request.WantsField("outputTimecode"))
+		resultJson["outputTimecode"] = UtilsGetOutputTimecode(recordOutput);
+	if (request.WantsField("outputDuration"))
+		resultJson["outputDuration"] = (qint64)UtilsGetOutputDuration(recordOutput);
+	if (request.WantsField("outputStats"))
+		resultJson["outputStats"] = GetOutputStatsSampler()->GetOutputStats("record");
 
 	return RequestResult::BuildSuccess(request, resultJson);
 }
@@ -30,3 +64,105 @@ RequestResult RequestHandler::StopRecord(const Request& request)
 	obs_frontend_recording_stop();
 	return RequestResult::BuildSuccess(request);
 }
+
+RequestResult RequestHandler::GetRecordingList(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+
+	int limit = 100;
+	checkStatus = request.ValidateDouble("limit", &comment, 1, 1000);
+	if (checkStatus == RequestStatus::NoError) {
+		limit = request.RequestData()["limit"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	QString recordDirectory = UtilsGetRecordDirectory();
+	QDir dir(recordDirectory);
+	if (recordDirectory.isEmpty() || !dir.exists())
+		return RequestResult::BuildFailure(request, RequestStatus::DirectoryNotFound, "The configured recording directory does not exist.");
+
+	// Newest first, so the recording that just ended is on the first page
+	QFileInfoList files = dir.entryInfoList(RecordingNameFilters, QDir::Files | QDir::Readable, QDir::Time);
+	QString activeRecordingPath = GetActiveRecordingPath();
+
+	QJsonArray recordings;
+	for (int i = 0; i < std::min(limit, (int)files.size()); i++) {
+		const QFileInfo &fileInfo = files[i];
+		QJsonObject recordingJson;
+		recordingJson["fileName"] = fileInfo.fileName();
+		recordingJson["fileSize"] = (double)fileInfo.size();
+		// Milliseconds since the epoch. Not every file system records the creation time.
+		if (fileInfo.birthTime().isValid())
+			recordingJson["createdTimestamp"] = (double)fileInfo.birthTime().toMSecsSinceEpoch();
+		recordingJson["modifiedTimestamp"] = (double)fileInfo.lastModified().toMSecsSinceEpoch();
+		// Still being written, so its size keeps growing
+		recordingJson["recordingActive"] = fileInfo.absoluteFilePath() == activeRecordingPath;
+		recordings.append(recordingJson);
+	}
+
+	QJsonObject resultJson;
+	resultJson["recordDirectory"] = recordDirectory;
+	resultJson["totalCount"] = (int)files.size();
+	resultJson["recordings"] = recordings;
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::TransferRecording(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = request.ValidateString("fileName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	// Resuming an aborted transfer starts a new one at the last offset that was received
+	uint64_t offset = 0;
+	checkStatus = request.ValidateDouble("offset", &comment, 0);
+	if (checkStatus == RequestStatus::NoError) {
+		offset = (uint64_t)request.RequestData()["offset"].toDouble();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	uint64_t length = 0;
+	checkStatus = request.ValidateDouble("length", &comment, 1);
+	if (checkStatus == RequestStatus::NoError) {
+		length = (uint64_t)request.RequestData()["length"].toDouble();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	int chunkSize = FileTransfers::DefaultChunkSize;
+	checkStatus = request.ValidateDouble("chunkSize", &comment, 4096, 4194304);
+	if (checkStatus == RequestStatus::NoError) {
+		chunkSize = request.RequestData()["chunkSize"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	QString recordDirectory = UtilsGetRecordDirectory();
+	QDir dir(recordDirectory);
+	if (recordDirectory.isEmpty() || !dir.exists())
+		return RequestResult::BuildFailure(request, RequestStatus::DirectoryNotFound, "The configured recording directory does not exist.");
+
+	// Only files `GetRecordingList` would list can be fetched. The recording directory defaults to the home directory on
+	// Linux, so anything else in it (Eg. `.ssh`) is off limits, and symlinks must resolve to a file inside it.
+	QString fileName = request.RequestData()["fileName"].toString();
+	QFileInfo fileInfo(dir.filePath(fileName));
+	QString canonicalFilePath = fileInfo.canonicalFilePath();
+	if (fileName.contains('/') || fileName.contains('\\') || !QDir::match(RecordingNameFilters, fileName) || !fileInfo.isFile() || !fileInfo.isReadable() ||
+		canonicalFilePath.isEmpty() || QFileInfo(canonicalFilePath).absolutePath() != dir.canonicalPath())
+		return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameter, "Parameter: fileName\nNo recording with that name exists.");
+
+	QJsonObject transferJson;
+	checkStatus = GetFileTransfers()->StartTransfer(request.ChannelId(), canonicalFilePath, offset, length, chunkSize, transferJson, comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	QJsonObject resultJson;
+	resultJson["transfer"] = transferJson;
+	// A file still being recorded is sent up to the size it had when the transfer started
+	resultJson["recordingActive"] = fileInfo.absoluteFilePath() == GetActiveRecordingPath();
+	return RequestResult::BuildSuccess(request, resultJson);
+}
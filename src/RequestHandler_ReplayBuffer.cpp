@@ -0,0 +1,132 @@
+#include "RequestHandler.h"
+#include "outputs/ReplayBuffer.h"
+#include "FileTransfers.h"
+
+RequestResult RequestHandler::GetReplayBufferStatus(const Request& request)
+{
+	OBSOutputAutoRelease replayOutput = obs_frontend_get_replay_buffer_output();
+	if (!replayOutput)
+		return RequestResult::BuildFailure(request, RequestStatus::ReplayBufferDisabled);
+
+	QJsonObject resultJson;
+	resultJson["outputActive"] = obs_output_active(replayOutput);
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::StartReplayBuffer(const Request& request)
+{
+	OBSOutputAutoRelease replayOutput = obs_frontend_get_replay_buffer_output();
+	if (!replayOutput)
+		return RequestResult::BuildFailure(request, RequestStatus::ReplayBufferDisabled);
+
+	if (obs_frontend_replay_buffer_active())
+		return RequestResult::BuildFailure(request, RequestStatus::ReplayBufferRunning);
+
+	obs_frontend_replay_buffer_start();
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::StopReplayBuffer(const Request& request)
+{
+	if (!obs_frontend_replay_buffer_active())
+		return RequestResult::BuildFailure(request, RequestStatus::ReplayBufferNotRunning);
+
+	obs_frontend_replay_buffer_stop();
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::SaveReplayBuffer(const Request& request)
+{
+	if (!obs_frontend_replay_buffer_active())
+		return RequestResult::BuildFailure(request, RequestStatus::ReplayBufferNotRunning);
+
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+
+	bool waitForSave = false;
+	checkStatus = request.ValidateBool("waitForSave", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		waitForSave = request.RequestData()["waitForSave"].toBool();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	int timeout = 15000;
+	checkStatus = request.ValidateDouble("timeout", &comment, 100, 60000);
+	if (checkStatus == RequestStatus::NoError) {
+		timeout = request.RequestData()["timeout"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	auto replayBuffer = GetReplayBuffer();
+	uint64_t previousSaveCount = replayBuffer->GetSaveCount();
+
+	obs_frontend_replay_buffer_save();
+
+	if (!waitForSave)
+		return RequestResult::BuildSuccess(request);
+
+	// The replay is written out in the background, which for long buffers can take a few seconds
+	if (!replayBuffer->WaitForSave(previousSaveCount, timeout))
+		return RequestResult::BuildFailure(request, RequestStatus::RequestProcessingFailed, QString("The replay was not saved within %1ms.").arg(timeout));
+
+	QJsonObject resultJson;
+	resultJson["replay"] = replayBuffer->GetLastReplay();
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::GetLastReplayBufferReplay(const Request& request)
+{
+	QJsonObject lastReplay = GetReplayBuffer()->GetLastReplay();
+	if (lastReplay.isEmpty())
+		return RequestResult::BuildFailure(request, RequestStatus::RequestProcessingFailed, "No replay has been saved yet.");
+
+	QJsonObject resultJson;
+	resultJson["replay"] = lastReplay;
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::TransferLastReplayBufferReplay(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+
+	// Resuming an aborted transfer starts a new one at the last offset that was received
+	uint64_t offset = 0;
+	checkStatus = request.ValidateDouble("offset", &comment, 0);
+	if (checkStatus == RequestStatus::NoError) {
+		offset = (uint64_t)request.RequestData()["offset"].toDouble();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	uint64_t length = 0;
+	checkStatus = request.ValidateDouble("length", &comment, 1);
+	if (checkStatus == RequestStatus::NoError) {
+		length = (uint64_t)request.RequestData()["length"].toDouble();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	int chunkSize = FileTransfers::DefaultChunkSize;
+	checkStatus = request.ValidateDouble("chunkSize", &comment, 4096, 4194304);
+	if (checkStatus == RequestStatus::NoError) {
+		chunkSize = request.RequestData()["chunkSize"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	QString replayPath = GetReplayBuffer()->GetLastReplayPath();
+	if (replayPath.isEmpty())
+		return RequestResult::BuildFailure(request, RequestStatus::RequestProcessingFailed, "No replay has been saved yet.");
+
+	QJsonObject transferJson;
+	checkStatus = GetFileTransfers()->StartTransfer(request.ChannelId(), replayPath, offset, length, chunkSize, transferJson, comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	QJsonObject resultJson;
+	resultJson["transfer"] = transferJson;
+	return RequestResult::BuildSuccess(request, resultJson);
+}
@@ -1 +1,291 @@
-#include "RequestHandler.h"
\ No newline at end of file
+#include <algorithm>
+#include <vector>
+
+#include "RequestHandler.h"
+
+struct SceneItemChange {
+	OBSSceneItemAutoRelease SceneItem;
+	obs_transform_info Info;
+	obs_sceneitem_crop Crop;
+	bool TransformChanged = false;
+	bool CropChanged = false;
+	bool EnabledChanged = false;
+	bool Enabled = false;
+};
+
+static const char *BoundsTypeNames[] = {
+	"OBS_BOUNDS_NONE",
+	"OBS_BOUNDS_STRETCH",
+	"OBS_BOUNDS_SCALE_INNER",
+	"OBS_BOUNDS_SCALE_OUTER",
+	"OBS_BOUNDS_SCALE_TO_WIDTH",
+	"OBS_BOUNDS_SCALE_TO_HEIGHT",
+	"OBS_BOUNDS_MAX_ONLY",
+};
+
+static QJsonObject SceneItemTransformToJson(obs_sceneitem_t *sceneItem)
+{
+	obs_transform_info info;
+	obs_sceneitem_get_info(sceneItem, &info);
+	obs_sceneitem_crop crop;
+	obs_sceneitem_get_crop(sceneItem, &crop);
+	obs_source_t *source = obs_sceneitem_get_source(sceneItem);
+
+	QJsonObject ret;
+	ret["positionX"] = info.pos.x;
+	ret["positionY"] = info.pos.y;
+	ret["rotation"] = info.rot;
+	ret["scaleX"] = info.scale.x;
+	ret["scaleY"] = info.scale.y;
+	ret["alignment"] = (int)info.alignment;
+	ret["boundsType"] = (size_t)info.bounds_type < sizeof(BoundsTypeNames) / sizeof(BoundsTypeNames[0]) ? BoundsTypeNames[info.bounds_type] : "OBS_BOUNDS_NONE";
+	ret["boundsAlignment"] = (int)info.bounds_alignment;
+	ret["boundsWidth"] = info.bounds.x;
+	ret["boundsHeight"] = info.bounds.y;
+	ret["cropLeft"] = crop.left;
+	ret["cropRight"] = crop.right;
+	ret["cropTop"] = crop.top;
+	ret["cropBottom"] = crop.bottom;
+	ret["sourceWidth"] = (int)obs_source_get_width(source);
+	ret["sourceHeight"] = (int)obs_source_get_height(source);
+	return ret;
+}
+
+// Overlays the transform fields present in `transformJson` onto `change`
+static RequestStatus ParseSceneItemTransform(const QJsonObject &transformJson, SceneItemChange &change, QString &comment)
+{
+	struct NumberField {
+		const char *Name;
+		float *Value;
+		double Min;
+		double Max;
+	};
+	NumberField numberFields[] = {
+		{"positionX", &change.Info.pos.x, -90001.0, 90001.0},
+		{"positionY", &change.Info.pos.y, -90001.0, 90001.0},
+		{"rotation", &change.Info.rot, -360.0, 360.0},
+		{"scaleX", &change.Info.scale.x, -90001.0, 90001.0},
+		{"scaleY", &change.Info.scale.y, -90001.0, 90001.0},
+		{"boundsWidth", &change.Info.bounds.x, 0.0, 90001.0},
+		{"boundsHeight", &change.Info.bounds.y, 0.0, 90001.0},
+	};
+	for (auto &field : numberFields) {
+		if (!transformJson.contains(field.Name))
+			continue;
+		QJsonValue value = transformJson[field.Name];
+		if (!value.isDouble()) {
+			comment = QString("`%1` must be a number.").arg(field.Name);
+			return RequestStatus::InvalidRequestParameterDataType;
+		}
+		if (value.toDouble() < field.Min || value.toDouble() > field.Max) {
+			comment = QString("`%1` must be within %2 and %3.").arg(field.Name).arg(field.Min).arg(field.Max);
+			return RequestStatus::RequestParameterOutOfRange;
+		}
+		*field.Value = (float)value.toDouble();
+		change.TransformChanged = true;
+	}
+
+	struct AlignmentField {
+		const char *Name;
+		uint32_t *Value;
+	};
+	AlignmentField alignmentFields[] = {
+		{"alignment", &change.Info.alignment},
+		{"boundsAlignment", &change.Info.bounds_alignment},
+	};
+	for (auto &field : alignmentFields) {
+		if (!transformJson.contains(field.Name))
+			continue;
+		QJsonValue value = transformJson[field.Name];
+		if (!value.isDouble()) {
+			comment = QString("`%1` must be a number.").arg(field.Name);
+			return RequestStatus::InvalidRequestParameterDataType;
+		}
+		// Any combination of the OBS_ALIGN_* flags
+		if (value.toInt(-1) < 0 || value.toInt(-1) > 15) {
+			comment = QString("`%1` must be a combination of the OBS_ALIGN_* flags (0-15).").arg(field.Name);
+			return RequestStatus::RequestParameterOutOfRange;
+		}
+		*field.Value = (uint32_t)value.toInt();
+		change.TransformChanged = true;
+	}
+
+	if (transformJson.contains("boundsType")) {
+		QJsonValue value = transformJson["boundsType"];
+		if (!value.isString()) {
+			comment = "`boundsType` must be a string.";
+			return RequestStatus::InvalidRequestParameterDataType;
+		}
+		size_t boundsTypeCount = sizeof(BoundsTypeNames) / sizeof(BoundsTypeNames[0]);
+		size_t boundsType = 0;
+		while (boundsType < boundsTypeCount && value.toString() != BoundsTypeNames[boundsType])
+			boundsType++;
+		if (boundsType == boundsTypeCount) {
+			comment = QString("`%1` is not a valid bounds type.").arg(value.toString());
+			return RequestStatus::InvalidRequestParameter;
+		}
+		change.Info.bounds_type = (enum obs_bounds_type)boundsType;
+		change.TransformChanged = true;
+	}
+
+	struct CropField {
+		const char *Name;
+		int *Value;
+	};
+	CropField cropFields[] = {
+		{"cropLeft", &change.Crop.left},
+		{"cropRight", &change.Crop.right},
+		{"cropTop", &change.Crop.top},
+		{"cropBottom", &change.Crop.bottom},
+	};
+	for (auto &field : cropFields) {
+		if (!transformJson.contains(field.Name))
+			continue;
+		QJsonValue value = transformJson[field.Name];
+		if (!value.isDouble()) {
+			comment = QString("`%1` must be a number.").arg(field.Name);
+			return RequestStatus::InvalidRequestParameterDataType;
+		}
+		if (value.toDouble() < 0 || value.toDouble() > 100000) {
+			comment = QString("`%1` must be within 0 and 100000.").arg(field.Name);
+			return RequestStatus::RequestParameterOutOfRange;
+		}
+		*field.Value = value.toInt();
+		change.CropChanged = true;
+	}
+
+	return RequestStatus::NoError;
+}
+
+// Runs with the scene locked, so the render thread sees either none or all of the changes
+static void ApplySceneItemChanges(void *param, obs_scene_t *)
+{
+	auto changes = static_cast<std::vector<SceneItemChange>*>(param);
+
+	// Deferring keeps each item from recomputing its transform once per setter
+	for (auto &change : *changes)
+		obs_sceneitem_defer_update_begin(change.SceneItem);
+
+	for (auto &change : *changes) {
+		if (change.TransformChanged)
+			obs_sceneitem_set_info(change.SceneItem, &change.Info);
+		if (change.CropChanged)
+			obs_sceneitem_set_crop(change.SceneItem, &change.Crop);
+		if (change.EnabledChanged)
+			obs_sceneitem_set_visible(change.SceneItem, change.Enabled);
+	}
+
+	for (auto &change : *changes)
+		obs_sceneitem_defer_update_end(change.SceneItem);
+}
+
+RequestResult RequestHandler::GetSceneItemList(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = request.ValidateString("sceneName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	OBSSourceAutoRelease sceneSource = obs_get_source_by_name(QT_TO_UTF8(request.RequestData()["sceneName"].toString()));
+	if (!sceneSource)
+		return RequestResult::BuildFailure(request, RequestStatus::SceneNotFound);
+
+	obs_scene_t *scene = obs_scene_from_source(sceneSource);
+	if (!scene)
+		return RequestResult::BuildFailure(request, RequestStatus::InvalidSourceType, "The specified source is not a scene.");
+
+	QJsonArray sceneItems;
+	obs_scene_enum_items(scene, [](obs_scene_t *, obs_sceneitem_t *sceneItem, void *param) {
+		auto sceneItems = static_cast<QJsonArray*>(param);
+		obs_source_t *source = obs_sceneitem_get_source(sceneItem);
+
+		QJsonObject sceneItemJson;
+		sceneItemJson["sceneItemId"] = (double)obs_sceneitem_get_id(sceneItem);
+		sceneItemJson["sourceName"] = obs_source_get_name(source);
+		sceneItemJson["sourceKind"] = obs_source_get_id(source);
+		sceneItemJson["sceneItemEnabled"] = obs_sceneitem_visible(sceneItem);
+		sceneItemJson["sceneItemLocked"] = obs_sceneitem_locked(sceneItem);
+		sceneItemJson["sceneItemTransform"] = SceneItemTransformToJson(sceneItem);
+		sceneItems->append(sceneItemJson);
+		return true;
+	}, &sceneItems);
+
+	QJsonObject resultJson;
+	resultJson["sceneItems"] = sceneItems;
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::SetSceneItemTransforms(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = request.ValidateString("sceneName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	checkStatus = request.ValidateArray("sceneItems", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	OBSSourceAutoRelease sceneSource = obs_get_source_by_name(QT_TO_UTF8(request.RequestData()["sceneName"].toString()));
+	if (!sceneSource)
+		return RequestResult::BuildFailure(request, RequestStatus::SceneNotFound);
+
+	obs_scene_t *scene = obs_scene_from_source(sceneSource);
+	if (!scene)
+		return RequestResult::BuildFailure(request, RequestStatus::InvalidSourceType, "The specified source is not a scene.");
+
+	// Everything is resolved and validated up front, so a bad entry leaves the scene untouched
+	std::vector<SceneItemChange> changes;
+	QJsonArray sceneItemsJson = request.RequestData()["sceneItems"].toArray();
+	changes.reserve(sceneItemsJson.size());
+	for (int i = 0; i < sceneItemsJson.size(); i++) {
+		if (!sceneItemsJson[i].isObject())
+			return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameterDataType, "Parameter: sceneItems\nAll scene items must be objects.");
+		QJsonObject sceneItemJson = sceneItemsJson[i].toObject();
+
+		obs_sceneitem_t *sceneItem = nullptr;
+		if (sceneItemJson["sceneItemId"].isDouble())
+			sceneItem = obs_scene_find_sceneitem_by_id(scene, (int64_t)sceneItemJson["sceneItemId"].toDouble());
+		else if (sceneItemJson["sourceName"].isString())
+			sceneItem = obs_scene_find_source(scene, QT_TO_UTF8(sceneItemJson["sourceName"].toString()));
+		else
+			return RequestResult::BuildFailure(request, RequestStatus::MissingRequestParameter, QString("Parameter: sceneItems\nScene item %1 requires a `sceneItemId` number or a `sourceName` string.").arg(i));
+		if (!sceneItem)
+			return RequestResult::BuildFailure(request, RequestStatus::SceneItemNotFound, QString("Parameter: sceneItems\nScene item %1 was not found in the scene.").arg(i));
+
+		// Repeated entries for one item are merged in request order
+		auto change = std::find_if(changes.begin(), changes.end(), [sceneItem](const SceneItemChange &candidate) {
+			return candidate.SceneItem.Get() == sceneItem;
+		});
+		if (change == changes.end()) {
+			obs_sceneitem_addref(sceneItem);
+			changes.emplace_back();
+			change = changes.end() - 1;
+			change->SceneItem = sceneItem;
+			obs_sceneitem_get_info(sceneItem, &change->Info);
+			obs_sceneitem_get_crop(sceneItem, &change->Crop);
+		}
+
+		if (sceneItemJson.contains("sceneItemEnabled")) {
+			if (!sceneItemJson["sceneItemEnabled"].isBool())
+				return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameterDataType, QString("Parameter: sceneItems\nScene item %1: `sceneItemEnabled` must be a boolean.").arg(i));
+			change->Enabled = sceneItemJson["sceneItemEnabled"].toBool();
+			change->EnabledChanged = true;
+		}
+
+		if (sceneItemJson.contains("sceneItemTransform")) {
+			if (!sceneItemJson["sceneItemTransform"].isObject())
+				return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameterDataType, QString("Parameter: sceneItems\nScene item %1: `sceneItemTransform` must be an object.").arg(i));
+			checkStatus = ParseSceneItemTransform(sceneItemJson["sceneItemTransform"].toObject(), *change, comment);
+			if (checkStatus != RequestStatus::NoError)
+				return RequestResult::BuildFailure(request, checkStatus, QString("Parameter: sceneItems\nScene item %1: %2").arg(i).arg(comment));
+		}
+	}
+
+	if (!changes.empty())
+		obs_scene_atomic_update(scene, ApplySceneItemChanges, &changes);
+
+	QJsonObject resultJson;
+	resultJson["sceneItemsChanged"] = (int)changes.size();
+	return RequestResult::BuildSuccess(request, resultJson);
+}
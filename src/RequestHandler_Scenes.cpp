@@ -1,20 +1,80 @@
-#include "RequestHandler.h"
-
-RequestResult RequestHandler::SetCurrentProgramScene(const Request& request)
-{
-	QString comment;
-	RequestStatus checkStatus = request.ValidateString("sceneName", &comment);
-	if (checkStatus != RequestStatus::NoError)
-		return RequestResult::BuildFailure(request, checkStatus, comment);
-
-	QString sceneName = request.RequestData()["sceneName"].toString();
-
-	OBSSourceAutoRelease sceneSource = obs_get_source_by_name(QT_TO_UTF8(sceneName));
-
-	if (!sceneSource)
-		return RequestResult::BuildFailure(request, RequestStatus::SceneNotFound);
-
-	obs_frontend_set_current_scene(sceneSource);
-
-	return RequestResult::BuildSuccess(request);
+#include "RequestHandler.h"
+#include "stats/SceneSwitchTracker.h"
+
+RequestResult RequestHandler::SetCurrentProgramScene(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = request.ValidateString("sceneName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	QString sceneName = request.RequestData()["sceneName"].toString();
+
+	OBSSourceAutoRelease sceneSource = obs_get_source_by_name(QT_TO_UTF8(sceneName));
+
+	if (!sceneSource)
+		return RequestResult::BuildFailure(request, RequestStatus::SceneNotFound);
+
+	// The transition and duration only apply to this switch
+	OBSSourceAutoRelease transition;
+	checkStatus = request.ValidateString("transitionName", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		transition = UtilsGetTransitionByName(request.RequestData()["transitionName"].toString());
+		if (!transition)
+			return RequestResult::BuildFailure(request, RequestStatus::TransitionNotFound);
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	int transitionDuration = -1;
+	checkStatus = request.ValidateDouble("transitionDuration", &comment, 50, 20000);
+	if (checkStatus == RequestStatus::NoError) {
+		if (!transition)
+			transition = obs_frontend_get_current_transition();
+		if (transition && obs_transition_fixed(transition))
+			return RequestResult::BuildFailure(request, RequestStatus::TransitionDurationFixed, "The transition does not support a custom duration.");
+		transitionDuration = request.RequestData()["transitionDuration"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	bool waitForTransition = false;
+	checkStatus = request.ValidateBool("waitForTransition", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		waitForTransition = request.RequestData()["waitForTransition"].toBool();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	int timeout = 15000;
+	checkStatus = request.ValidateDouble("timeout", &comment, 100, 60000);
+	if (checkStatus == RequestStatus::NoError) {
+		timeout = request.RequestData()["timeout"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	auto sceneSwitchTracker = GetSceneSwitchTracker();
+	if (transition)
+		sceneSwitchTracker->PrefetchTransitionMedia(transition);
+	uint64_t switchId = sceneSwitchTracker->SwitchScene(sceneSource, request.ReceivedAt(), transition, transitionDuration);
+
+	QJsonObject resultJson;
+	if (!waitForTransition) {
+		resultJson["sceneSwitchId"] = (double)switchId;
+		return RequestResult::BuildSuccess(request, resultJson);
+	}
+
+	SceneSwitch sceneSwitch = sceneSwitchTracker->WaitForTransitionEnd(switchId, timeout);
+	if (!sceneSwitch.Id)
+		return RequestResult::BuildFailure(request, RequestStatus::RequestProcessingFailed, "The scene switch is no longer tracked.");
+	// A switch to the scene already on program finishes right away, so this one raced another switch to the same scene
+	if (!sceneSwitch.SceneChangedAt)
+		return RequestResult::BuildFailure(request, RequestStatus::RequestProcessingFailed, QString("The frontend did not switch the scene within %1ms.").arg(timeout));
+	// An interrupted switch still returns its timings, with `interrupted` set
+	if (!sceneSwitch.TransitionEndedAt && !sceneSwitch.Interrupted)
+		return RequestResult::BuildFailure(request, RequestStatus::RequestProcessingFailed, QString("The transition did not end within %1ms.").arg(timeout));
+
+	resultJson["sceneSwitch"] = SceneSwitchTracker::SwitchToJson(sceneSwitch);
+	return RequestResult::BuildSuccess(request, resultJson);
 }
\ No newline at end of file
@@ -1 +1,196 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include "RequestHandler.h"
+
+namespace SourceListField {
+	enum SourceListField {
+		SourceKind = (1 << 0),
+		SourceType = (1 << 1),
+		SourceWidth = (1 << 2),
+		SourceHeight = (1 << 3),
+		SourceActive = (1 << 4),
+		SourceShowing = (1 << 5),
+		SourceEnabled = (1 << 6),
+		InputMuted = (1 << 7),
+		InputVolumeDb = (1 << 8),
+		FilterCount = (1 << 9),
+	};
+}
+
+static const struct {
+	const char *Name;
+	uint32_t Flag;
+} SourceListFields[] = {
+	{"sourceKind", SourceListField::SourceKind},
+	{"sourceType", SourceListField::SourceType},
+	{"sourceWidth", SourceListField::SourceWidth},
+	{"sourceHeight", SourceListField::SourceHeight},
+	{"sourceActive", SourceListField::SourceActive},
+	{"sourceShowing", SourceListField::SourceShowing},
+	{"sourceEnabled", SourceListField::SourceEnabled},
+	{"inputMuted", SourceListField::InputMuted},
+	{"inputVolumeDb", SourceListField::InputVolumeDb},
+	{"filterCount", SourceListField::FilterCount},
+};
+
+struct SourceListEntry {
+	// UTF-8, so the page order is a plain byte order that every client can reproduce
+	QByteArray Name;
+	OBSSourceAutoRelease Source;
+};
+
+struct SourceListFilter {
+	bool Inputs = true;
+	bool Scenes = true;
+	QByteArray SourceKind;
+	QByteArray NamePrefix;
+	// Only names after the cursor are collected
+	QByteArray After;
+	size_t TotalCount = 0;
+	std::vector<SourceListEntry> Entries;
+};
+
+static bool CollectSource(void *param, obs_source_t *source)
+{
+	auto filter = static_cast<SourceListFilter*>(param);
+
+	const char *name = obs_source_get_name(source);
+	if (!name)
+		return true;
+	if (!filter->NamePrefix.isEmpty() && strncmp(name, filter->NamePrefix.constData(), filter->NamePrefix.size()) != 0)
+		return true;
+	if (!filter->SourceKind.isEmpty() && filter->SourceKind != obs_source_get_id(source))
+		return true;
+
+	filter->TotalCount++;
+	if (!filter->After.isEmpty() && strcmp(name, filter->After.constData()) <= 0)
+		return true;
+
+	obs_source_addref(source);
+	filter->Entries.push_back({QByteArray(name), OBSSourceAutoRelease(source)});
+	return true;
+}
+
+RequestResult RequestHandler::GetSourceList(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+	SourceListFilter filter;
+
+	checkStatus = request.ValidateString("sourceType", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		QString sourceType = request.RequestData()["sourceType"].toString();
+		if (sourceType != "input" && sourceType != "scene")
+			return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameter, "Parameter: sourceType\nMust be `input` or `scene`.");
+		filter.Inputs = sourceType == "input";
+		filter.Scenes = sourceType == "scene";
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	checkStatus = request.ValidateString("sourceKind", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		filter.SourceKind = request.RequestData()["sourceKind"].toString().toUtf8();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	checkStatus = request.ValidateString("namePrefix", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		filter.NamePrefix = request.RequestData()["namePrefix"].toString().toUtf8();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	// The cursor is the last name of the previous page. Sources added or removed between pages shift nothing.
+	checkStatus = request.ValidateString("cursor", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		filter.After = QByteArray::fromBase64(request.RequestData()["cursor"].toString().toLatin1(), QByteArray::Base64UrlEncoding);
+		if (filter.After.isEmpty())
+			return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameter, "Parameter: cursor\nThe cursor is not valid.");
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	size_t limit = 100;
+	checkStatus = request.ValidateDouble("limit", &comment, 1, 1000);
+	if (checkStatus == RequestStatus::NoError) {
+		limit = (size_t)request.RequestData()["limit"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	uint32_t fields = SourceListField::SourceKind | SourceListField::SourceType;
+	checkStatus = request.ValidateArray("fields", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		fields = 0;
+		for (auto fieldValue : request.RequestData()["fields"].toArray()) {
+			QString fieldName = fieldValue.toString();
+			auto field = std::find_if(std::begin(SourceListFields), std::end(SourceListFields), [&fieldName](const decltype(SourceListFields[0]) &candidate) {
+				return fieldName == candidate.Name;
+			});
+			if (field == std::end(SourceListFields))
+				return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameter, QString("Parameter: fields\n`%1` is not a known field.").arg(fieldName));
+			fields |= field->Flag;
+		}
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	// One pass per source list. Only the matches after the cursor are kept, and only one page of them is sorted.
+	if (filter.Inputs)
+		obs_enum_sources(CollectSource, &filter);
+	if (filter.Scenes)
+		obs_enum_scenes(CollectSource, &filter);
+
+	size_t pageSize = std::min(limit, filter.Entries.size());
+	auto byName = [](const SourceListEntry &a, const SourceListEntry &b) {
+		return a.Name < b.Name;
+	};
+	std::partial_sort(filter.Entries.begin(), filter.Entries.begin() + pageSize, filter.Entries.end(), byName);
+
+	QJsonArray sources;
+	for (size_t i = 0; i < pageSize; i++) {
+		obs_source_t *source = filter.Entries[i].Source;
+
+		QJsonObject sourceJson;
+		sourceJson["sourceName"] = QString::fromUtf8(filter.Entries[i].Name);
+		if (fields & SourceListField::SourceKind)
+			sourceJson["sourceKind"] = obs_source_get_id(source);
+		if (fields & SourceListField::SourceType)
+			sourceJson["sourceType"] = obs_source_is_scene(source) ? "scene" : "input";
+		if (fields & SourceListField::SourceWidth)
+			sourceJson["sourceWidth"] = (int)obs_source_get_width(source);
+		if (fields & SourceListField::SourceHeight)
+			sourceJson["sourceHeight"] = (int)obs_source_get_height(source);
+		if (fields & SourceListField::SourceActive)
+			sourceJson["sourceActive"] = obs_source_active(source);
+		if (fields & SourceListField::SourceShowing)
+			sourceJson["sourceShowing"] = obs_source_showing(source);
+		if (fields & SourceListField::SourceEnabled)
+			sourceJson["sourceEnabled"] = obs_source_enabled(source);
+
+		bool hasAudio = (obs_source_get_output_flags(source) & OBS_SOURCE_AUDIO) != 0;
+		if ((fields & SourceListField::InputMuted) && hasAudio)
+			sourceJson["inputMuted"] = obs_source_muted(source);
+		if ((fields & SourceListField::InputVolumeDb) && hasAudio) {
+			double volumeDb = obs_mul_to_db(obs_source_get_volume(source));
+			if (volumeDb == -INFINITY)
+				volumeDb = -100.0;
+			sourceJson["inputVolumeDb"] = volumeDb;
+		}
+		if (fields & SourceListField::FilterCount)
+			sourceJson["filterCount"] = (int)obs_source_filter_count(source);
+
+		sources.append(sourceJson);
+	}
+
+	QJsonObject resultJson;
+	resultJson["sources"] = sources;
+	resultJson["totalCount"] = (double)filter.TotalCount;
+	if (pageSize && filter.Entries.size() > pageSize)
+		resultJson["nextCursor"] = QString::fromLatin1(filter.Entries[pageSize - 1].Name.toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals));
+	return RequestResult::BuildSuccess(request, resultJson);
+}
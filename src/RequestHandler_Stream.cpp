@@ -2,15 +2,29 @@
 #include <QMainWindow>
 
 #include "RequestHandler.h"
+#include "stats/OutputStatsSampler.h"
+#include "stats/StreamSupervisor.h"
 
 RequestResult RequestHandler::GetStreamStatus(const Request& request)
 {
+	QString comment;
+	RequestStatus checkStatus = request.ValidateFieldMask(&comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
 	QJsonObject resultJson;
 
 	OBSOutputAutoRelease streamOutput = obs_frontend_get_streaming_output();
-	resultJson["outputActive"] = obs_output_active(streamOutput);
-	resultJson["outputTimecode"] = UtilsGetOutputTimecode(streamOutput);
-	resultJson["outputDuration"] = (qint64)UtilsGetOutputDuration(streamOutput);
+	if (request.WantsField("outputActive"))
+		resultJson["outputActive"] = obs_output_active(streamOutput);
+	if (request.WantsField("outputTimecode"))
+		resultJson["outputTimecode"] = UtilsGetOutputTimecode(streamOutput);
+	if (request.WantsField("outputDuration"))
+		resultJson["outputDuration"] = (qint64)UtilsGetOutputDuration(streamOutput);
+	if (request.WantsField("outputStats"))
+		resultJson["outputStats"] = GetOutputStatsSampler()->GetOutputStats("stream");
+	if (request.WantsField("startAttempt"))
+		resultJson["startAttempt"] = GetStreamSupervisor()->GetLatestAttempt();
 
 	return RequestResult::BuildSuccess(request, resultJson);
 }
@@ -20,9 +34,53 @@ RequestResult RequestHandler::StartStream(const Request& request)
 	if (obs_frontend_streaming_active())
 		return RequestResult::BuildFailure(request, RequestStatus::StreamRunning);
 
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+
+	bool waitForActive = false;
+	checkStatus = request.ValidateBool("waitForActive", &comment);
+	if (checkStatus == RequestStatus::NoError) {
+		waitForActive = request.RequestData()["waitForActive"].toBool();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	int timeout = 15000;
+	checkStatus = request.ValidateDouble("timeout", &comment, 100, 60000);
+	if (checkStatus == RequestStatus::NoError) {
+		timeout = request.RequestData()["timeout"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	auto streamSupervisor = GetStreamSupervisor();
+	uint64_t previousAttemptId = streamSupervisor->BeginStart();
+
 	obs_frontend_streaming_start();
 
-	return RequestResult::BuildSuccess(request);
+	if (!waitForActive)
+		return RequestResult::BuildSuccess(request);
+
+	StreamStartAttempt attempt = streamSupervisor->WaitForActive(previousAttemptId, timeout);
+	if (!attempt.Id)
+		return RequestResult::BuildFailure(request, RequestStatus::OutputStartFailed, QString("The stream did not begin starting within %1ms.").arg(timeout));
+
+	if (attempt.StoppedAt && !attempt.FirstFrameAt) {
+		QString reason = StreamSupervisor::StopCodeName(attempt.StopCode);
+		OBSOutputAutoRelease streamOutput = obs_frontend_get_streaming_output();
+		const char *lastError = streamOutput ? obs_output_get_last_error(streamOutput) : nullptr;
+		if (lastError && *lastError)
+			reason += QString(": %1").arg(lastError);
+		return RequestResult::BuildFailure(request, RequestStatus::OutputStartFailed, QString("The stream stopped before it became active (%1).").arg(reason));
+	}
+
+	// Connected but without data yet still counts as active, the attempt shows which phase was reached
+	if (!attempt.ConnectedAt)
+		return RequestResult::BuildFailure(request, RequestStatus::OutputStartFailed, QString("The stream did not connect within %1ms.").arg(timeout));
+
+	QJsonObject resultJson;
+	resultJson["startAttempt"] = StreamSupervisor::AttemptToJson(attempt);
+	return RequestResult::BuildSuccess(request, resultJson);
 }
 
 RequestResult RequestHandler::StopStream(const Request& request)
@@ -35,6 +93,11 @@ RequestResult RequestHandler::StopStream(const Request& request)
 	return RequestResult::BuildSuccess(request);
 }
 
+RequestResult RequestHandler::GetStreamStartHistory(const Request& request)
+{
+	return RequestResult::BuildSuccess(request, GetStreamSupervisor()->GetHistory());
+}
+
 RequestResult RequestHandler::GetStreamServiceSettings(const Request& request)
 {
 	QJsonObject resultJson;
@@ -0,0 +1,57 @@
+#include "RequestHandler.h"
+#include "FileTransfers.h"
+
+RequestResult RequestHandler::GetFileTransferList(const Request& request)
+{
+	QJsonObject resultJson;
+	resultJson["transfers"] = GetFileTransfers()->GetTransfers();
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::CancelFileTransfer(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = request.ValidateDouble("transferId", &comment, 1);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	// Finished transfers are forgotten right away, so cancelling one is reported like any unknown ID
+	if (!GetFileTransfers()->CancelTransfer((uint32_t)request.RequestData()["transferId"].toDouble()))
+		return RequestResult::BuildFailure(request, RequestStatus::InvalidRequestParameter, "Parameter: transferId\nNo transfer with that ID is running.");
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::GetFileTransferSettings(const Request& request)
+{
+	FileTransferSettings settings = GetFileTransfers()->GetSettings();
+
+	QJsonObject resultJson;
+	resultJson["maxBandwidth"] = settings.MaxBandwidth;
+
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::SetFileTransferSettings(const Request& request)
+{
+	auto fileTransfers = GetFileTransfers();
+	FileTransferSettings settings = fileTransfers->GetSettings();
+
+	QString comment;
+	RequestStatus checkStatus = RequestStatus::NoError;
+
+	// Kilobits per second, 0 to remove the cap
+	checkStatus = request.ValidateDouble("maxBandwidth", &comment, 0, 1000000);
+	if (checkStatus == RequestStatus::NoError) {
+		settings.MaxBandwidth = request.RequestData()["maxBandwidth"].toInt();
+	} else if (checkStatus != RequestStatus::MissingRequestParameter) {
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+	}
+
+	if (settings.MaxBandwidth && settings.MaxBandwidth < 256)
+		return RequestResult::BuildFailure(request, RequestStatus::RequestParameterOutOfRange, "Parameter: maxBandwidth\nThe cap must be 0 or at least 256 kbps.");
+
+	fileTransfers->SetSettings(settings);
+
+	return RequestResult::BuildSuccess(request);
+}
@@ -1 +1,69 @@
 #include "RequestHandler.h"
+#include "stats/SceneSwitchTracker.h"
+
+RequestResult RequestHandler::GetSceneTransitionList(const Request& request)
+{
+	OBSSourceAutoRelease currentTransition = obs_frontend_get_current_transition();
+
+	QJsonArray transitions;
+	struct obs_frontend_source_list transitionList = {};
+	obs_frontend_get_transitions(&transitionList);
+	for (size_t i = 0; i < transitionList.sources.num; i++) {
+		obs_source_t *transition = transitionList.sources.array[i];
+		QJsonObject transitionJson;
+		transitionJson["transitionName"] = obs_source_get_name(transition);
+		transitionJson["transitionKind"] = obs_source_get_id(transition);
+		transitionJson["transitionFixed"] = obs_transition_fixed(transition);
+		transitionJson["transitionConfigurable"] = obs_source_configurable(transition);
+		transitions.append(transitionJson);
+	}
+	obs_frontend_source_list_free(&transitionList);
+
+	QJsonObject resultJson;
+	if (currentTransition) {
+		resultJson["currentSceneTransitionName"] = obs_source_get_name(currentTransition);
+		resultJson["currentSceneTransitionKind"] = obs_source_get_id(currentTransition);
+		resultJson["currentSceneTransitionFixed"] = obs_transition_fixed(currentTransition);
+	}
+	resultJson["transitionDuration"] = obs_frontend_get_transition_duration();
+	resultJson["transitions"] = transitions;
+	return RequestResult::BuildSuccess(request, resultJson);
+}
+
+RequestResult RequestHandler::SetCurrentSceneTransition(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = request.ValidateString("transitionName", &comment);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	OBSSourceAutoRelease transition = UtilsGetTransitionByName(request.RequestData()["transitionName"].toString());
+	if (!transition)
+		return RequestResult::BuildFailure(request, RequestStatus::TransitionNotFound);
+
+	obs_frontend_set_current_transition(transition);
+	GetSceneSwitchTracker()->PrefetchTransitionMedia(transition);
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::SetCurrentSceneTransitionDuration(const Request& request)
+{
+	QString comment;
+	RequestStatus checkStatus = request.ValidateDouble("transitionDuration", &comment, 50, 20000);
+	if (checkStatus != RequestStatus::NoError)
+		return RequestResult::BuildFailure(request, checkStatus, comment);
+
+	OBSSourceAutoRelease transition = obs_frontend_get_current_transition();
+	if (transition && obs_transition_fixed(transition))
+		return RequestResult::BuildFailure(request, RequestStatus::TransitionDurationFixed, "The current transition does not support a custom duration.");
+
+	obs_frontend_set_transition_duration(request.RequestData()["transitionDuration"].toInt());
+
+	return RequestResult::BuildSuccess(request);
+}
+
+RequestResult RequestHandler::GetSceneSwitchHistory(const Request& request)
+{
+	return RequestResult::BuildSuccess(request, GetSceneSwitchTracker()->GetHistory());
+}
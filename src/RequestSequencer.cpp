@@ -0,0 +1,66 @@
+#include "RequestSequencer.h"
+
+RequestSequencer::RequestSequencer(WorkerPool *workerPool) :
+	_workerPool(workerPool),
+	_submittedTasks(0),
+	_deferredTasks(0),
+	_maxLaneDepth(0)
+{
+}
+
+void RequestSequencer::Submit(const QString &laneKey, std::function<void()> task)
+{
+	_submittedTasks++;
+
+	{
+		QMutexLocker locker(&_lanesMutex);
+		auto lane = _lanes.find(laneKey);
+		if (lane != _lanes.end()) {
+			// The lane is busy, the task is started by the lane once everything before it has finished
+			lane->enqueue(task);
+			_deferredTasks++;
+
+			uint64_t laneDepth = lane->size();
+			uint64_t maxLaneDepth = _maxLaneDepth.load();
+			while (laneDepth > maxLaneDepth && !_maxLaneDepth.compare_exchange_weak(maxLaneDepth, laneDepth));
+			return;
+		}
+		_lanes.insert(laneKey, QQueue<std::function<void()>>());
+	}
+
+	_RunLane(laneKey, task);
+}
+
+void RequestSequencer::_RunLane(const QString &laneKey, std::function<void()> task)
+{
+	_workerPool->Run([=]() {
+		task();
+
+		std::function<void()> nextTask;
+		{
+			QMutexLocker locker(&_lanesMutex);
+			auto lane = _lanes.find(laneKey);
+			if (lane == _lanes.end() || lane->isEmpty()) {
+				_lanes.remove(laneKey);
+				return;
+			}
+			nextTask = lane->dequeue();
+		}
+
+		_RunLane(laneKey, nextTask);
+	});
+}
+
+QJsonObject RequestSequencer::GetStats()
+{
+	QJsonObject ret;
+
+	ret["submittedTasks"] = (double)_submittedTasks;
+	ret["deferredTasks"] = (double)_deferredTasks;
+	ret["maxLaneDepth"] = (double)_maxLaneDepth;
+
+	QMutexLocker locker(&_lanesMutex);
+	ret["activeLanes"] = _lanes.size();
+
+	return ret;
+}
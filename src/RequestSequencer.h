@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QQueue>
+#include <QtCore/QString>
+#include <QJsonObject>
+
+#include "WorkerPool.h"
+
+// Runs tasks that share a lane key strictly one after another (in submission order) on the
+// worker pool, while tasks on different lanes still run in parallel. A lane only exists while
+// it has a task running or queued.
+class RequestSequencer {
+	public:
+		explicit RequestSequencer(WorkerPool *workerPool);
+
+		void Submit(const QString &laneKey, std::function<void()> task);
+
+		QJsonObject GetStats();
+
+	private:
+		void _RunLane(const QString &laneKey, std::function<void()> task);
+
+		WorkerPool *_workerPool;
+
+		QMutex _lanesMutex;
+		QHash<QString, QQueue<std::function<void()>>> _lanes;
+
+		std::atomic<uint64_t> _submittedTasks;
+		std::atomic<uint64_t> _deferredTasks;
+		std::atomic<uint64_t> _maxLaneDepth;
+};
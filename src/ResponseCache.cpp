@@ -0,0 +1,125 @@
+#include "ResponseCache.h"
+
+ResponseCache::ResponseCache() :
+	_generation(0),
+	_videoFingerprint(GetVideoFingerprint()),
+	_hits(0),
+	_misses(0),
+	_invalidations(0)
+{
+	obs_frontend_add_event_callback(ResponseCache::FrontendEventCallback, this);
+}
+
+ResponseCache::~ResponseCache()
+{
+	obs_frontend_remove_event_callback(ResponseCache::FrontendEventCallback, this);
+}
+
+RequestResult ResponseCache::Get(const QString &requestType, uint32_t dependencies, const Request &request, std::function<RequestResult()> handler)
+{
+	uint64_t generation;
+	{
+		QMutexLocker locker(&_mutex);
+		auto it = _entries.constFind(requestType);
+		if (it != _entries.constEnd()) {
+			_hits++;
+			return RequestResult::BuildSuccess(request, it->AdditionalFields, it->SerializedFields);
+		}
+		generation = _generation;
+	}
+	_misses++;
+
+	RequestResult result = handler();
+	if (result.StatusCode() != RequestStatus::Success)
+		return result;
+
+	Entry entry;
+	entry.Dependencies = dependencies;
+	entry.AdditionalFields = result.AdditionalFields();
+	entry.SerializedFields = QJsonDocument(entry.AdditionalFields).toJson(QJsonDocument::Compact);
+
+	QMutexLocker locker(&_mutex);
+	if (generation == _generation)
+		_entries.insert(requestType, entry);
+
+	return RequestResult::BuildSuccess(request, entry.AdditionalFields, entry.SerializedFields);
+}
+
+void ResponseCache::Invalidate(uint32_t dependencies)
+{
+	QMutexLocker locker(&_mutex);
+	for (auto it = _entries.begin(); it != _entries.end();) {
+		if (it->Dependencies & dependencies)
+			it = _entries.erase(it);
+		else
+			++it;
+	}
+	_generation++;
+	_invalidations++;
+}
+
+void ResponseCache::RefreshVideoFingerprint()
+{
+	VideoFingerprint videoFingerprint = GetVideoFingerprint();
+	{
+		QMutexLocker locker(&_mutex);
+		if (videoFingerprint == _videoFingerprint)
+			return;
+		_videoFingerprint = videoFingerprint;
+	}
+	Invalidate(ResponseCacheDependency::Video);
+}
+
+QJsonObject ResponseCache::GetStats()
+{
+	QJsonObject ret;
+	ret["hits"] = (double)_hits;
+	ret["misses"] = (double)_misses;
+	ret["invalidations"] = (double)_invalidations;
+
+	QMutexLocker locker(&_mutex);
+	ret["cachedResponses"] = _entries.size();
+	return ret;
+}
+
+void ResponseCache::FrontendEventCallback(enum obs_frontend_event event, void *param)
+{
+	auto responseCache = reinterpret_cast<ResponseCache*>(param);
+
+	switch (event) {
+		case OBS_FRONTEND_EVENT_PROFILE_CHANGED:
+			// A profile brings its own video settings and resets video
+			responseCache->Invalidate(ResponseCacheDependency::Profile);
+			responseCache->RefreshVideoFingerprint();
+			break;
+		case OBS_FRONTEND_EVENT_PROFILE_LIST_CHANGED:
+			responseCache->Invalidate(ResponseCacheDependency::ProfileList);
+			break;
+		case OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGED:
+			responseCache->Invalidate(ResponseCacheDependency::SceneCollection);
+			break;
+		case OBS_FRONTEND_EVENT_SCENE_COLLECTION_LIST_CHANGED:
+			responseCache->Invalidate(ResponseCacheDependency::SceneCollectionList);
+			break;
+		default:
+			break;
+	}
+}
+
+ResponseCache::VideoFingerprint ResponseCache::GetVideoFingerprint()
+{
+	config_t *config = obs_frontend_get_profile_config();
+	if (!config)
+		return VideoFingerprint();
+
+	return QString("%1x%2 %3x%4 %5 %6 %7 %8/%9")
+		.arg((qulonglong)config_get_uint(config, "Video", "BaseCX"))
+		.arg((qulonglong)config_get_uint(config, "Video", "BaseCY"))
+		.arg((qulonglong)config_get_uint(config, "Video", "OutputCX"))
+		.arg((qulonglong)config_get_uint(config, "Video", "OutputCY"))
+		.arg((qlonglong)config_get_int(config, "Video", "FPSType"))
+		.arg(config_get_string(config, "Video", "FPSCommon"))
+		.arg((qlonglong)config_get_int(config, "Video", "FPSInt"))
+		.arg((qlonglong)config_get_int(config, "Video", "FPSNum"))
+		.arg((qlonglong)config_get_int(config, "Video", "FPSDen"));
+}
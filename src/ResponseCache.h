@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <obs-frontend-api.h>
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QJsonObject>
+
+#include "rpc/Request.h"
+#include "plugin-main.h"
+
+namespace ResponseCacheDependency {
+	enum ResponseCacheDependency: uint32_t {
+		// Never invalidated while OBS runs
+		None = 0,
+		// The current profile, changed by `OBS_FRONTEND_EVENT_PROFILE_CHANGED`
+		Profile = (1 << 0),
+		// The profile names, changed by `OBS_FRONTEND_EVENT_PROFILE_LIST_CHANGED`
+		ProfileList = (1 << 1),
+		// The current scene collection, changed by `OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGED`
+		SceneCollection = (1 << 2),
+		// The scene collection names, changed by `OBS_FRONTEND_EVENT_SCENE_COLLECTION_LIST_CHANGED`
+		SceneCollectionList = (1 << 3),
+		// The profile's video settings, changed by a profile switch or from the OBS settings
+		Video = (1 << 4),
+		All = (Profile | ProfileList | SceneCollection | SceneCollectionList | Video),
+	};
+};
+
+// Keeps the successful results of parameterless requests that almost never change, together with their serialized
+// `responseData`, so a hit neither runs the handler nor serializes the data again. Entries are dropped when a
+// frontend event touches one of their dependencies. The frontend has no event for changed video settings, so the
+// profile's `Video` values are also re-read on every output stats sampler tick by `RefreshVideoFingerprint()`, and
+// entries that depend on `Video` are dropped once they changed. Lookups never read the profile config.
+class ResponseCache {
+	public:
+		ResponseCache();
+		~ResponseCache();
+
+		// Returns the cached result for `requestType`, or runs `handler` and caches its result if it succeeded
+		RequestResult Get(const QString &requestType, uint32_t dependencies, const Request &request, std::function<RequestResult()> handler);
+		void Invalidate(uint32_t dependencies);
+		// Re-reads the profile's video settings and invalidates `Video` if they changed since the last call
+		void RefreshVideoFingerprint();
+
+		QJsonObject GetStats();
+
+	private:
+		// The profile config values `GetVideoSettings` reports, which may differ from the running video (Eg. `FPSCommon`
+		// "30" and `FPSInt` 30 give the same frame rate)
+		typedef QString VideoFingerprint;
+
+		struct Entry {
+			uint32_t Dependencies = 0;
+			QJsonObject AdditionalFields;
+			QByteArray SerializedFields;
+		};
+
+		static void FrontendEventCallback(enum obs_frontend_event event, void *param);
+		static VideoFingerprint GetVideoFingerprint();
+
+		QMutex _mutex;
+		QHash<QString, Entry> _entries;
+		// Bumped by every invalidation, so that a result computed across one is not cached
+		uint64_t _generation;
+		VideoFingerprint _videoFingerprint;
+
+		std::atomic<uint64_t> _hits;
+		std::atomic<uint64_t> _misses;
+		std::atomic<uint64_t> _invalidations;
+};
+
+typedef std::shared_ptr<ResponseCache> ResponseCachePtr;
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <atomic>
+#include <string.h>
+#include <QtEndian>
+
+#include "ResponseWriter.h"
+#include "WebsocketManager.h"
+
+// Bytes the socket may have queued before fragments pause. Above the file transfer window, so that responses still
+// get through while a download keeps the socket busy.
+#define FRAGMENT_WINDOW (4 * 1024 * 1024)
+// Longest wait for the socket backlog to drain before checking that the session is still there
+#define FLOW_CONTROL_TIMEOUT 100
+// uint32 fragment index, uint8 flags
+#define FRAGMENT_HEADER_SIZE 5
+
+#define FRAGMENT_FLAG_FINAL 1
+
+static std::atomic<uint32_t> NextStreamId(0);
+
+ResponseWriter::ResponseWriter(WebsocketManager *websocketManager, WebsocketSessionPtr session) :
+	_websocketManager(websocketManager),
+	_session(session),
+	_fragmentSize(session->FragmentSize()),
+	_streamId(0),
+	_fragmentIndex(0),
+	_elementCount(0),
+	_aborted(false)
+{
+}
+
+void ResponseWriter::Write(QJsonObject message, const QString &rawKey, const QByteArray &rawValue)
+{
+	_AddChannelId(message);
+	_buffer = _Serialize(message, rawKey, rawValue);
+	_Flush(true);
+}
+
+void ResponseWriter::BeginArray(QJsonObject message, const QString &arrayKey)
+{
+	_AddChannelId(message);
+	message.remove(arrayKey);
+
+	_buffer = _SerializeOpen(message);
+	_buffer.append('"').append(arrayKey.toUtf8()).append("\":[");
+}
+
+void ResponseWriter::AppendElement(QJsonObject element, const QString &rawKey, const QByteArray &rawValue)
+{
+	if (_elementCount++)
+		_buffer.append(',');
+	_buffer.append(_Serialize(element, rawKey, rawValue));
+	_Flush(false);
+}
+
+void ResponseWriter::Finish()
+{
+	_buffer.append("]}");
+	_Flush(true);
+}
+
+void ResponseWriter::_AddChannelId(QJsonObject &message)
+{
+	// Channel 0 keeps the original envelope so that single-session relays are unaffected
+	if (_session->ChannelId() != 0)
+		message["channelId"] = _session->ChannelId();
+}
+
+QByteArray ResponseWriter::_SerializeOpen(const QJsonObject &object)
+{
+	// The members are serialized as usual, then the object is reopened
+	QByteArray ret = QJsonDocument(object).toJson(QJsonDocument::Compact);
+	ret.chop(1);
+	if (!object.isEmpty())
+		ret.append(',');
+	return ret;
+}
+
+QByteArray ResponseWriter::_Serialize(QJsonObject object, const QString &rawKey, const QByteArray &rawValue)
+{
+	if (rawValue.isEmpty())
+		return QJsonDocument(object).toJson(QJsonDocument::Compact);
+
+	object.remove(rawKey);
+	QByteArray ret = _SerializeOpen(object);
+	ret.append('"').append(rawKey.toUtf8()).append("\":").append(rawValue).append('}');
+	return ret;
+}
+
+void ResponseWriter::_Flush(bool final)
+{
+	if (_aborted) {
+		_buffer.clear();
+		return;
+	}
+
+	// Sessions without a fragment size only take text messages, which `QWebSocket` only accepts as a `QString`
+	if (!_fragmentSize) {
+		if (final) {
+			_websocketManager->SendSessionText(_session, _buffer);
+			_buffer.clear();
+		}
+		return;
+	}
+
+	int offset = 0;
+	while (!_aborted) {
+		int remaining = _buffer.size() - offset;
+		bool last = final && remaining <= _fragmentSize;
+		if (!last && remaining < _fragmentSize)
+			break;
+
+		int length = std::min(remaining, _fragmentSize);
+		_SendFragment(_buffer.constData() + offset, length, last);
+		offset += length;
+		if (last)
+			break;
+	}
+	_buffer.remove(0, offset);
+}
+
+void ResponseWriter::_SendFragment(const char *data, int length, bool final)
+{
+	if (!_streamId) {
+		_streamId = ++NextStreamId;
+		// 0 is never used as a stream ID
+		if (!_streamId)
+			_streamId = ++NextStreamId;
+	}
+
+	while (_websocketManager->GetOutgoingBytes() >= FRAGMENT_WINDOW) {
+		if (!_session->IsIdentified()) {
+			_aborted = true;
+			return;
+		}
+		_websocketManager->WaitForOutgoingBytesBelow(FRAGMENT_WINDOW, FLOW_CONTROL_TIMEOUT);
+	}
+
+	QByteArray frame(BinaryFrameHeaderSize + FRAGMENT_HEADER_SIZE + length, Qt::Uninitialized);
+	uchar *frameData = (uchar*)frame.data();
+	WriteBinaryFrameHeader(frameData, BinaryFrameType::ResponseFragment, _session->ChannelId(), _streamId);
+	qToLittleEndian<quint32>(_fragmentIndex, frameData + BinaryFrameHeaderSize);
+	frameData[BinaryFrameHeaderSize + 4] = final ? FRAGMENT_FLAG_FINAL : 0;
+	memcpy(frameData + BinaryFrameHeaderSize + FRAGMENT_HEADER_SIZE, data, length);
+
+	if (!_websocketManager->SendSessionBinary(_session->ChannelId(), frame)) {
+		_aborted = true;
+		return;
+	}
+
+	_fragmentIndex++;
+	if (final && _fragmentIndex > 1)
+		_session->IncrementFragmentedResponses(_fragmentIndex);
+}
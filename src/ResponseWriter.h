@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QJsonObject>
+
+#include "WebsocketSession.h"
+
+class WebsocketManager;
+
+// Serializes one response message into a session. A session with a fragment size gets every response as
+// `ResponseFragment` binary frames, each holding the next slice of its compact UTF-8 JSON, with the last one flagged
+// as final. A response that fits is a single final fragment, so the UTF-8 bytes are sent without being converted to
+// a `QString`. Sessions without a fragment size get one text message per response.
+// Arrays can be produced element by element, so a large batch is never held serialized in full. Any other message is
+// serialized whole and only its sending is fragmented. Each fragment waits for the socket's backlog to drop below
+// `FRAGMENT_WINDOW`, so replies from other workers get in between fragments.
+// A writer is used by a single thread, for a single message.
+class ResponseWriter {
+	public:
+		ResponseWriter(WebsocketManager *websocketManager, WebsocketSessionPtr session);
+
+		// Sends a complete message. A non-empty `rawValue` is added as its `rawKey` member without being serialized again.
+		// Keys passed separately from their object must not need escaping.
+		void Write(QJsonObject message, const QString &rawKey = QString(), const QByteArray &rawValue = QByteArray());
+
+		// Starts a message whose `arrayKey` member is appended with `AppendElement()`
+		void BeginArray(QJsonObject message, const QString &arrayKey);
+		void AppendElement(QJsonObject element, const QString &rawKey = QString(), const QByteArray &rawValue = QByteArray());
+		// Closes the array and sends the rest of the message
+		void Finish();
+
+	private:
+		void _AddChannelId(QJsonObject &message);
+		// Serializes `object` without its closing brace, ready for more members to be appended
+		static QByteArray _SerializeOpen(const QJsonObject &object);
+		// Serializes `object` with `rawValue` as its `rawKey` member
+		static QByteArray _Serialize(QJsonObject object, const QString &rawKey, const QByteArray &rawValue);
+		// Sends every full fragment in the buffer, and the remainder too when `final` is set
+		void _Flush(bool final);
+		void _SendFragment(const char *data, int length, bool final);
+
+		WebsocketManager *_websocketManager;
+		WebsocketSessionPtr _session;
+		int _fragmentSize;
+		QByteArray _buffer;
+		uint32_t _streamId;
+		uint32_t _fragmentIndex;
+		int _elementCount;
+		// Set once the session went away mid-response. The client drops a response without its final fragment.
+		bool _aborted;
+};
@@ -1,184 +1,448 @@
-#include "RequestHandler.h"
-#include "WebsocketManager.h"
-
-WebsocketManager::WebsocketManager() :
-	QObject(nullptr),
-	SessionKey(""),
-	isIdentified(false)
-{
-	qRegisterMetaType<QAbstractSocket::SocketState>();
-
-	connect(&_socket, &QWebSocket::connected, this, &WebsocketManager::onConnected);
-	connect(&_socket, &QWebSocket::disconnected, this, &WebsocketManager::onDisconnected);
-	connect(&_socket, QOverload<const QList<QSslError>&>::of(&QWebSocket::sslErrors), this, &WebsocketManager::onSslErrors);
-	connect(&_socket, &QWebSocket::textMessageReceived, this, &WebsocketManager::onTextMessageReceived);
-	connect(&_socket, &QWebSocket::stateChanged, [=]( QAbstractSocket::SocketState state ) {
-		emit connectionStateChanged(state);
-	});
-
-	_socket.moveToThread(&_workerThread);
-	this->moveToThread(&_workerThread); // This is required for some fuckshit reason
-	_workerThread.start();
-}
-
-WebsocketManager::~WebsocketManager()
-{
-	QMetaObject::invokeMethod(this, "Disconnect", Qt::BlockingQueuedConnection);
-	
-	_workerThread.quit();
-	_workerThread.wait();
-}
-
-void WebsocketManager::Connect(QString url)
-{
-	if (_socket.state() != QAbstractSocket::UnconnectedState)
-		return;
-#ifdef DEBUG_MODE
-	blog(LOG_INFO, "[WebsocketManager::Connect] Connecting to websocket server...");
-#endif
-	_socket.open(QUrl(url));
-}
-
-void WebsocketManager::Disconnect()
-{
-	if (_socket.state() == QAbstractSocket::UnconnectedState)
-		return;
-#ifdef DEBUG_MODE
-	blog(LOG_INFO, "[WebsocketManager::Disconnect] Disconnecting from websocket server...");
-#endif
-	_socket.close();
-}
-
-void WebsocketManager::SendTextMessage(QString message)
-{
-	_socket.sendTextMessage(message);
-
-#ifdef DEBUG_MODE
-			blog(LOG_INFO, "[WebsocketManager::SendTextMessage] Outgoing websocket message:\n%s\n", QT_TO_UTF8(message));
-#endif
-}
-
-void WebsocketManager::_SendIdentify()
-{
-	QJsonObject identificationObject;
-	identificationObject["messageType"] = "Identify";
-	identificationObject["sessionKey"] = SessionKey;
-	identificationObject["rpcVersion"] = PLUGIN_VERSION;
-
-	QString messageText(QJsonDocument(identificationObject).toJson());
-	QMetaObject::invokeMethod(this, "SendTextMessage", Q_ARG(QString, messageText));
-}
-
-void WebsocketManager::onConnected()
-{
-	blog(LOG_INFO, "[WebsocketManager::onConnected] Connected to websocket server. Waiting for `Hello`.");
-}
-
-void WebsocketManager::onDisconnected()
-{
-#ifdef DEBUG_MODE
-	blog(LOG_INFO, "[WebsocketManager::onDisconnected] Raw close reason: `%s` | Raw close code: %d", QT_TO_UTF8(_socket.closeReason()), _socket.closeCode());
-	blog(LOG_INFO, "[WebsocketManager::onDisconnected] Socket error string: `%s`", QT_TO_UTF8(_socket.errorString()));
-#endif
-	blog(LOG_INFO, "[WebsocketManager::onDisconnected] Disconnected from websocket server.");
-	isIdentified = false;
-}
-
-void WebsocketManager::onTextMessageReceived(QString message)
-{
-#ifdef DEBUG_MODE
-	blog(LOG_INFO, "[WebsocketManager::onTextMessageReceived] Incoming websocket message:\n%s\n", QT_TO_UTF8(message));
-#endif
-
-	QtConcurrent::run(&_threadPool, [=]() {
-		QJsonParseError error;
-		QJsonDocument j = QJsonDocument::fromJson(message.toUtf8(), &error);
-
-		if (error.error != QJsonParseError::NoError) {
-			blog(LOG_ERROR, "[WebsocketManager::onTextMessageReceived] Error parsing incoming websocket message. Error: %s", QT_TO_UTF8(error.errorString()));
-			return;
-		}
-
-		if (!j.isObject()) {
-			blog(LOG_ERROR, "[WebsocketManager::onTextMessageReceived] Incoming websocket message is not an object.");
-			return;
-		}
-
-		QJsonObject parsedMessage = j.object();
-
-		if (!parsedMessage.contains("messageType")) {
-			blog(LOG_ERROR, "[WebsocketManager::onTextMessageReceived] Incoming websocket message is missing a messageType.");
-			return;
-		}
-
-		if (parsedMessage["messageType"].toString() == "Request") {
-			if (!isIdentified)
-				return;
-
-			if (!parsedMessage.contains("requestType")) {
-				blog(LOG_ERROR, "[WebsocketManager::onTextMessageReceived] Incoming message of type `Request` is missing the `requestType` field.");
-				return;
-			}
-
-			RequestHandler handler;
-			RequestResult result = handler.ProcessIncomingMessage(parsedMessage);
-			QJsonObject resultJson = handler.GetResultJson(result);
-			resultJson["messageType"] = "RequestResponse";
-			QString resultText = QJsonDocument(resultJson).toJson();
-			QMetaObject::invokeMethod(this, "SendTextMessage", Q_ARG(QString, resultText));
-		} else if (parsedMessage["messageType"].toString() == "RequestBatch") {
-			if (!isIdentified)
-				return;
-
-			if (!parsedMessage.contains("requests")) {
-				blog(LOG_ERROR, "[WebsocketManager::onTextMessageReceived] Incoming message of type `RequestBatch` is missing the `requests` field.");
-				return;
-			}
-
-			if (!parsedMessage["requests"].isArray()) {
-				blog(LOG_ERROR, "[WebsocketManager::onTextMessageReceived] Incoming message of type `RequestBatch`'s `requests` field is not an array.");
-				return;
-			}
-
-			RequestHandler handler;
-			QJsonArray results;
-			for (auto j : parsedMessage["requests"].toArray()) {
-				QJsonObject element = j.toObject();
-				if (!element.contains("requestType"))
-					continue;
-				RequestResult result = handler.ProcessIncomingMessage(element);
-				QJsonValue resultJson = QJsonValue(handler.GetResultJson(result));
-				results.append(resultJson);
-			}
-
-			QJsonObject response;
-			response["messageType"] = "RequestBatchResponse";
-			if (parsedMessage.contains("requestId"))
-				response["requestId"] = parsedMessage["requestId"];
-			else
-				response["requestId"] = "";
-			response["results"] = results;
-
-			QString resultText = QJsonDocument(response).toJson();
-			QMetaObject::invokeMethod(this, "SendTextMessage", Q_ARG(QString, resultText));
-		} else if (parsedMessage["messageType"].toString() == "Hello") {
-#ifdef DEBUG_MODE
-			blog(LOG_INFO, "[WebsocketManager::onTextMessageReceived] `Hello` received! Sending `Identify`");
-#endif
-			_SendIdentify();
-		} else if (parsedMessage["messageType"].toString() == "Identified") {
-#ifdef DEBUG_MODE
-			blog(LOG_INFO, "[WebsocketManager::onTextMessageReceived] Received `Identified`!");
-#endif
-			isIdentified = true;
-			QMetaObject::invokeMethod(this, "connectionIdentificationSuccess");
-		} else {
-			blog(LOG_ERROR, "[WebsocketManager::onTextMessageReceived] Unhandled messageType in websocket message: `%s`.", QT_TO_UTF8(parsedMessage["messageType"].toString()));
-		}
-	});
-}
-
-void WebsocketManager::onSslErrors(const QList<QSslError> &errors)
-{
-	;
+#include <util/platform.h>
+
+#include "RequestHandler.h"
+#include "ResponseWriter.h"
+#include "WebsocketManager.h"
+
+WebsocketManager::WebsocketManager() :
+	QObject(nullptr),
+	_requestSequencer(&_workerPool),
+	_outgoingBytes(0)
+{
+	qRegisterMetaType<QAbstractSocket::SocketState>();
+	qRegisterMetaType<ConnectionState>();
+
+	connect(&_socket, &QWebSocket::connected, this, &WebsocketManager::onConnected);
+	connect(&_socket, &QWebSocket::disconnected, this, &WebsocketManager::onDisconnected);
+	connect(&_socket, QOverload<const QList<QSslError>&>::of(&QWebSocket::sslErrors), this, &WebsocketManager::onSslErrors);
+	connect(&_socket, &QWebSocket::textMessageReceived, this, &WebsocketManager::onTextMessageReceived);
+	connect(&_socket, &QWebSocket::bytesWritten, [=](qint64 bytes) {
+		// Written bytes include the websocket framing, which was never queued, so the count is kept from going negative
+		int64_t remaining = (_outgoingBytes -= bytes);
+		if (remaining < 0)
+			_outgoingBytes += -remaining;
+
+		QMutexLocker locker(&_outgoingMutex);
+		_outgoingCondition.wakeAll();
+	});
+	connect(&_socket, &QWebSocket::stateChanged, [=]( QAbstractSocket::SocketState state ) {
+		switch (state) {
+			case QAbstractSocket::HostLookupState:
+			case QAbstractSocket::ConnectingState:
+				_TransitionState(ConnectionState::Connecting);
+				break;
+			case QAbstractSocket::ConnectedState:
+				_TransitionState(ConnectionState::Handshaking);
+				break;
+			case QAbstractSocket::ClosingState:
+				_TransitionState(ConnectionState::Draining);
+				break;
+			case QAbstractSocket::UnconnectedState:
+				_TransitionState(ConnectionState::Closed);
+				break;
+			default:
+				break;
+		}
+	});
+
+	_socket.moveToThread(&_workerThread);
+	this->moveToThread(&_workerThread); // This is required for some fuckshit reason
+	_workerThread.start();
+}
+
+WebsocketManager::~WebsocketManager()
+{
+	QMetaObject::invokeMethod(this, "Disconnect", Qt::BlockingQueuedConnection);
+	
+	_workerThread.quit();
+	_workerThread.wait();
+}
+
+void WebsocketManager::Connect(QString url)
+{
+	if (_socket.state() != QAbstractSocket::UnconnectedState)
+		return;
+#ifdef DEBUG_MODE
+	blog(LOG_INFO, "[WebsocketManager::Connect] Connecting to websocket server...");
+#endif
+	_TransitionState(ConnectionState::Connecting);
+	_socket.open(QUrl(url));
+}
+
+void WebsocketManager::Disconnect()
+{
+	if (_socket.state() == QAbstractSocket::UnconnectedState)
+		return;
+#ifdef DEBUG_MODE
+	blog(LOG_INFO, "[WebsocketManager::Disconnect] Disconnecting from websocket server...");
+#endif
+	_TransitionState(ConnectionState::Draining);
+	_socket.close();
+}
+
+void WebsocketManager::SendTextMessage(QString message)
+{
+	_socket.sendTextMessage(message);
+
+#ifdef DEBUG_MODE
+			blog(LOG_INFO, "[WebsocketManager::SendTextMessage] Outgoing websocket message:\n%s\n", QT_TO_UTF8(message));
+#endif
+}
+
+void WebsocketManager::SendBinaryMessage(QByteArray message)
+{
+	_socket.sendBinaryMessage(message);
+}
+
+WebsocketSessionPtr WebsocketManager::GetSession(uint16_t channelId)
+{
+	QMutexLocker locker(&_sessionsMutex);
+	return _sessions.value(channelId);
+}
+
+QList<WebsocketSessionPtr> WebsocketManager::GetSessions()
+{
+	QMutexLocker locker(&_sessionsMutex);
+	return _sessions.values();
+}
+
+void WebsocketManager::BroadcastEvent(uint64_t requiredIntent, QString eventType, QJsonObject eventData)
+{
+	for (auto session : GetSessions()) {
+		if (!session->IsIdentified())
+			continue;
+
+		if ((session->EventSubscriptions() & requiredIntent) == 0)
+			continue;
+
+		QJsonObject eventMessage;
+		eventMessage["messageType"] = "Event";
+		eventMessage["eventType"] = eventType;
+		eventMessage["eventIntent"] = (double)requiredIntent;
+		if (!eventData.isEmpty())
+			eventMessage["eventData"] = eventData;
+		_SendSessionMessage(session, eventMessage);
+	}
+}
+
+void WebsocketManager::BroadcastBinary(uint64_t requiredIntent, BinaryFrameType frameType, uint32_t streamId, const QByteArray &payload)
+{
+	for (auto session : GetSessions()) {
+		if (!session->IsIdentified())
+			continue;
+
+		if ((session->EventSubscriptions() & requiredIntent) == 0)
+			continue;
+
+		session->IncrementOutgoingMessages();
+		QByteArray frame = BuildBinaryFrame(frameType, session->ChannelId(), streamId, payload);
+		_outgoingBytes += frame.size();
+		QMetaObject::invokeMethod(this, "SendBinaryMessage", Q_ARG(QByteArray, frame));
+	}
+}
+
+bool WebsocketManager::SendSessionBinary(uint16_t channelId, const QByteArray &frame)
+{
+	WebsocketSessionPtr session = GetSession(channelId);
+	if (!session || !session->IsIdentified())
+		return false;
+
+	session->IncrementOutgoingMessages();
+	_outgoingBytes += frame.size();
+	QMetaObject::invokeMethod(this, "SendBinaryMessage", Q_ARG(QByteArray, frame));
+	return true;
+}
+
+void WebsocketManager::SendSessionText(WebsocketSessionPtr session, const QByteArray &message)
+{
+	session->IncrementOutgoingMessages();
+	_outgoingBytes += message.size();
+	QMetaObject::invokeMethod(this, "SendTextMessage", Q_ARG(QString, QString::fromUtf8(message)));
+}
+
+bool WebsocketManager::WaitForOutgoingBytesBelow(int64_t limit, unsigned long timeout)
+{
+	// The count is re-checked with the mutex held, which the socket thread takes before waking us
+	QMutexLocker locker(&_outgoingMutex);
+	if (_outgoingBytes >= limit)
+		_outgoingCondition.wait(&_outgoingMutex, timeout);
+	return _outgoingBytes < limit;
+}
+
+void WebsocketManager::_TransitionState(ConnectionState state)
+{
+	if (!_stateMachine.Transition(state))
+		return;
+
+#ifdef DEBUG_MODE
+	blog(LOG_INFO, "[WebsocketManager::_TransitionState] Connection state is now `%s`.", ConnectionStateMachine::StateName(state));
+#endif
+
+	if (state == ConnectionState::Closed) {
+		for (auto session : GetSessions())
+			session->StateMachine().Transition(ConnectionState::Closed);
+	}
+
+	emit connectionStateChanged(state);
+}
+
+void WebsocketManager::SetSessionKeys(QString sessionKey, QStringList additionalSessionKeys)
+{
+	QMutexLocker locker(&_sessionKeysMutex);
+	_sessionKey = sessionKey;
+	_additionalSessionKeys = additionalSessionKeys;
+}
+
+void WebsocketManager::_ResetSessions()
+{
+	QString primarySessionKey;
+	QStringList additionalSessionKeys;
+	{
+		QMutexLocker keysLocker(&_sessionKeysMutex);
+		primarySessionKey = _sessionKey;
+		additionalSessionKeys = _additionalSessionKeys;
+	}
+
+	QMutexLocker locker(&_sessionsMutex);
+	_sessions.clear();
+	_sessions.insert(0, WebsocketSessionPtr(new WebsocketSession(0, primarySessionKey)));
+	uint16_t channelId = 1;
+	for (auto sessionKey : additionalSessionKeys) {
+		if (sessionKey.isEmpty())
+			continue;
+		_sessions.insert(channelId, WebsocketSessionPtr(new WebsocketSession(channelId, sessionKey)));
+		channelId++;
+	}
+
+	for (auto session : _sessions)
+		session->StateMachine().Transition(ConnectionState::Handshaking);
+}
+
+void WebsocketManager::_SendSessionMessage(WebsocketSessionPtr session, QJsonObject message)
+{
+	// Channel 0 keeps the original envelope so that single-session relays are unaffected
+	if (session->ChannelId() != 0)
+		message["channelId"] = session->ChannelId();
+
+	SendSessionText(session, QJsonDocument(message).toJson(QJsonDocument::Compact));
+}
+
+void WebsocketManager::_SendIdentify()
+{
+	_ResetSessions();
+
+	for (auto session : GetSessions()) {
+		QJsonObject identificationObject;
+		identificationObject["messageType"] = "Identify";
+		identificationObject["sessionKey"] = session->SessionKey();
+		identificationObject["rpcVersion"] = PLUGIN_VERSION;
+		_SendSessionMessage(session, identificationObject);
+	}
+}
+
+void WebsocketManager::onConnected()
+{
+	blog(LOG_INFO, "[WebsocketManager::onConnected] Connected to websocket server. Waiting for `Hello`.");
+}
+
+void WebsocketManager::onDisconnected()
+{
+#ifdef DEBUG_MODE
+	blog(LOG_INFO, "[WebsocketManager::onDisconnected] Raw close reason: `%s` | Raw close code: %d", QT_TO_UTF8(_socket.closeReason()), _socket.closeCode());
+	blog(LOG_INFO, "[WebsocketManager::onDisconnected] Socket error string: `%s`", QT_TO_UTF8(_socket.errorString()));
+#endif
+	blog(LOG_INFO, "[WebsocketManager::onDisconnected] Disconnected from websocket server.");
+	_outgoingBytes = 0;
+	_TransitionState(ConnectionState::Closed);
+	{
+		QMutexLocker locker(&_outgoingMutex);
+		_outgoingCondition.wakeAll();
+	}
+}
+
+void WebsocketManager::onTextMessageReceived(QString message)
+{
+#ifdef DEBUG_MODE
+	blog(LOG_INFO, "[WebsocketManager::onTextMessageReceived] Incoming websocket message:\n%s\n", QT_TO_UTF8(message));
+#endif
+
+	// Messages are decoded on the socket thread so that their ordering key is known before they are handed to the pool
+	QJsonParseError error;
+	QJsonDocument j = QJsonDocument::fromJson(message.toUtf8(), &error);
+
+	if (error.error != QJsonParseError::NoError) {
+		blog(LOG_ERROR, "[WebsocketManager::onTextMessageReceived] Error parsing incoming websocket message. Error: %s", QT_TO_UTF8(error.errorString()));
+		return;
+	}
+
+	if (!j.isObject()) {
+		blog(LOG_ERROR, "[WebsocketManager::onTextMessageReceived] Incoming websocket message is not an object.");
+		return;
+	}
+
+	QJsonObject parsedMessage = j.object();
+
+	if (!parsedMessage.contains("messageType")) {
+		blog(LOG_ERROR, "[WebsocketManager::onTextMessageReceived] Incoming websocket message is missing a messageType.");
+		return;
+	}
+
+	uint16_t channelId = 0;
+	if (parsedMessage.contains("channelId")) {
+		double rawChannelId = parsedMessage["channelId"].toDouble(-1);
+		if (rawChannelId < 0 || rawChannelId > UINT16_MAX || rawChannelId != (double)(uint16_t)rawChannelId) {
+			blog(LOG_ERROR, "[WebsocketManager::onTextMessageReceived] Incoming websocket message has an invalid `channelId`.");
+			return;
+		}
+		channelId = (uint16_t)rawChannelId;
+	}
+
+	QString messageType = parsedMessage["messageType"].toString();
+
+	// Session control messages (`Hello`, `Identified`, `Reidentify`, `SessionInvalidated`) are handled right here on
+	// the socket thread, in arrival order, so that `_ResetSessions()` can never race with a following `Identified`.
+	if (messageType == "Hello") {
+#ifdef DEBUG_MODE
+		blog(LOG_INFO, "[WebsocketManager::onTextMessageReceived] `Hello` received! Sending `Identify`");
+#endif
+		_SendIdentify();
+		return;
+	}
+
+	WebsocketSessionPtr session = GetSession(channelId);
+	if (!session) {
+		blog(LOG_ERROR, "[WebsocketManager::onTextMessageReceived] Incoming websocket message references unknown channel %d.", channelId);
+		return;
+	}
+
+	session->IncrementIncomingMessages();
+
+	if (messageType == "Request" || messageType == "RequestBatch") {
+		if (!session->IsIdentified())
+			return;
+
+		// Requests sharing an ordering key run one after another in arrival order. Requests that only carry a sequence
+		// number share a lane of their own per session. The sequence value itself is only echoed, never used to reorder:
+		// requests run in the order they arrived on the socket. Everything else is dispatched to the pool immediately
+		// and may complete in any order.
+		QString laneKey;
+		if (parsedMessage.contains("orderingKey")) {
+			QString orderingKey = parsedMessage["orderingKey"].toString();
+			if (orderingKey.isEmpty()) {
+				blog(LOG_ERROR, "[WebsocketManager::onTextMessageReceived] Incoming websocket message has a non-string or empty `orderingKey`.");
+				return;
+			}
+			laneKey = QString("%1:%2").arg(channelId).arg(orderingKey);
+		} else if (parsedMessage["sequence"].isDouble()) {
+			laneKey = QString("%1#seq").arg(channelId);
+		}
+
+		// Stamped before queueing, so handlers can measure from arrival rather than from dispatch
+		uint64_t receivedAt = os_gettime_ns();
+		if (!laneKey.isEmpty()) {
+			_requestSequencer.Submit(laneKey, [=]() {
+				_ProcessRequestMessage(session, parsedMessage, receivedAt);
+			});
+		} else {
+			_workerPool.Run([=]() {
+				_ProcessRequestMessage(session, parsedMessage, receivedAt);
+			});
+		}
+	} else if (messageType == "Identified" || messageType == "Reidentify") {
+#ifdef DEBUG_MODE
+		blog(LOG_INFO, "[WebsocketManager::onTextMessageReceived] Received `%s` for channel %d!", QT_TO_UTF8(messageType), channelId);
+#endif
+		if (parsedMessage["eventSubscriptions"].isDouble())
+			session->SetEventSubscriptions((uint64_t)parsedMessage["eventSubscriptions"].toDouble());
+
+		if (parsedMessage["rateLimit"].isObject()) {
+			QJsonObject rateLimit = parsedMessage["rateLimit"].toObject();
+			session->SetRateLimit(rateLimit["requestsPerSecond"].toDouble(), rateLimit["burst"].toDouble());
+		}
+
+		if (parsedMessage["fragmentSize"].isDouble())
+			session->SetFragmentSize(parsedMessage["fragmentSize"].toInt());
+
+		if (messageType == "Identified") {
+			session->StateMachine().Transition(ConnectionState::Identified);
+			if (channelId == 0)
+				_TransitionState(ConnectionState::Identified);
+		}
+	} else if (messageType == "SessionInvalidated") {
+		blog(LOG_INFO, "[WebsocketManager::onTextMessageReceived] Session on channel %d was invalidated by the server.", channelId);
+		session->StateMachine().Transition(ConnectionState::Closed);
+	} else {
+		blog(LOG_ERROR, "[WebsocketManager::onTextMessageReceived] Unhandled messageType in websocket message: `%s`.", QT_TO_UTF8(messageType));
+	}
+}
+
+static void CopyOrderingFields(const QJsonObject &parsedMessage, QJsonObject &response)
+{
+	if (parsedMessage.contains("orderingKey"))
+		response["orderingKey"] = parsedMessage["orderingKey"];
+	if (parsedMessage.contains("sequence"))
+		response["sequence"] = parsedMessage["sequence"];
+}
+
+void WebsocketManager::_ProcessRequestMessage(WebsocketSessionPtr session, QJsonObject parsedMessage, uint64_t receivedAt)
+{
+	QString messageType = parsedMessage["messageType"].toString();
+
+	QJsonObject response;
+	ResponseWriter writer(this, session);
+	if (messageType == "Request") {
+		if (!parsedMessage.contains("requestType")) {
+			blog(LOG_ERROR, "[WebsocketManager::_ProcessRequestMessage] Incoming message of type `Request` is missing the `requestType` field.");
+			return;
+		}
+
+		RequestHandler handler;
+		RequestResult result = session->ConsumeRateLimit() ?
+			handler.ProcessIncomingMessage(parsedMessage, receivedAt, session->ChannelId()) :
+			handler.BuildRateLimitedResult(parsedMessage);
+		response = handler.GetResultJson(result);
+		response["messageType"] = "RequestResponse";
+		CopyOrderingFields(parsedMessage, response);
+		// Cached results carry their data already serialized
+		writer.Write(response, "responseData", result.SerializedFields());
+	} else {
+		if (!parsedMessage.contains("requests")) {
+			blog(LOG_ERROR, "[WebsocketManager::_ProcessRequestMessage] Incoming message of type `RequestBatch` is missing the `requests` field.");
+			return;
+		}
+
+		if (!parsedMessage["requests"].isArray()) {
+			blog(LOG_ERROR, "[WebsocketManager::_ProcessRequestMessage] Incoming message of type `RequestBatch`'s `requests` field is not an array.");
+			return;
+		}
+
+		QJsonArray requests = parsedMessage["requests"].toArray();
+		bool rateLimited = !session->ConsumeRateLimit(requests.size());
+
+		response["messageType"] = "RequestBatchResponse";
+		if (parsedMessage.contains("requestId"))
+			response["requestId"] = parsedMessage["requestId"];
+		else
+			response["requestId"] = "";
+		CopyOrderingFields(parsedMessage, response);
+
+		// Results are serialized as they complete, so a large batch is streamed rather than built up in full
+		writer.BeginArray(response, "results");
+		RequestHandler handler;
+		for (auto j : requests) {
+			QJsonObject element = j.toObject();
+			if (!element.contains("requestType"))
+				continue;
+			RequestResult result = rateLimited ?
+				handler.BuildRateLimitedResult(element) :
+				handler.ProcessIncomingMessage(element, receivedAt, session->ChannelId());
+			writer.AppendElement(handler.GetResultJson(result), "responseData", result.SerializedFields());
+		}
+		writer.Finish();
+	}
+}
+
+void WebsocketManager::onSslErrors(const QList<QSslError> &errors)
+{
+	;
 }
\ No newline at end of file
@@ -1,103 +1,170 @@
-#pragma once
-
-#include <QObject>
-#include <QtWebSockets/QWebSocket>
-#include <QSslError>
-#include <QList>
-#include <QString>
-#include <QUrl>
-#include <QtCore/QMutex>
-#include <QtCore/QThreadPool>
-#include <QtConcurrent/QtConcurrent>
-#include <QThread>
-#include "plugin-main.h"
-
-class WebsocketManager : public QObject {
-	Q_OBJECT
-
-	public:
-		enum CloseCode: std::uint16_t {
-			UnknownReason = 4000,
-
-			// The server was unable to decode the incoming websocket message
-			MessageDecodeError = 4001,
-			// The specified `messageType` was invalid
-			UnknownMessageType = 4002,
-			// The client sent a websocket message without first sending `Identify` message
-			NotIdentified = 4003,
-			// The client sent an `Identify` message while already identified
-			AlreadyIdentified = 4004,
-			// The authentication attempt (via `Identify`) failed
-			AuthenticationFailed = 4005,
-			// There was an invalid parameter the client's `Identify` message
-			InvalidIdentifyParameter = 4006,
-			// A `Request` or `RequestBatch` was missing its `requestId`
-			RequestMissingRequestId = 4007,
-			// The websocket session has been invalidated by the obs-websocket server.
-			SessionInvalidated = 4008,
-			// The server detected the usage of an old version of the obs-websocket protocol.
-			UnsupportedProtocolVersion = 4009,
-			// There is already a session connected with that sessionKey
-			SessionAlreadyExists = 4010,
-		};
-
-
-		explicit WebsocketManager();
-		~WebsocketManager();
-
-		QString SessionKey;
-
-		QThreadPool* GetThreadPool() {
-			return &_threadPool;
-		}
-
-		QAbstractSocket::SocketState GetSocketState() {
-			return _socket.state();
-		}
-
-		QWebSocketProtocol::CloseCode GetCloseCode() {
-			return _socket.closeCode();
-		}
-
-		QString GetCloseReason() {
-			return _socket.closeReason();
-		}
-
-		QAbstractSocket::SocketError GetCloseError() {
-			return _socket.error();
-		}
-
-		QString GetCloseErrorString() {
-			return _socket.errorString();
-		}
-
-		bool IsConnected() {
-			return _socket.isValid();
-		}
-
-		bool IsIdentified() {
-			return isIdentified;
-		}
-
-	public Q_SLOTS:
-		void Connect(QString url);
-		void Disconnect();
-		void SendTextMessage(QString message);
-
-	signals:
-		void connectionStateChanged(QAbstractSocket::SocketState state);
-		void connectionIdentificationSuccess();
-
-	private Q_SLOTS:
-		void onConnected();
-		void onDisconnected();
-		void onTextMessageReceived(QString message);
-		void onSslErrors(const QList<QSslError> &errors);
-		void _SendIdentify();
-
-	private:
-		QThread _workerThread;
-		QWebSocket _socket;
-		QThreadPool _threadPool;
-		bool isIdentified;
+#pragma once
+
+#include <atomic>
+#include <QObject>
+#include <QtWebSockets/QWebSocket>
+#include <QSslError>
+#include <QList>
+#include <QString>
+#include <QUrl>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <QThread>
+#include <QtCore/QMap>
+#include <QtCore/QStringList>
+#include "plugin-main.h"
+#include "WebsocketSession.h"
+#include "ConnectionStateMachine.h"
+#include "WorkerPool.h"
+#include "RequestSequencer.h"
+#include "RequestCoalescer.h"
+#include "BinaryFrame.h"
+
+class WebsocketManager : public QObject {
+	Q_OBJECT
+
+	public:
+		enum CloseCode: std::uint16_t {
+			UnknownReason = 4000,
+
+			// The server was unable to decode the incoming websocket message
+			MessageDecodeError = 4001,
+			// The specified `messageType` was invalid
+			UnknownMessageType = 4002,
+			// The client sent a websocket message without first sending `Identify` message
+			NotIdentified = 4003,
+			// The client sent an `Identify` message while already identified
+			AlreadyIdentified = 4004,
+			// The authentication attempt (via `Identify`) failed
+			AuthenticationFailed = 4005,
+			// There was an invalid parameter the client's `Identify` message
+			InvalidIdentifyParameter = 4006,
+			// A `Request` or `RequestBatch` was missing its `requestId`
+			RequestMissingRequestId = 4007,
+			// The websocket session has been invalidated by the obs-websocket server.
+			SessionInvalidated = 4008,
+			// The server detected the usage of an old version of the obs-websocket protocol.
+			UnsupportedProtocolVersion = 4009,
+			// There is already a session connected with that sessionKey
+			SessionAlreadyExists = 4010,
+		};
+
+
+		explicit WebsocketManager();
+		~WebsocketManager();
+
+		// Each additional key is identified as its own logical session on channel 1..n of the same socket.
+		// Takes effect on the next `Hello`.
+		void SetSessionKeys(QString sessionKey, QStringList additionalSessionKeys);
+
+		QThreadPool* GetThreadPool() {
+			return _workerPool.GetThreadPool();
+		}
+
+		WorkerPool* GetWorkerPool() {
+			return &_workerPool;
+		}
+
+		RequestSequencer* GetRequestSequencer() {
+			return &_requestSequencer;
+		}
+
+		RequestCoalescer* GetRequestCoalescer() {
+			return &_requestCoalescer;
+		}
+
+		QAbstractSocket::SocketState GetSocketState() {
+			return _socket.state();
+		}
+
+		QWebSocketProtocol::CloseCode GetCloseCode() {
+			return _socket.closeCode();
+		}
+
+		QString GetCloseReason() {
+			return _socket.closeReason();
+		}
+
+		QAbstractSocket::SocketError GetCloseError() {
+			return _socket.error();
+		}
+
+		QString GetCloseErrorString() {
+			return _socket.errorString();
+		}
+
+		bool IsConnected() {
+			ConnectionState state = _stateMachine.State();
+			return state == ConnectionState::Handshaking || state == ConnectionState::Identified;
+		}
+
+		ConnectionState GetConnectionState() {
+			return _stateMachine.State();
+		}
+
+		QJsonObject GetConnectionStats() {
+			return _stateMachine.GetStats();
+		}
+
+		bool IsIdentified() {
+			WebsocketSessionPtr session = GetSession(0);
+			return session && session->IsIdentified();
+		}
+
+		WebsocketSessionPtr GetSession(uint16_t channelId);
+		QList<WebsocketSessionPtr> GetSessions();
+		void BroadcastEvent(uint64_t requiredIntent, QString eventType, QJsonObject eventData = QJsonObject());
+		void BroadcastBinary(uint64_t requiredIntent, BinaryFrameType frameType, uint32_t streamId, const QByteArray &payload);
+		// Queues a frame built with `WriteBinaryFrameHeader()` for a single session. Returns false if the session is not identified.
+		bool SendSessionBinary(uint16_t channelId, const QByteArray &frame);
+		// Queues an already serialized UTF-8 JSON message for a session, whether it is identified or not
+		void SendSessionText(WebsocketSessionPtr session, const QByteArray &message);
+
+		// Bytes queued for the socket that it has not written yet. Used by bulk senders to leave room for replies and events.
+		int64_t GetOutgoingBytes() {
+			return _outgoingBytes;
+		}
+		// Blocks until fewer than `limit` bytes are queued, or for at most `timeout` milliseconds. Returns false on timeout.
+		bool WaitForOutgoingBytesBelow(int64_t limit, unsigned long timeout);
+
+	public Q_SLOTS:
+		void Connect(QString url);
+		void Disconnect();
+		void SendTextMessage(QString message);
+		void SendBinaryMessage(QByteArray message);
+
+	signals:
+		void connectionStateChanged(ConnectionState state);
+
+	private Q_SLOTS:
+		void onConnected();
+		void onDisconnected();
+		void onTextMessageReceived(QString message);
+		void onSslErrors(const QList<QSslError> &errors);
+		void _SendIdentify();
+
+	private:
+		void _TransitionState(ConnectionState state);
+		void _ResetSessions();
+		void _ProcessRequestMessage(WebsocketSessionPtr session, QJsonObject parsedMessage, uint64_t receivedAt);
+		void _SendSessionMessage(WebsocketSessionPtr session, QJsonObject message);
+
+		QThread _workerThread;
+		QWebSocket _socket;
+		WorkerPool _workerPool;
+		RequestSequencer _requestSequencer;
+		RequestCoalescer _requestCoalescer;
+		ConnectionStateMachine _stateMachine;
+		// Written by the UI thread, read by the socket thread when the server says `Hello`
+		QMutex _sessionKeysMutex;
+		QString _sessionKey;
+		QStringList _additionalSessionKeys;
+		QMutex _sessionsMutex;
+		QMap<uint16_t, WebsocketSessionPtr> _sessions;
+		std::atomic<int64_t> _outgoingBytes;
+		// Signalled whenever the socket wrote queued bytes, and on disconnect
+		QMutex _outgoingMutex;
+		QWaitCondition _outgoingCondition;
 };
\ No newline at end of file
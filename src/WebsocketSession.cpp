@@ -0,0 +1,91 @@
+#include <util/platform.h>
+
+#include "WebsocketSession.h"
+
+WebsocketSession::WebsocketSession(uint16_t channelId, const QString &sessionKey) :
+	_channelId(channelId),
+	_sessionKey(sessionKey),
+	_eventSubscriptions(EventSubscription::All),
+	_incomingMessages(0),
+	_outgoingMessages(0),
+	_rateLimitedRequests(0),
+	_fragmentSize(0),
+	_fragmentedResponses(0),
+	_responseFragments(0),
+	_rateLimitPerSecond(0),
+	_rateLimitBurst(0),
+	_rateLimitTokens(0),
+	_rateLimitLastRefill(0)
+{
+}
+
+void WebsocketSession::SetRateLimit(double requestsPerSecond, double burst)
+{
+	QMutexLocker locker(&_rateLimitMutex);
+
+	if (requestsPerSecond < 0)
+		requestsPerSecond = 0;
+	if (burst < 1)
+		burst = requestsPerSecond > 1 ? requestsPerSecond : 1;
+
+	_rateLimitPerSecond = requestsPerSecond;
+	_rateLimitBurst = burst;
+	_rateLimitTokens = burst;
+	_rateLimitLastRefill = os_gettime_ns();
+}
+
+bool WebsocketSession::ConsumeRateLimit(int requestCount)
+{
+	QMutexLocker locker(&_rateLimitMutex);
+
+	if (_rateLimitPerSecond <= 0)
+		return true;
+
+	// Token bucket: refill proportionally to the time since the last refill, capped at the burst size
+	uint64_t now = os_gettime_ns();
+	double elapsedSeconds = (double)(now - _rateLimitLastRefill) / 1000000000.0;
+	_rateLimitLastRefill = now;
+	_rateLimitTokens += elapsedSeconds * _rateLimitPerSecond;
+	if (_rateLimitTokens > _rateLimitBurst)
+		_rateLimitTokens = _rateLimitBurst;
+
+	if (_rateLimitTokens < requestCount) {
+		_rateLimitedRequests += requestCount;
+		return false;
+	}
+
+	_rateLimitTokens -= requestCount;
+	return true;
+}
+
+void WebsocketSession::SetFragmentSize(int fragmentSize)
+{
+	// Tiny fragments would cost more in framing than they save
+	if (fragmentSize <= 0)
+		fragmentSize = 0;
+	else if (fragmentSize < MinFragmentSize)
+		fragmentSize = MinFragmentSize;
+
+	_fragmentSize = fragmentSize;
+}
+
+QJsonObject WebsocketSession::GetStats()
+{
+	QJsonObject ret;
+
+	ret["channelId"] = _channelId;
+	ret["eventSubscriptions"] = (double)_eventSubscriptions;
+	ret["incomingMessages"] = (double)_incomingMessages;
+	ret["outgoingMessages"] = (double)_outgoingMessages;
+	ret["rateLimitedRequests"] = (double)_rateLimitedRequests;
+	ret["fragmentSize"] = (int)_fragmentSize;
+	ret["fragmentedResponses"] = (double)_fragmentedResponses;
+	ret["responseFragments"] = (double)_responseFragments;
+	ret["connection"] = _stateMachine.GetStats();
+
+	QMutexLocker locker(&_rateLimitMutex);
+	ret["rateLimitPerSecond"] = _rateLimitPerSecond;
+	ret["rateLimitBurst"] = _rateLimitBurst;
+
+	return ret;
+}
\ No newline at end of file
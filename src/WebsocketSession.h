@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <QtCore/QString>
+#include <QtCore/QMutex>
+#include <QJsonObject>
+
+#include "plugin-main.h"
+#include "ConnectionStateMachine.h"
+
+namespace EventSubscription {
+	enum EventSubscription: uint64_t {
+		// Subscription value used to disable all events
+		None = 0,
+		// Subscription value to receive events in the `General` category
+		General = (1 << 0),
+		// Subscription value to receive events in the `Config` category
+		Config = (1 << 1),
+		// Subscription value to receive events in the `Scenes` category
+		Scenes = (1 << 2),
+		// Subscription value to receive events in the `Inputs` category
+		Inputs = (1 << 3),
+		// Subscription value to receive events in the `Transitions` category
+		Transitions = (1 << 4),
+		// Subscription value to receive events in the `Filters` category
+		Filters = (1 << 5),
+		// Subscription value to receive events in the `Outputs` category
+		Outputs = (1 << 6),
+		// Subscription value to receive events in the `MediaInputs` category
+		MediaInputs = (1 << 7),
+		// Helper to receive all non-high-volume events
+		All = (General | Config | Scenes | Inputs | Transitions | Filters | Outputs | MediaInputs),
+		// Subscription value to receive the program thumbnail binary frames (high-volume)
+		ProgramThumbnails = (1 << 16),
+		// Subscription value to receive the audio level binary frames (high-volume)
+		AudioLevels = (1 << 17),
+		// Subscription value to receive the periodic `OutputStats` event (high-volume)
+		OutputStats = (1 << 18),
+	};
+};
+
+class WebsocketSession {
+	public:
+		static const int MinFragmentSize = 16 * 1024;
+
+		explicit WebsocketSession(uint16_t channelId, const QString &sessionKey);
+
+		uint16_t ChannelId() const
+		{
+			return _channelId;
+		}
+
+		const QString& SessionKey() const
+		{
+			return _sessionKey;
+		}
+
+		bool IsIdentified() const
+		{
+			return _stateMachine.IsIdentified();
+		}
+
+		ConnectionStateMachine &StateMachine()
+		{
+			return _stateMachine;
+		}
+
+		uint64_t EventSubscriptions()
+		{
+			return _eventSubscriptions;
+		}
+
+		void SetEventSubscriptions(uint64_t subscriptions)
+		{
+			_eventSubscriptions = subscriptions;
+		}
+
+		// A `requestsPerSecond` of 0 disables rate limiting for the session
+		void SetRateLimit(double requestsPerSecond, double burst);
+		bool ConsumeRateLimit(int requestCount = 1);
+
+		// Responses are sent as `ResponseFragment` frames of at most this many bytes. 0 sends them as text messages.
+		void SetFragmentSize(int fragmentSize);
+
+		int FragmentSize()
+		{
+			return _fragmentSize;
+		}
+
+		void IncrementFragmentedResponses(uint32_t fragmentCount)
+		{
+			_fragmentedResponses++;
+			_responseFragments += fragmentCount;
+		}
+
+		void IncrementIncomingMessages()
+		{
+			_incomingMessages++;
+		}
+
+		void IncrementOutgoingMessages()
+		{
+			_outgoingMessages++;
+		}
+
+		QJsonObject GetStats();
+
+	private:
+		const uint16_t _channelId;
+		const QString _sessionKey;
+		ConnectionStateMachine _stateMachine;
+		std::atomic<uint64_t> _eventSubscriptions;
+		std::atomic<uint64_t> _incomingMessages;
+		std::atomic<uint64_t> _outgoingMessages;
+		std::atomic<uint64_t> _rateLimitedRequests;
+		std::atomic<int> _fragmentSize;
+		std::atomic<uint64_t> _fragmentedResponses;
+		std::atomic<uint64_t> _responseFragments;
+
+		QMutex _rateLimitMutex;
+		double _rateLimitPerSecond;
+		double _rateLimitBurst;
+		double _rateLimitTokens;
+		uint64_t _rateLimitLastRefill;
+};
+
+typedef std::shared_ptr<WebsocketSession> WebsocketSessionPtr;
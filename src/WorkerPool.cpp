@@ -0,0 +1,191 @@
+#include <util/platform.h>
+#include <QtCore/QThread>
+#include <QtConcurrent/QtConcurrent>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include "WorkerPool.h"
+
+static thread_local uint64_t appliedSettingsGeneration = 0;
+
+// Scheduling state of the pool thread before it was first tuned, restored when a setting is cleared
+static thread_local bool originalStateSaved = false;
+#if defined(__linux__)
+static thread_local int originalNiceness = 0;
+static thread_local cpu_set_t originalCpuSet;
+#elif defined(_WIN32)
+static thread_local DWORD_PTR originalAffinityMask = 0;
+#endif
+
+WorkerPool::WorkerPool() :
+	_settingsGeneration(1),
+	_createdAt(os_gettime_ns()),
+	_submittedTasks(0),
+	_startedTasks(0),
+	_completedTasks(0),
+	_busyTime(0),
+	_queueWaitTime(0),
+	_maxQueueWaitTime(0)
+{
+	Configure(WorkerPoolSettings());
+}
+
+void WorkerPool::Configure(const WorkerPoolSettings &settings)
+{
+	int threadCount = settings.ThreadCount;
+	if (threadCount <= 0)
+		threadCount = std::max(1, QThread::idealThreadCount());
+
+	{
+		QMutexLocker locker(&_settingsMutex);
+		_settings = settings;
+	}
+	_settingsGeneration++;
+
+	_threadPool.setMaxThreadCount(threadCount);
+	_threadPool.setExpiryTimeout(settings.ExpiryTimeout);
+
+#ifdef DEBUG_MODE
+	blog(LOG_INFO, "[WorkerPool::Configure] Threads: %d | Priority: %d | Affinity: `%s` | Niceness: %d | Expiry: %dms",
+		threadCount, settings.ThreadPriority, QT_TO_UTF8(settings.CpuAffinity), settings.Niceness, settings.ExpiryTimeout);
+#endif
+}
+
+void WorkerPool::Run(std::function<void()> task)
+{
+	uint64_t submittedAt = os_gettime_ns();
+	_submittedTasks++;
+
+	QtConcurrent::run(&_threadPool, [=]() {
+		_ApplyThreadTuning();
+
+		uint64_t startedAt = os_gettime_ns();
+		uint64_t queueWait = startedAt - submittedAt;
+		_startedTasks++;
+		_queueWaitTime += queueWait;
+		uint64_t maxQueueWait = _maxQueueWaitTime.load();
+		while (queueWait > maxQueueWait && !_maxQueueWaitTime.compare_exchange_weak(maxQueueWait, queueWait));
+
+		task();
+
+		_busyTime += os_gettime_ns() - startedAt;
+		_completedTasks++;
+	});
+}
+
+void WorkerPool::_ApplyThreadTuning()
+{
+	// Settings are applied lazily the first time each pool thread runs a task after a change
+	uint64_t generation = _settingsGeneration.load();
+	if (appliedSettingsGeneration == generation)
+		return;
+	appliedSettingsGeneration = generation;
+
+	WorkerPoolSettings settings;
+	{
+		QMutexLocker locker(&_settingsMutex);
+		settings = _settings;
+	}
+
+	QThread::currentThread()->setPriority((QThread::Priority)settings.ThreadPriority);
+
+	QList<int> cpus;
+	for (auto cpu : settings.CpuAffinity.split(',', QString::SkipEmptyParts)) {
+		bool ok;
+		int cpuIndex = cpu.trimmed().toInt(&ok);
+		if (ok && cpuIndex >= 0)
+			cpus.append(cpuIndex);
+	}
+
+#if defined(__linux__)
+	id_t threadId = (id_t)syscall(SYS_gettid);
+	if (!originalStateSaved) {
+		originalNiceness = getpriority(PRIO_PROCESS, threadId);
+		if (pthread_getaffinity_np(pthread_self(), sizeof(originalCpuSet), &originalCpuSet) != 0)
+			CPU_ZERO(&originalCpuSet);
+		originalStateSaved = true;
+	}
+
+	// `SCHED_OTHER` has a single static priority, so `QThread::setPriority()` only has an effect for `IdlePriority`.
+	// Below normal priority is therefore turned into a niceness, which is what keeps us behind the render/encode threads.
+	int niceness = settings.Niceness;
+	if (!niceness) {
+		if (settings.ThreadPriority == QThread::LowPriority)
+			niceness = 5;
+		else if (settings.ThreadPriority == QThread::LowestPriority)
+			niceness = 10;
+	}
+	niceness = niceness ? niceness : originalNiceness;
+	if (getpriority(PRIO_PROCESS, threadId) != niceness) {
+		// Lowering the niceness again requires CAP_SYS_NICE, so a failure here is only logged
+		if (setpriority(PRIO_PROCESS, threadId, niceness) != 0)
+			blog(LOG_WARNING, "[WorkerPool::_ApplyThreadTuning] Failed to set worker thread niceness to %d.", niceness);
+	}
+
+	cpu_set_t cpuSet;
+	if (!cpus.isEmpty()) {
+		CPU_ZERO(&cpuSet);
+		for (auto cpu : cpus) {
+			if (cpu < CPU_SETSIZE)
+				CPU_SET(cpu, &cpuSet);
+		}
+	} else {
+		cpuSet = originalCpuSet;
+	}
+	if (CPU_COUNT(&cpuSet) && pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0)
+		blog(LOG_WARNING, "[WorkerPool::_ApplyThreadTuning] Failed to set worker thread CPU affinity to `%s`.", QT_TO_UTF8(settings.CpuAffinity));
+#elif defined(_WIN32)
+	if (!cpus.isEmpty()) {
+		DWORD_PTR affinityMask = 0;
+		for (auto cpu : cpus) {
+			if (cpu < (int)(sizeof(DWORD_PTR) * 8))
+				affinityMask |= ((DWORD_PTR)1 << cpu);
+		}
+		DWORD_PTR previousMask = affinityMask ? SetThreadAffinityMask(GetCurrentThread(), affinityMask) : 0;
+		if (!previousMask)
+			blog(LOG_WARNING, "[WorkerPool::_ApplyThreadTuning] Failed to set worker thread CPU affinity to `%s`.", QT_TO_UTF8(settings.CpuAffinity));
+		else if (!originalStateSaved) {
+			originalAffinityMask = previousMask;
+			originalStateSaved = true;
+		}
+	} else if (originalStateSaved) {
+		SetThreadAffinityMask(GetCurrentThread(), originalAffinityMask);
+		originalStateSaved = false;
+	}
+#endif
+}
+
+QJsonObject WorkerPool::GetStats()
+{
+	QJsonObject ret;
+
+	uint64_t uptime = os_gettime_ns() - _createdAt;
+	uint64_t submittedTasks = _submittedTasks;
+	uint64_t startedTasks = _startedTasks;
+	uint64_t completedTasks = _completedTasks;
+	uint64_t busyTime = _busyTime;
+	int maxThreadCount = _threadPool.maxThreadCount();
+
+	ret["maxThreadCount"] = maxThreadCount;
+	ret["activeThreadCount"] = _threadPool.activeThreadCount();
+	ret["expiryTimeout"] = _threadPool.expiryTimeout();
+	ret["submittedTasks"] = (double)submittedTasks;
+	ret["queuedTasks"] = (double)(submittedTasks - startedTasks);
+	ret["runningTasks"] = (double)(startedTasks - completedTasks);
+	ret["completedTasks"] = (double)completedTasks;
+	ret["totalBusyTime"] = (double)(busyTime / 1000000);
+	ret["averageQueueWaitTime"] = startedTasks ? ((double)_queueWaitTime / (double)startedTasks) / 1000000.0 : 0.0;
+	ret["maxQueueWaitTime"] = (double)_maxQueueWaitTime / 1000000.0;
+	// Fraction of the pool's thread-time spent running tasks since the plugin loaded
+	ret["utilization"] = (uptime && maxThreadCount) ? (double)busyTime / ((double)uptime * maxThreadCount) : 0.0;
+
+	return ret;
+}
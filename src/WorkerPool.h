@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QThreadPool>
+#include <QJsonObject>
+
+#include "plugin-main.h"
+
+struct WorkerPoolSettings {
+	// 0 keeps Qt's default of one thread per core. Several requests (Eg. `waitForTransition`) block their thread
+	// for up to a minute, so a small pool is easily starved.
+	int ThreadCount = 0;
+	// A `QThread::Priority` value
+	int ThreadPriority = 2;
+	// Comma separated list of CPU indices. Empty keeps the affinity the thread had before it was tuned
+	QString CpuAffinity;
+	// Per-thread niceness applied on Linux. 0 derives it from `ThreadPriority`.
+	int Niceness = 0;
+	// Milliseconds an idle thread is kept alive before it exits
+	int ExpiryTimeout = 30000;
+};
+
+// Wraps the RPC `QThreadPool` so that every worker thread carries the configured scheduling
+// parameters and so that the pool utilization can be reported.
+class WorkerPool {
+	public:
+		WorkerPool();
+
+		QThreadPool *GetThreadPool()
+		{
+			return &_threadPool;
+		}
+
+		void Configure(const WorkerPoolSettings &settings);
+		void Run(std::function<void()> task);
+
+		QJsonObject GetStats();
+
+	private:
+		void _ApplyThreadTuning();
+
+		QThreadPool _threadPool;
+
+		QMutex _settingsMutex;
+		WorkerPoolSettings _settings;
+		std::atomic<uint64_t> _settingsGeneration;
+
+		uint64_t _createdAt;
+		std::atomic<uint64_t> _submittedTasks;
+		std::atomic<uint64_t> _startedTasks;
+		std::atomic<uint64_t> _completedTasks;
+		std::atomic<uint64_t> _busyTime;
+		std::atomic<uint64_t> _queueWaitTime;
+		std::atomic<uint64_t> _maxQueueWaitTime;
+};
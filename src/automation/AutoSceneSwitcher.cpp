@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <obs-frontend-api.h>
+#include <util/platform.h>
+
+#include "AutoSceneSwitcher.h"
+#include "../WebsocketManager.h"
+
+AutoSceneSwitcher::AutoSceneSwitcher() :
+	_evaluations(0),
+	_switches(0),
+	_failedSwitches(0),
+	_lastSwitchLatency(0)
+{
+}
+
+void AutoSceneSwitcher::SetSettings(const AutoSceneSwitchSettings &settings)
+{
+	QMutexLocker locker(&_mutex);
+	_settings = settings;
+	// Replacing the rules forgets any switch in progress. The current scene is left alone.
+	_ruleStates.assign(_settings.Rules.size(), RuleState());
+}
+
+AutoSceneSwitchSettings AutoSceneSwitcher::GetSettings()
+{
+	QMutexLocker locker(&_mutex);
+	return _settings;
+}
+
+QJsonArray AutoSceneSwitcher::GetRules()
+{
+	QMutexLocker locker(&_mutex);
+	uint64_t now = os_gettime_ns();
+
+	QJsonArray ret;
+	for (size_t i = 0; i < _settings.Rules.size(); i++) {
+		const SceneSwitchRule &rule = _settings.Rules[i];
+		const RuleState &state = _ruleStates[i];
+
+		QJsonObject ruleJson;
+		ruleJson["ingestName"] = rule.IngestName;
+		ruleJson["liveScene"] = rule.LiveScene;
+		ruleJson["fallbackScene"] = rule.FallbackScene;
+		ruleJson["switchOnStall"] = rule.SwitchOnStall;
+		ruleJson["minBitrate"] = rule.MinBitrate;
+		ruleJson["recoveryBitrate"] = rule.RecoveryBitrate;
+		ruleJson["triggerDelay"] = rule.TriggerDelay;
+		ruleJson["recoveryDelay"] = rule.RecoveryDelay;
+
+		ruleJson["fallbackActive"] = state.Switched;
+		ruleJson["unhealthyDuration"] = (double)(state.UnhealthySince ? (now - state.UnhealthySince) / 1000000 : 0);
+		ruleJson["healthyDuration"] = (double)(state.HealthySince ? (now - state.HealthySince) / 1000000 : 0);
+		ruleJson["switchCount"] = (double)state.SwitchCount;
+		ruleJson["lastSwitchTimestamp"] = (double)(state.LastSwitchAt / 1000000);
+		ruleJson["lastSwitchReason"] = state.LastReason;
+		ret.append(ruleJson);
+	}
+	return ret;
+}
+
+void AutoSceneSwitcher::ProcessIngestHealth(const std::vector<IngestHealthSnapshot> &snapshots, uint64_t sampledAt)
+{
+	std::vector<SwitchAction> actions;
+	{
+		QMutexLocker locker(&_mutex);
+		if (!_settings.Enabled || _settings.Rules.empty())
+			return;
+
+		_evaluations++;
+
+		OBSSourceAutoRelease currentScene = obs_frontend_get_current_scene();
+		QString currentSceneName = obs_source_get_name(currentScene);
+
+		for (size_t i = 0; i < _settings.Rules.size(); i++) {
+			const SceneSwitchRule &rule = _settings.Rules[i];
+			RuleState &state = _ruleStates[i];
+
+			auto snapshot = std::find_if(snapshots.begin(), snapshots.end(), [&rule](const IngestHealthSnapshot &candidate) {
+				return candidate.SourceName == rule.IngestName;
+			});
+
+			bool unhealthy = false;
+			bool recovered = false;
+			QString reason;
+			if (snapshot == snapshots.end()) {
+				// The ingest was removed or renamed
+				unhealthy = rule.SwitchOnStall;
+				reason = "ingestMissing";
+			} else {
+				bool checkBitrate = snapshot->StatsAvailable && rule.MinBitrate > 0;
+				if (rule.SwitchOnStall && snapshot->Latest.Stalled) {
+					unhealthy = true;
+					reason = "stalled";
+				} else if (checkBitrate && snapshot->Latest.Bitrate < rule.MinBitrate) {
+					unhealthy = true;
+					reason = "lowBitrate";
+				}
+				double recoveryBitrate = std::max(rule.MinBitrate, rule.RecoveryBitrate);
+				recovered = !snapshot->Latest.Stalled && (!checkBitrate || snapshot->Latest.Bitrate >= recoveryBitrate);
+			}
+
+			if (!state.Switched) {
+				state.HealthySince = 0;
+				if (!unhealthy) {
+					state.UnhealthySince = 0;
+					continue;
+				}
+				if (!state.UnhealthySince) {
+					// A stall is dated from when the sampler first saw it, not from this evaluation
+					uint64_t stallDuration = snapshot != snapshots.end() ? snapshot->StallDuration : 0;
+					state.UnhealthySince = (reason == "stalled" && stallDuration < sampledAt) ? sampledAt - stallDuration : sampledAt;
+				}
+				if (currentSceneName != rule.LiveScene)
+					continue;
+				uint64_t unhealthyDuration = sampledAt - state.UnhealthySince;
+				if (unhealthyDuration < (uint64_t)rule.TriggerDelay * 1000000)
+					continue;
+
+				state.Switched = true;
+				state.LastReason = reason;
+				IngestHealthSnapshot actionSnapshot;
+				if (snapshot != snapshots.end())
+					actionSnapshot = *snapshot;
+				else
+					actionSnapshot.SourceName = rule.IngestName;
+				actions.push_back({i, currentSceneName, rule.FallbackScene, reason, actionSnapshot, unhealthyDuration});
+				currentSceneName = rule.FallbackScene;
+			} else {
+				state.UnhealthySince = 0;
+				if (currentSceneName != rule.FallbackScene) {
+					// Someone else changed the scene while the fallback was up, so it is no longer ours to undo
+					state.Switched = false;
+					state.HealthySince = 0;
+					continue;
+				}
+				if (!recovered) {
+					state.HealthySince = 0;
+					continue;
+				}
+				if (!state.HealthySince)
+					state.HealthySince = sampledAt;
+				uint64_t healthyDuration = sampledAt - state.HealthySince;
+				if (healthyDuration < (uint64_t)rule.RecoveryDelay * 1000000)
+					continue;
+
+				state.Switched = false;
+				state.HealthySince = 0;
+				state.LastReason = "recovered";
+				actions.push_back({i, currentSceneName, rule.LiveScene, "recovered", *snapshot, healthyDuration});
+				currentSceneName = rule.LiveScene;
+			}
+		}
+	}
+
+	// `obs_frontend_set_current_scene()` waits for the UI thread, so it is not called with the lock held
+	for (auto &action : actions)
+		_SwitchScene(action, sampledAt);
+}
+
+QJsonObject AutoSceneSwitcher::GetStats()
+{
+	QJsonObject ret;
+	ret["evaluations"] = (double)_evaluations;
+	ret["switches"] = (double)_switches;
+	ret["failedSwitches"] = (double)_failedSwitches;
+	ret["lastSwitchLatency"] = (double)_lastSwitchLatency / 1000000.0;
+	return ret;
+}
+
+void AutoSceneSwitcher::_SwitchScene(const SwitchAction &action, uint64_t sampledAt)
+{
+	OBSSourceAutoRelease targetScene = obs_get_source_by_name(QT_TO_UTF8(action.ToScene));
+	if (!targetScene || !obs_source_is_scene(targetScene)) {
+		blog(LOG_WARNING, "[AutoSceneSwitcher::_SwitchScene] Scene `%s` does not exist, unable to switch away from `%s`.", QT_TO_UTF8(action.ToScene), QT_TO_UTF8(action.FromScene));
+		_failedSwitches++;
+		return;
+	}
+
+	obs_frontend_set_current_scene(targetScene);
+
+	uint64_t switchedAt = os_gettime_ns();
+	uint64_t switchLatency = switchedAt - sampledAt;
+	_switches++;
+	_lastSwitchLatency = switchLatency;
+
+	{
+		QMutexLocker locker(&_mutex);
+		if (action.RuleIndex < _ruleStates.size()) {
+			_ruleStates[action.RuleIndex].SwitchCount++;
+			_ruleStates[action.RuleIndex].LastSwitchAt = switchedAt;
+		}
+	}
+
+	blog(LOG_INFO, "[AutoSceneSwitcher::_SwitchScene] Switched from `%s` to `%s` (ingest `%s`, reason `%s`).",
+		QT_TO_UTF8(action.FromScene), QT_TO_UTF8(action.ToScene), QT_TO_UTF8(action.Snapshot.SourceName), QT_TO_UTF8(action.Reason));
+
+	auto websocketManager = GetWebsocketManager();
+	if (!websocketManager)
+		return;
+
+	QJsonObject eventData;
+	eventData["ingestName"] = action.Snapshot.SourceName;
+	eventData["fromScene"] = action.FromScene;
+	eventData["toScene"] = action.ToScene;
+	eventData["reason"] = action.Reason;
+	eventData["mediaState"] = IngestHealthSampler::MediaStateName(action.Snapshot.Latest.MediaState);
+	eventData["bitrate"] = action.Snapshot.Latest.Bitrate;
+	eventData["conditionDuration"] = (double)(action.ConditionDuration / 1000000);
+	eventData["switchLatency"] = (double)switchLatency / 1000000.0;
+	websocketManager->BroadcastEvent(EventSubscription::Scenes, "AutoSceneSwitched", eventData);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include "../plugin-main.h"
+#include "../stats/IngestHealthSampler.h"
+
+struct SceneSwitchRule {
+	// Ingest (`vlc_source` input) watched by the rule
+	QString IngestName;
+	// Scene showing the ingest. The rule only ever switches away from this scene.
+	QString LiveScene;
+	// Scene shown while the ingest is unhealthy
+	QString FallbackScene;
+	// Treat a stalled ingest (opening, buffering, error, ended or not receiving data) as unhealthy
+	bool SwitchOnStall = true;
+	// Kbps below which the ingest is unhealthy. 0 disables the bitrate check.
+	double MinBitrate = 0.0;
+	// Kbps the ingest must reach again before switching back. Never lower than `MinBitrate`.
+	double RecoveryBitrate = 0.0;
+	// Milliseconds the ingest must stay unhealthy before switching to the fallback scene
+	int TriggerDelay = 0;
+	// Milliseconds the ingest must stay healthy before switching back to the live scene
+	int RecoveryDelay = 3000;
+};
+
+struct AutoSceneSwitchSettings {
+	bool Enabled = false;
+	std::vector<SceneSwitchRule> Rules;
+};
+
+// Evaluates the scene switch rules against every ingest health sample, so that a dead ingest is replaced
+// by its fallback scene without a round trip to the cloud. Each rule has separate trigger and recovery
+// thresholds and delays to avoid flapping. Every switch is reported with an `AutoSceneSwitched` event.
+class AutoSceneSwitcher {
+	public:
+		AutoSceneSwitcher();
+
+		void SetSettings(const AutoSceneSwitchSettings &settings);
+		AutoSceneSwitchSettings GetSettings();
+
+		// Rules along with their current evaluation state
+		QJsonArray GetRules();
+
+		// Called on the ingest health sampler thread after every sample pass
+		void ProcessIngestHealth(const std::vector<IngestHealthSnapshot> &snapshots, uint64_t sampledAt);
+
+		QJsonObject GetStats();
+
+	private:
+		struct RuleState {
+			uint64_t UnhealthySince = 0;
+			uint64_t HealthySince = 0;
+			bool Switched = false;
+			uint64_t SwitchCount = 0;
+			uint64_t LastSwitchAt = 0;
+			QString LastReason;
+		};
+
+		struct SwitchAction {
+			size_t RuleIndex;
+			QString FromScene;
+			QString ToScene;
+			QString Reason;
+			IngestHealthSnapshot Snapshot;
+			uint64_t ConditionDuration;
+		};
+
+		void _SwitchScene(const SwitchAction &action, uint64_t sampledAt);
+
+		QMutex _mutex;
+		AutoSceneSwitchSettings _settings;
+		std::vector<RuleState> _ruleStates;
+
+		std::atomic<uint64_t> _evaluations;
+		std::atomic<uint64_t> _switches;
+		std::atomic<uint64_t> _failedSwitches;
+		std::atomic<uint64_t> _lastSwitchLatency;
+};
+
+typedef std::shared_ptr<AutoSceneSwitcher> AutoSceneSwitcherPtr;
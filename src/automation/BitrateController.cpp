@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <cstring>
+#include <util/platform.h>
+#include <QJsonArray>
+
+#include "BitrateController.h"
+#include "../WebsocketManager.h"
+
+BitrateController::BitrateController() :
+	_controlling(false),
+	_unsupported(false),
+	_originalBitrate(0),
+	_currentBitrate(0),
+	_lastDecreaseAt(0),
+	_lastIncreaseAt(0),
+	_healthySince(0),
+	_adjustmentCount(0)
+{
+}
+
+void BitrateController::SetSettings(const BitrateControllerSettings &settings)
+{
+	QMutexLocker locker(&_mutex);
+	_settings = settings;
+}
+
+BitrateControllerSettings BitrateController::GetSettings()
+{
+	QMutexLocker locker(&_mutex);
+	return _settings;
+}
+
+QJsonObject BitrateController::GetStatus()
+{
+	QMutexLocker locker(&_mutex);
+
+	QJsonObject ret;
+	ret["enabled"] = _settings.Enabled;
+	ret["minBitrate"] = _settings.MinBitrate;
+	ret["maxBitrate"] = _settings.MaxBitrate;
+	ret["decreaseStep"] = _settings.DecreaseStep;
+	ret["increaseStep"] = _settings.IncreaseStep;
+	ret["congestionThreshold"] = _settings.CongestionThreshold;
+	ret["dropRateThreshold"] = _settings.DropRateThreshold;
+	ret["decreaseInterval"] = _settings.DecreaseInterval;
+	ret["increaseInterval"] = _settings.IncreaseInterval;
+
+	ret["streamActive"] = _controlling;
+	ret["encoderSupported"] = !_unsupported;
+	ret["originalBitrate"] = _originalBitrate;
+	ret["currentBitrate"] = _currentBitrate;
+	ret["adjustmentCount"] = (double)_adjustmentCount;
+
+	QJsonArray adjustments;
+	for (auto &adjustment : _adjustments.Snapshot()) {
+		QJsonObject adjustmentJson;
+		adjustmentJson["timestamp"] = (double)(adjustment.Timestamp / 1000000);
+		adjustmentJson["previousBitrate"] = adjustment.PreviousBitrate;
+		adjustmentJson["bitrate"] = adjustment.Bitrate;
+		adjustmentJson["congestion"] = adjustment.Congestion;
+		adjustmentJson["dropRate"] = adjustment.DropRate;
+		adjustmentJson["reason"] = adjustment.Reason;
+		adjustments.append(adjustmentJson);
+	}
+	ret["adjustments"] = adjustments;
+
+	return ret;
+}
+
+void BitrateController::ProcessStreamSample(obs_output_t *output, const OutputSample &previous, const OutputSample &sample)
+{
+	QMutexLocker locker(&_mutex);
+
+	obs_encoder_t *encoder = obs_output_get_video_encoder(output);
+	uint64_t now = sample.Timestamp;
+
+	BitrateAdjustment adjustment;
+	adjustment.Timestamp = now;
+	adjustment.PreviousBitrate = _currentBitrate;
+	adjustment.Congestion = sample.Congestion;
+
+	if (!sample.Active) {
+		// Leave the encoder as we found it for the next stream
+		if (_controlling && !_unsupported && encoder && _currentBitrate != _originalBitrate && _ApplyBitrate(encoder, _originalBitrate)) {
+			adjustment.Bitrate = _originalBitrate;
+			adjustment.Reason = "restored";
+			_RecordAdjustment(adjustment);
+		}
+		_controlling = false;
+		return;
+	}
+
+	if (!_controlling) {
+		_controlling = true;
+		_originalBitrate = 0;
+		_unsupported = true;
+		if (encoder) {
+			OBSDataAutoRelease encoderSettings = obs_encoder_get_settings(encoder);
+			_originalBitrate = (int)obs_data_get_int(encoderSettings, "bitrate");
+			const char *rateControl = obs_data_get_string(encoderSettings, "rate_control");
+			// Constant quality modes have no bitrate to steer
+			bool bitrateRateControl = !rateControl || !*rateControl || !strcmp(rateControl, "CBR") || !strcmp(rateControl, "VBR") || !strcmp(rateControl, "ABR");
+			_unsupported = _originalBitrate <= 0 || !bitrateRateControl;
+		}
+		_currentBitrate = _originalBitrate;
+		_lastDecreaseAt = 0;
+		_lastIncreaseAt = 0;
+		_healthySince = now;
+
+		if (_unsupported)
+			blog(LOG_INFO, "[BitrateController::ProcessStreamSample] The streaming encoder does not use a bitrate based rate control. Bitrate control is unavailable for this stream.");
+		return;
+	}
+
+	if (_unsupported || !encoder)
+		return;
+
+	if (!_settings.Enabled) {
+		if (_currentBitrate != _originalBitrate && _ApplyBitrate(encoder, _originalBitrate)) {
+			adjustment.Bitrate = _originalBitrate;
+			adjustment.Reason = "restored";
+			_RecordAdjustment(adjustment);
+		}
+		return;
+	}
+
+	// Rates need two samples of the same output session
+	if (!previous.Active || previous.TotalFrames > sample.TotalFrames)
+		return;
+
+	uint32_t frames = sample.TotalFrames - previous.TotalFrames;
+	uint32_t droppedFrames = sample.DroppedFrames >= previous.DroppedFrames ? sample.DroppedFrames - previous.DroppedFrames : 0;
+	double dropRate = frames ? (double)droppedFrames / frames : 0.0;
+	adjustment.DropRate = (float)dropRate;
+
+	int maxBitrate = _settings.MaxBitrate > 0 ? _settings.MaxBitrate : _originalBitrate;
+	int minBitrate = std::min(_settings.MinBitrate, maxBitrate);
+
+	int targetBitrate = _currentBitrate;
+	bool congested = sample.Congestion >= _settings.CongestionThreshold;
+	bool dropping = dropRate >= _settings.DropRateThreshold;
+	if (_currentBitrate > maxBitrate || _currentBitrate < minBitrate) {
+		// The bounds were changed to exclude the current bitrate
+		targetBitrate = std::max(minBitrate, std::min(maxBitrate, _currentBitrate));
+		adjustment.Reason = "bounds";
+	} else if (congested || dropping) {
+		_healthySince = 0;
+		if (_lastDecreaseAt && now - _lastDecreaseAt < (uint64_t)_settings.DecreaseInterval * 1000000)
+			return;
+		targetBitrate = std::max(minBitrate, (int)((int64_t)_currentBitrate * (100 - _settings.DecreaseStep) / 100));
+		adjustment.Reason = congested ? "congestion" : "droppedFrames";
+	} else {
+		if (!_healthySince)
+			_healthySince = now;
+		// Only probe upwards once the output is clearly below the threshold
+		if (sample.Congestion >= _settings.CongestionThreshold / 2)
+			return;
+		if (now - _healthySince < (uint64_t)_settings.IncreaseInterval * 1000000)
+			return;
+		if (_lastIncreaseAt && now - _lastIncreaseAt < (uint64_t)_settings.IncreaseInterval * 1000000)
+			return;
+		targetBitrate = std::min(maxBitrate, _currentBitrate + _settings.IncreaseStep);
+		adjustment.Reason = "recovered";
+	}
+
+	if (targetBitrate == _currentBitrate || !_ApplyBitrate(encoder, targetBitrate))
+		return;
+
+	if (targetBitrate < adjustment.PreviousBitrate)
+		_lastDecreaseAt = now;
+	else
+		_lastIncreaseAt = now;
+
+	adjustment.Bitrate = targetBitrate;
+	_RecordAdjustment(adjustment);
+}
+
+bool BitrateController::_ApplyBitrate(obs_encoder_t *encoder, int bitrate)
+{
+	OBSDataAutoRelease encoderSettings = obs_encoder_get_settings(encoder);
+	if (!encoderSettings)
+		return false;
+
+	obs_data_set_int(encoderSettings, "bitrate", bitrate);
+	obs_encoder_update(encoder, encoderSettings);
+	_currentBitrate = bitrate;
+	return true;
+}
+
+void BitrateController::_RecordAdjustment(const BitrateAdjustment &adjustment)
+{
+	_adjustments.Push(adjustment);
+	_adjustmentCount++;
+
+#ifdef DEBUG_MODE
+	blog(LOG_INFO, "[BitrateController::_RecordAdjustment] %d -> %d kbps (reason `%s`, congestion %.2f, drop rate %.3f)",
+		adjustment.PreviousBitrate, adjustment.Bitrate, adjustment.Reason, adjustment.Congestion, adjustment.DropRate);
+#endif
+
+	auto websocketManager = GetWebsocketManager();
+	if (!websocketManager)
+		return;
+
+	QJsonObject eventData;
+	eventData["previousBitrate"] = adjustment.PreviousBitrate;
+	eventData["bitrate"] = adjustment.Bitrate;
+	eventData["reason"] = adjustment.Reason;
+	eventData["congestion"] = adjustment.Congestion;
+	eventData["dropRate"] = adjustment.DropRate;
+	websocketManager->BroadcastEvent(EventSubscription::Outputs, "StreamBitrateAdjusted", eventData);
+}
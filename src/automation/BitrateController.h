@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <obs.hpp>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QJsonObject>
+
+#include "../plugin-main.h"
+#include "../stats/RingBuffer.h"
+#include "../stats/OutputStatsSampler.h"
+
+struct BitrateControllerSettings {
+	bool Enabled = false;
+	// Kbps bounds. A `MaxBitrate` of 0 uses the bitrate the encoder had when the stream started.
+	int MinBitrate = 1000;
+	int MaxBitrate = 0;
+	// Percentage removed from the bitrate on every decrease
+	int DecreaseStep = 20;
+	// Kbps added to the bitrate on every increase
+	int IncreaseStep = 250;
+	// Congestion (0-1) at or above which the bitrate is decreased
+	double CongestionThreshold = 0.2;
+	// Fraction of frames dropped between two samples at or above which the bitrate is decreased
+	double DropRateThreshold = 0.01;
+	// Milliseconds between two decreases
+	int DecreaseInterval = 2000;
+	// Milliseconds the output must stay uncongested before (and between) increases
+	int IncreaseInterval = 5000;
+};
+
+struct BitrateAdjustment {
+	uint64_t Timestamp = 0;
+	int PreviousBitrate = 0;
+	int Bitrate = 0;
+	float Congestion = 0.0f;
+	float DropRate = 0.0f;
+	// `congestion`, `droppedFrames`, `recovered`, `restored` or `bounds` (the bounds were changed to exclude the current bitrate)
+	const char *Reason = "";
+};
+
+// Closed-loop controller for the streaming video encoder's bitrate, fed by the output stats sampler.
+// Decreases are multiplicative and increases additive (AIMD), so the bitrate backs off quickly when the
+// uplink congests and probes back up slowly. The original bitrate is restored when the stream stops.
+class BitrateController {
+	public:
+		BitrateController();
+
+		void SetSettings(const BitrateControllerSettings &settings);
+		BitrateControllerSettings GetSettings();
+
+		// Current state and the most recent adjustments
+		QJsonObject GetStatus();
+
+		// Called on the output stats sampler thread with every sample of the streaming output
+		void ProcessStreamSample(obs_output_t *output, const OutputSample &previous, const OutputSample &sample);
+
+	private:
+		bool _ApplyBitrate(obs_encoder_t *encoder, int bitrate);
+		void _RecordAdjustment(const BitrateAdjustment &adjustment);
+
+		QMutex _mutex;
+		BitrateControllerSettings _settings;
+
+		// Sampler thread state, also read under `_mutex` by `GetStatus()`
+		bool _controlling;
+		bool _unsupported;
+		int _originalBitrate;
+		int _currentBitrate;
+		uint64_t _lastDecreaseAt;
+		uint64_t _lastIncreaseAt;
+		uint64_t _healthySince;
+
+		RingBuffer<BitrateAdjustment, 64> _adjustments;
+		std::atomic<uint64_t> _adjustmentCount;
+};
+
+typedef std::shared_ptr<BitrateController> BitrateControllerPtr;
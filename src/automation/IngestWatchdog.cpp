@@ -0,0 +1,336 @@
+#include <algorithm>
+#include <util/platform.h>
+
+#include "IngestWatchdog.h"
+#include "../WebsocketManager.h"
+#include "../stats/IngestHealthSampler.h"
+
+// Milliseconds between two checks when no media signal arrives
+#define CHECK_INTERVAL 250
+
+struct IngestWatchdog::Watch {
+	IngestWatchdog *Parent = nullptr;
+	QString SourceName;
+	IngestWatchdogSettings Settings;
+
+	// Weak, so that the watchdog does not keep a removed source alive
+	OBSWeakSource Source;
+
+	// Written by the media signal callbacks
+	std::atomic<bool> EndedSignaled;
+	std::atomic<uint64_t> StartedAt;
+
+	uint64_t StalledSince = 0;
+	uint64_t HealthySince = 0;
+	uint64_t NextRestartAt = 0;
+	uint64_t LastRestartAt = 0;
+	bool RestartPending = false;
+	bool GaveUp = false;
+	int ConsecutiveRestarts = 0;
+	QString LastReason;
+
+	uint64_t RestartCount = 0;
+	uint64_t RecoveryCount = 0;
+	uint64_t LastRestartLatency = 0;
+	uint64_t TotalRestartLatency = 0;
+
+	Watch() :
+		EndedSignaled(false),
+		StartedAt(0)
+	{
+	}
+};
+
+IngestWatchdog::IngestWatchdog() :
+	_running(true),
+	_restarts(0),
+	_recoveries(0)
+{
+	_watchThread = std::thread(&IngestWatchdog::_WatchLoop, this);
+}
+
+IngestWatchdog::~IngestWatchdog()
+{
+	{
+		QMutexLocker locker(&_mutex);
+		_running = false;
+		_condition.wakeAll();
+	}
+	_watchThread.join();
+
+	for (auto &watch : _watches)
+		_Detach(watch.second.get());
+}
+
+void IngestWatchdog::SetWatchdog(const QString &sourceName, const IngestWatchdogSettings &settings)
+{
+	QMutexLocker locker(&_mutex);
+	auto &watch = _watches[sourceName];
+	if (!watch) {
+		watch = std::unique_ptr<Watch>(new Watch());
+		watch->Parent = this;
+		watch->SourceName = sourceName;
+	}
+	watch->Settings = settings;
+	_condition.wakeAll();
+}
+
+bool IngestWatchdog::RemoveWatchdog(const QString &sourceName)
+{
+	QMutexLocker locker(&_mutex);
+	auto it = _watches.find(sourceName);
+	if (it == _watches.end())
+		return false;
+
+	_Detach(it->second.get());
+	_watches.erase(it);
+	return true;
+}
+
+QJsonArray IngestWatchdog::GetWatchdogs()
+{
+	QMutexLocker locker(&_mutex);
+	uint64_t now = os_gettime_ns();
+
+	QJsonArray ret;
+	for (auto &entry : _watches) {
+		Watch *watch = entry.second.get();
+
+		QJsonObject watchJson;
+		watchJson["sourceName"] = watch->SourceName;
+		watchJson["sourceOk"] = (bool)watch->Source;
+		watchJson["stallTimeout"] = watch->Settings.StallTimeout;
+		watchJson["initialBackoff"] = watch->Settings.InitialBackoff;
+		watchJson["maxBackoff"] = watch->Settings.MaxBackoff;
+		watchJson["maxRestarts"] = watch->Settings.MaxRestarts;
+		watchJson["stableDuration"] = watch->Settings.StableDuration;
+
+		watchJson["stalledDuration"] = (double)(watch->StalledSince ? (now - watch->StalledSince) / 1000000 : 0);
+		watchJson["restartPending"] = watch->RestartPending;
+		watchJson["gaveUp"] = watch->GaveUp;
+		watchJson["consecutiveRestarts"] = watch->ConsecutiveRestarts;
+		watchJson["nextRestartIn"] = (double)(watch->NextRestartAt > now ? (watch->NextRestartAt - now) / 1000000 : 0);
+		watchJson["lastRestartReason"] = watch->LastReason;
+		watchJson["lastRestartTimestamp"] = (double)(watch->LastRestartAt / 1000000);
+		watchJson["restartCount"] = (double)watch->RestartCount;
+		watchJson["recoveryCount"] = (double)watch->RecoveryCount;
+		watchJson["lastRestartLatency"] = (double)(watch->LastRestartLatency / 1000000);
+		watchJson["averageRestartLatency"] = watch->RecoveryCount ? ((double)watch->TotalRestartLatency / watch->RecoveryCount) / 1000000.0 : 0.0;
+		ret.append(watchJson);
+	}
+	return ret;
+}
+
+QJsonObject IngestWatchdog::GetStats()
+{
+	size_t watchCount;
+	{
+		QMutexLocker locker(&_mutex);
+		watchCount = _watches.size();
+	}
+
+	QJsonObject ret;
+	ret["watchedIngests"] = (double)watchCount;
+	ret["restarts"] = (double)_restarts;
+	ret["recoveries"] = (double)_recoveries;
+	return ret;
+}
+
+void IngestWatchdog::MediaEndedCallback(void *param, calldata_t *)
+{
+	// Runs on the media thread: only flag the watch and wake the watchdog thread
+	auto watch = static_cast<Watch*>(param);
+	watch->EndedSignaled = true;
+	watch->Parent->_condition.wakeAll();
+}
+
+void IngestWatchdog::MediaStartedCallback(void *param, calldata_t *)
+{
+	auto watch = static_cast<Watch*>(param);
+	watch->StartedAt = os_gettime_ns();
+	watch->Parent->_condition.wakeAll();
+}
+
+void IngestWatchdog::_WatchLoop()
+{
+	QMutexLocker locker(&_mutex);
+	while (_running) {
+		_condition.wait(&_mutex, CHECK_INTERVAL);
+		if (!_running)
+			break;
+
+		uint64_t now = os_gettime_ns();
+		for (auto &watch : _watches)
+			_Check(watch.second.get(), now);
+	}
+}
+
+void IngestWatchdog::_Check(Watch *watch, uint64_t now)
+{
+	OBSSourceAutoRelease source;
+	if (watch->Source) {
+		source = obs_weak_source_get_source(watch->Source);
+		if (!source) {
+			// Destroyed sources drop their signal handlers themselves
+			watch->Source = nullptr;
+		} else if (obs_source_removed(source)) {
+			_Detach(watch);
+			source = nullptr;
+		}
+	}
+	if (!watch->Source) {
+		_Attach(watch);
+		if (!watch->Source)
+			return;
+		source = obs_weak_source_get_source(watch->Source);
+		if (!source)
+			return;
+	}
+
+	const IngestWatchdogSettings &settings = watch->Settings;
+	enum obs_media_state mediaState = obs_source_media_get_state(source);
+	bool ended = watch->EndedSignaled.exchange(false);
+
+	// The ingest health sampler also catches a player that is "playing" but receiving no data
+	bool noData = false;
+	IngestHealthSnapshot snapshot;
+	auto ingestHealthSampler = GetIngestHealthSampler();
+	if (mediaState == OBS_MEDIA_STATE_PLAYING && ingestHealthSampler && ingestHealthSampler->GetSnapshot(watch->SourceName, snapshot))
+		// Samples taken before the last restart describe the old connection
+		noData = snapshot.Latest.Timestamp > watch->LastRestartAt && snapshot.Latest.Stalled && snapshot.Latest.MediaState == OBS_MEDIA_STATE_PLAYING;
+
+	const char *failure = nullptr;
+	if (mediaState == OBS_MEDIA_STATE_ERROR)
+		failure = "error";
+	else if (mediaState == OBS_MEDIA_STATE_ENDED || (ended && mediaState != OBS_MEDIA_STATE_PLAYING))
+		failure = "ended";
+
+	bool stalled = mediaState == OBS_MEDIA_STATE_OPENING || mediaState == OBS_MEDIA_STATE_BUFFERING || noData;
+	bool healthy = mediaState == OBS_MEDIA_STATE_PLAYING && !noData;
+
+	if (healthy) {
+		watch->StalledSince = 0;
+		if (!watch->HealthySince)
+			watch->HealthySince = now;
+
+		if (watch->RestartPending) {
+			// Prefer the `media_started` timestamp, the check itself may run up to one interval later
+			uint64_t startedAt = watch->StartedAt.load();
+			uint64_t recoveredAt = (startedAt > watch->LastRestartAt && startedAt <= now) ? startedAt : now;
+			uint64_t restartLatency = recoveredAt - watch->LastRestartAt;
+			watch->RestartPending = false;
+			watch->RecoveryCount++;
+			watch->LastRestartLatency = restartLatency;
+			watch->TotalRestartLatency += restartLatency;
+			_recoveries++;
+
+			blog(LOG_INFO, "[IngestWatchdog::_Check] Ingest `%s` recovered %.0fms after restart attempt %d.",
+				QT_TO_UTF8(watch->SourceName), (double)restartLatency / 1000000.0, watch->ConsecutiveRestarts);
+
+			auto websocketManager = GetWebsocketManager();
+			if (websocketManager) {
+				QJsonObject eventData;
+				eventData["sourceName"] = watch->SourceName;
+				eventData["restartLatency"] = (double)(restartLatency / 1000000);
+				eventData["restartAttempts"] = watch->ConsecutiveRestarts;
+				websocketManager->BroadcastEvent(EventSubscription::MediaInputs, "IngestWatchdogRecovered", eventData);
+			}
+		}
+
+		if (now - watch->HealthySince >= (uint64_t)settings.StableDuration * 1000000) {
+			watch->ConsecutiveRestarts = 0;
+			watch->NextRestartAt = 0;
+			watch->GaveUp = false;
+		}
+		return;
+	}
+
+	watch->HealthySince = 0;
+
+	if (!failure) {
+		if (!stalled) {
+			// Idle, paused or stopped on purpose
+			watch->StalledSince = 0;
+			return;
+		}
+		if (!watch->StalledSince)
+			watch->StalledSince = now;
+		if (now - watch->StalledSince < (uint64_t)settings.StallTimeout * 1000000)
+			return;
+		failure = noData ? "noData" : "stalled";
+	}
+
+	if (watch->GaveUp || now < watch->NextRestartAt)
+		return;
+
+	if (settings.MaxRestarts > 0 && watch->ConsecutiveRestarts >= settings.MaxRestarts) {
+		watch->GaveUp = true;
+		blog(LOG_WARNING, "[IngestWatchdog::_Check] Giving up on ingest `%s` after %d consecutive restarts.", QT_TO_UTF8(watch->SourceName), watch->ConsecutiveRestarts);
+		return;
+	}
+
+	_Restart(watch, source, failure, now);
+}
+
+void IngestWatchdog::_Restart(Watch *watch, obs_source_t *source, const char *reason, uint64_t now)
+{
+	const IngestWatchdogSettings &settings = watch->Settings;
+
+	// Bounded exponential backoff: the first restart is immediate, the following ones are spaced by
+	// InitialBackoff, 2x, 4x... up to MaxBackoff
+	watch->ConsecutiveRestarts++;
+	int shift = std::min(watch->ConsecutiveRestarts - 1, 30);
+	uint64_t backoff = std::min((uint64_t)settings.InitialBackoff << shift, (uint64_t)settings.MaxBackoff);
+
+	watch->RestartCount++;
+	watch->LastRestartAt = now;
+	watch->NextRestartAt = now + backoff * 1000000;
+	watch->RestartPending = true;
+	watch->StalledSince = 0;
+	watch->LastReason = reason;
+	_restarts++;
+
+	blog(LOG_INFO, "[IngestWatchdog::_Restart] Restarting ingest `%s` (reason `%s`, attempt %d).", QT_TO_UTF8(watch->SourceName), reason, watch->ConsecutiveRestarts);
+
+	obs_source_media_restart(source);
+
+	auto websocketManager = GetWebsocketManager();
+	if (websocketManager) {
+		QJsonObject eventData;
+		eventData["sourceName"] = watch->SourceName;
+		eventData["reason"] = reason;
+		eventData["restartAttempt"] = watch->ConsecutiveRestarts;
+		eventData["backoff"] = (double)backoff;
+		websocketManager->BroadcastEvent(EventSubscription::MediaInputs, "IngestWatchdogRestarted", eventData);
+	}
+}
+
+void IngestWatchdog::_Attach(Watch *watch)
+{
+	OBSSourceAutoRelease source = obs_get_source_by_name(QT_TO_UTF8(watch->SourceName));
+	if (!source)
+		return;
+
+	watch->Source = OBSGetWeakRef(source);
+	watch->EndedSignaled = false;
+	watch->StalledSince = 0;
+	watch->HealthySince = 0;
+
+	signal_handler_t *signalHandler = obs_source_get_signal_handler(source);
+	signal_handler_connect(signalHandler, "media_ended", MediaEndedCallback, watch);
+	signal_handler_connect(signalHandler, "media_started", MediaStartedCallback, watch);
+}
+
+void IngestWatchdog::_Detach(Watch *watch)
+{
+	if (!watch->Source)
+		return;
+
+	OBSSourceAutoRelease source = obs_weak_source_get_source(watch->Source);
+	if (source) {
+		signal_handler_t *signalHandler = obs_source_get_signal_handler(source);
+		signal_handler_disconnect(signalHandler, "media_ended", MediaEndedCallback, watch);
+		signal_handler_disconnect(signalHandler, "media_started", MediaStartedCallback, watch);
+	}
+	watch->Source = nullptr;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <thread>
+#include <obs.hpp>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QWaitCondition>
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include "../plugin-main.h"
+
+struct IngestWatchdogSettings {
+	// Milliseconds an ingest may stay stalled (opening, buffering or playing without data) before a restart
+	int StallTimeout = 5000;
+	// Delay before the second consecutive restart. Doubles with every further attempt up to `MaxBackoff`.
+	int InitialBackoff = 1000;
+	int MaxBackoff = 30000;
+	// Consecutive restarts before the watchdog gives up until the ingest recovers. 0 is unlimited.
+	int MaxRestarts = 0;
+	// Milliseconds an ingest must play cleanly before the backoff is reset
+	int StableDuration = 10000;
+};
+
+// Watches `vlc_source` ingests and restarts them with `obs_source_media_restart()` when they error out,
+// end or stall. `media_ended` and `media_started` signals wake the watchdog thread immediately; the
+// restart itself is always issued from that thread since libvlc must not be stopped from its own
+// event callbacks. Consecutive restarts are spaced with a bounded exponential backoff.
+class IngestWatchdog {
+	public:
+		IngestWatchdog();
+		~IngestWatchdog();
+
+		void SetWatchdog(const QString &sourceName, const IngestWatchdogSettings &settings);
+		// Returns false if no watchdog exists for the source
+		bool RemoveWatchdog(const QString &sourceName);
+		QJsonArray GetWatchdogs();
+
+		QJsonObject GetStats();
+
+	private:
+		struct Watch;
+
+		static void MediaEndedCallback(void *param, calldata_t *);
+		static void MediaStartedCallback(void *param, calldata_t *);
+		void _WatchLoop();
+		void _Check(Watch *watch, uint64_t now);
+		void _Restart(Watch *watch, obs_source_t *source, const char *reason, uint64_t now);
+		void _Attach(Watch *watch);
+		void _Detach(Watch *watch);
+
+		QMutex _mutex;
+		QWaitCondition _condition;
+		std::map<QString, std::unique_ptr<Watch>> _watches;
+		bool _running;
+		std::thread _watchThread;
+
+		std::atomic<uint64_t> _restarts;
+		std::atomic<uint64_t> _recoveries;
+};
+
+typedef std::shared_ptr<IngestWatchdog> IngestWatchdogPtr;
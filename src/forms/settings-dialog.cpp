@@ -30,9 +30,11 @@ SettingsDialog::SettingsDialog(QWidget* parent) :
 	reconnectTimer->setSingleShot(true);
 	connect(reconnectTimer, &QTimer::timeout, this, &SettingsDialog::onReconnectTimerTimeout);
 
+	workerPoolStatusTimer = new QTimer(this);
+	connect(workerPoolStatusTimer, &QTimer::timeout, this, &SettingsDialog::UpdateWorkerPoolStatus);
+
 	auto websocketManager = GetWebsocketManager();
 	QObject::connect(websocketManager.get(), &WebsocketManager::connectionStateChanged, this, &SettingsDialog::onConnectionStateChanged);
-	QObject::connect(websocketManager.get(), &WebsocketManager::connectionIdentificationSuccess, [=]() {SetConnectionStatusIndicator(true);});
 }
 
 SettingsDialog::~SettingsDialog()
@@ -40,6 +42,9 @@ SettingsDialog::~SettingsDialog()
 	if (reconnectTimer->isActive())
 		reconnectTimer->stop();
 	delete reconnectTimer;
+	if (workerPoolStatusTimer->isActive())
+		workerPoolStatusTimer->stop();
+	delete workerPoolStatusTimer;
 	delete ui;
 }
 
@@ -52,11 +57,26 @@ void SettingsDialog::showEvent(QShowEvent* event)
 	else
 		ui->connectOnLoad->setCheckState(Qt::Unchecked);
 	ui->sessionKey->setText(conf->SessionKey);
+	ui->additionalSessionKeys->setText(conf->AdditionalSessionKeys.join(','));
 	ui->connectUrl->setText(conf->ConnectUrl);
 	if (conf->AutoReconnect)
 		ui->autoReconnect->setCheckState(Qt::Checked);
 	else
 		ui->autoReconnect->setCheckState(Qt::Unchecked);
+	ui->workerThreadCount->setValue(conf->WorkerThreadCount);
+	ui->workerThreadPriority->setCurrentIndex(conf->WorkerThreadPriority);
+	ui->workerCpuAffinity->setText(conf->WorkerCpuAffinity);
+	ui->workerNiceness->setValue(conf->WorkerNiceness);
+	ui->workerExpiryTimeout->setValue(conf->WorkerExpiryTimeout);
+
+	UpdateWorkerPoolStatus();
+	workerPoolStatusTimer->start(1000);
+}
+
+void SettingsDialog::hideEvent(QHideEvent* event)
+{
+	workerPoolStatusTimer->stop();
+	QDialog::hideEvent(event);
 }
 
 void SettingsDialog::ToggleShowHide()
@@ -77,20 +97,31 @@ void SettingsDialog::SaveSettings()
 		UpdateConnectUi();
 	}
 
-	websocketManager->SessionKey = ui->sessionKey->text();
+	QStringList additionalSessionKeys = ui->additionalSessionKeys->text().split(',', QString::SkipEmptyParts);
+	for (auto &sessionKey : additionalSessionKeys)
+		sessionKey = sessionKey.trimmed();
+	websocketManager->SetSessionKeys(ui->sessionKey->text(), additionalSessionKeys);
 
 	if (ui->connectOnLoad->checkState() == Qt::Checked)
 		conf->ConnectOnLoad = true;
 	else
 		conf->ConnectOnLoad = false;
 	conf->SessionKey = ui->sessionKey->text();
+	conf->AdditionalSessionKeys = additionalSessionKeys;
 	conf->ConnectUrl = ui->connectUrl->text();
 	if (ui->autoReconnect->checkState() == Qt::Checked)
 		conf->AutoReconnect = true;
 	else
 		conf->AutoReconnect = false;
+	conf->WorkerThreadCount = ui->workerThreadCount->value();
+	conf->WorkerThreadPriority = ui->workerThreadPriority->currentIndex();
+	conf->WorkerCpuAffinity = ui->workerCpuAffinity->text();
+	conf->WorkerNiceness = ui->workerNiceness->value();
+	conf->WorkerExpiryTimeout = ui->workerExpiryTimeout->value();
 
 	conf->Save();
+
+	websocketManager->GetWorkerPool()->Configure(conf->GetWorkerPoolSettings());
 }
 
 void SettingsDialog::DialogButtonClicked(QAbstractButton *button)
@@ -107,6 +138,16 @@ void SettingsDialog::DialogButtonClicked(QAbstractButton *button)
 			msgBox.exec();
 			return;
 		}
+		for (auto additionalSessionKey : ui->additionalSessionKeys->text().split(',', QString::SkipEmptyParts)) {
+			additionalSessionKey = additionalSessionKey.trimmed();
+			if (additionalSessionKey.isEmpty() || keyValidator.validate(additionalSessionKey, pos) == QValidator::Acceptable)
+				continue;
+			QMessageBox msgBox;
+			msgBox.setWindowTitle(obs_module_text("IRLTKSelfHost.Panel.ErrorTitle"));
+			msgBox.setText(obs_module_text("IRLTKSelfHost.Panel.InvalidSessionKeyFormat"));
+			msgBox.exec();
+			return;
+		}
 		SettingsDialog::SaveSettings();
 		if (signalButton == QDialogButtonBox::AcceptRole) {
 			QDialog::accept();
@@ -133,17 +174,17 @@ void SettingsDialog::ConnectDisconnectButtonClicked()
 	}
 }
 
-void SettingsDialog::onConnectionStateChanged(QAbstractSocket::SocketState state)
+void SettingsDialog::onConnectionStateChanged(ConnectionState state)
 {
 #ifdef DEBUG_MODE
-	blog(LOG_INFO, "[SettingsDialog::onConnectionStateChanged] Socket state changed. New state: %d", state);
+	blog(LOG_INFO, "[SettingsDialog::onConnectionStateChanged] Connection state changed. New state: %s", ConnectionStateMachine::StateName(state));
 #endif
 	auto config = GetConfig();
 	auto websocketManager = GetWebsocketManager();
 	uint16_t closeCode = websocketManager->GetCloseCode();
 
 	UpdateConnectUi();
-	if (state == QAbstractSocket::UnconnectedState) {
+	if (state == ConnectionState::Closed) {
 		if (websocketManager->GetCloseError() != QAbstractSocket::UnknownSocketError) {
 			if (isVisible() && !reconnectTimer->isActive()) {
 				QMessageBox msgBox;
@@ -185,7 +226,7 @@ void SettingsDialog::onConnectionStateChanged(QAbstractSocket::SocketState state
 		){
 			StartReconnectTimer();
 		}
-	} else if (state == QAbstractSocket::ConnectedState) {
+	} else if (state == ConnectionState::Handshaking || state == ConnectionState::Identified) {
 		StopReconnectTimer();
 	}
 }
@@ -252,17 +293,27 @@ void SettingsDialog::StopReconnectTimer()
 void SettingsDialog::UpdateConnectUi()
 {
 	auto websocketManager = GetWebsocketManager();
-	auto state = websocketManager->GetSocketState();
+	auto state = websocketManager->GetConnectionState();
 
 	switch (state) {
-		case QAbstractSocket::UnconnectedState:
+		case ConnectionState::Closed:
 			ui->connectDisconnect->setEnabled(true);
 			ui->connectDisconnect->setText("Connect");
 			SetConnectionStatusIndicator(false);
 			break;
-		case QAbstractSocket::ConnectedState:
+		case ConnectionState::Handshaking:
 			ui->connectDisconnect->setEnabled(true);
 			ui->connectDisconnect->setText("Disconnect");
+			SetConnectionStatusIndicator(false);
+			break;
+		case ConnectionState::Identified:
+			ui->connectDisconnect->setEnabled(true);
+			ui->connectDisconnect->setText("Disconnect");
+			SetConnectionStatusIndicator(true);
+			break;
+		case ConnectionState::Draining:
+			ui->connectDisconnect->setEnabled(false);
+			ui->connectDisconnect->setText("Disconnecting...");
 			break;
 		default:
 			ui->connectDisconnect->setEnabled(false);
@@ -271,6 +322,18 @@ void SettingsDialog::UpdateConnectUi()
 	}
 }
 
+void SettingsDialog::UpdateWorkerPoolStatus()
+{
+	auto websocketManager = GetWebsocketManager();
+	QJsonObject stats = websocketManager->GetWorkerPool()->GetStats();
+
+	ui->workerPoolStatus->setText(QString(obs_module_text("IRLTKSelfHost.Panel.WorkerPoolStatusFormat"))
+		.arg(stats["activeThreadCount"].toInt())
+		.arg(stats["maxThreadCount"].toInt())
+		.arg(stats["queuedTasks"].toDouble())
+		.arg(stats["utilization"].toDouble() * 100.0, 0, 'f', 1));
+}
+
 void SettingsDialog::SetConnectionStatusIndicator(bool active) {
 	if (active) {
 		ui->connectionStatus->setPixmap(QPixmap(":/logos/checkmark"));
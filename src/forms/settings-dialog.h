@@ -3,6 +3,7 @@
 #include <QtWidgets/QDialog>
 
 #include "ui_settings-dialog.h"
+#include "../ConnectionStateMachine.h"
 
 class SettingsDialog : public QDialog
 {
@@ -12,18 +13,21 @@ class SettingsDialog : public QDialog
 		explicit SettingsDialog(QWidget* parent = 0);
 		~SettingsDialog();
 		void showEvent(QShowEvent* event);
+		void hideEvent(QHideEvent* event);
 		void ToggleShowHide();
 
 	private Q_SLOTS:
 		void SaveSettings();
 		void DialogButtonClicked(QAbstractButton *button);
 		void ConnectDisconnectButtonClicked();
-		void onConnectionStateChanged(QAbstractSocket::SocketState state);
+		void onConnectionStateChanged(ConnectionState state);
 		void onReconnectTimerTimeout();
+		void UpdateWorkerPoolStatus();
 
 	private:
 		Ui::SettingsDialog* ui;
 		QTimer *reconnectTimer;
+		QTimer *workerPoolStatusTimer;
 
 		bool websocketManuallyDisconnected;
 		int reconnectTimerTotal;
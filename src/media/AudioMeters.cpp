@@ -0,0 +1,369 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <util/platform.h>
+#include <QtEndian>
+
+#include "AudioMeters.h"
+#include "SimdKernels.h"
+#include "../BinaryFrame.h"
+#include "../WebsocketManager.h"
+
+// Lower bound used for silence, matching the -100dB floor `CacheUpdate` uses for volumes
+#define LEVEL_FLOOR_DB -100.0
+
+// A meter is considered inactive if no full window has completed within this many windows (or 500ms)
+#define ACTIVE_WINDOW_COUNT 3
+
+struct AudioMeters::Meter {
+	AudioMeters *Parent = nullptr;
+	QString SourceName;
+
+	// Weak, so that metering does not keep a removed source alive. Tick thread only.
+	OBSWeakSource Source;
+
+	// Set before the capture callback is attached, read on the audio thread
+	std::atomic<uint32_t> Channels;
+	std::atomic<uint32_t> WindowFrames;
+
+	// Audio thread only
+	uint32_t Frames = 0;
+	float Peak[MAX_AUDIO_CHANNELS];
+	double SumSquares[MAX_AUDIO_CHANNELS];
+
+	// Published once per window: linear peak in the high 32 bits and linear RMS in the low 32 bits
+	std::atomic<uint64_t> Levels[MAX_AUDIO_CHANNELS];
+	std::atomic<uint64_t> LastWindowAt;
+	std::atomic<bool> Muted;
+
+	Meter() :
+		Channels(0),
+		WindowFrames(0),
+		LastWindowAt(0),
+		Muted(false)
+	{
+		ResetAccumulators();
+		for (size_t i = 0; i < MAX_AUDIO_CHANNELS; i++)
+			Levels[i] = 0;
+	}
+
+	void ResetAccumulators()
+	{
+		Frames = 0;
+		for (size_t i = 0; i < MAX_AUDIO_CHANNELS; i++) {
+			Peak[i] = 0.0f;
+			SumSquares[i] = 0.0;
+		}
+	}
+};
+
+static inline uint64_t PackLevels(float peak, float rms)
+{
+	uint32_t peakBits, rmsBits;
+	memcpy(&peakBits, &peak, sizeof(peakBits));
+	memcpy(&rmsBits, &rms, sizeof(rmsBits));
+	return ((uint64_t)peakBits << 32) | rmsBits;
+}
+
+static inline void UnpackLevels(uint64_t levels, float &peak, float &rms)
+{
+	uint32_t peakBits = (uint32_t)(levels >> 32);
+	uint32_t rmsBits = (uint32_t)levels;
+	memcpy(&peak, &peakBits, sizeof(peak));
+	memcpy(&rms, &rmsBits, sizeof(rms));
+}
+
+static inline double LinearToDb(float value)
+{
+	if (value <= 0.0f)
+		return LEVEL_FLOOR_DB;
+	return std::max(LEVEL_FLOOR_DB, 20.0 * std::log10((double)value));
+}
+
+AudioMeters::AudioMeters() :
+	_running(true),
+	_createdAt(os_gettime_ns()),
+	_tickSequence(0),
+	_callbacks(0),
+	_callbackTime(0),
+	_framesSent(0)
+{
+	_tickThread = std::thread(&AudioMeters::_TickLoop, this);
+}
+
+AudioMeters::~AudioMeters()
+{
+	{
+		QMutexLocker locker(&_metersMutex);
+		_running = false;
+		_tickCondition.wakeAll();
+	}
+	_tickThread.join();
+
+	for (auto &meter : _meters)
+		_Detach(meter.get());
+}
+
+void AudioMeters::SetSettings(const AudioMeterSettings &settings)
+{
+	QMutexLocker locker(&_metersMutex);
+	_settings = settings;
+
+	uint32_t sampleRate = audio_output_get_sample_rate(obs_get_audio());
+	uint32_t windowFrames = std::max(1u, (uint32_t)(sampleRate / _settings.Rate));
+
+	// Rebuild the list in the requested order, since the binary frames reference meters by index
+	std::vector<std::unique_ptr<Meter>> meters;
+	for (auto sourceName : _settings.SourceNames) {
+		auto it = std::find_if(_meters.begin(), _meters.end(), [&](const std::unique_ptr<Meter> &meter) {
+			return meter && meter->SourceName == sourceName;
+		});
+		if (it != _meters.end()) {
+			meters.push_back(std::move(*it));
+		} else {
+			auto meter = std::unique_ptr<Meter>(new Meter());
+			meter->Parent = this;
+			meter->SourceName = sourceName;
+			meters.push_back(std::move(meter));
+		}
+		meters.back()->WindowFrames = windowFrames;
+	}
+
+	for (auto &meter : _meters) {
+		if (meter)
+			_Detach(meter.get());
+	}
+	_meters = std::move(meters);
+
+	_tickCondition.wakeAll();
+}
+
+AudioMeterSettings AudioMeters::GetSettings()
+{
+	QMutexLocker locker(&_metersMutex);
+	return _settings;
+}
+
+bool AudioMeters::GetLevels(const QString &sourceName, QJsonObject &levels)
+{
+	QMutexLocker locker(&_metersMutex);
+	uint64_t now = os_gettime_ns();
+	for (auto &meter : _meters) {
+		if (meter->SourceName == sourceName) {
+			levels = _GetMeterLevels(meter.get(), now);
+			return true;
+		}
+	}
+	return false;
+}
+
+QJsonArray AudioMeters::GetAllLevels()
+{
+	QMutexLocker locker(&_metersMutex);
+	uint64_t now = os_gettime_ns();
+	QJsonArray ret;
+	for (auto &meter : _meters)
+		ret.append(_GetMeterLevels(meter.get(), now));
+	return ret;
+}
+
+QJsonObject AudioMeters::GetStats()
+{
+	QJsonObject ret;
+
+	size_t meteredSources;
+	size_t attachedSources = 0;
+	{
+		QMutexLocker locker(&_metersMutex);
+		meteredSources = _meters.size();
+		for (auto &meter : _meters) {
+			if (meter->Source)
+				attachedSources++;
+		}
+	}
+
+	uint64_t uptime = os_gettime_ns() - _createdAt;
+	uint64_t callbacks = _callbacks;
+	uint64_t callbackTime = _callbackTime;
+
+	ret["kernel"] = SimdKernels::InstructionSet();
+	ret["meteredSources"] = (double)meteredSources;
+	ret["attachedSources"] = (double)attachedSources;
+	ret["callbacks"] = (double)callbacks;
+	ret["averageCallbackTime"] = callbacks ? ((double)callbackTime / callbacks) / 1000000.0 : 0.0;
+	// Fraction of wall time the audio thread spent inside the meter callbacks
+	ret["audioThreadLoad"] = uptime ? (double)callbackTime / (double)uptime : 0.0;
+	ret["framesSent"] = (double)_framesSent;
+
+	return ret;
+}
+
+void AudioMeters::AudioCaptureCallback(void *param, obs_source_t *, const struct audio_data *audioData, bool muted)
+{
+	auto meter = static_cast<Meter*>(param);
+	uint64_t startedAt = os_gettime_ns();
+
+	uint32_t channels = meter->Channels.load(std::memory_order_relaxed);
+	for (uint32_t channel = 0; channel < channels; channel++) {
+		const float *samples = (const float*)audioData->data[channel];
+		if (!samples)
+			continue;
+
+		float peak, sumSquares;
+		SimdKernels::PeakAndSumSquares(samples, audioData->frames, &peak, &sumSquares);
+		meter->Peak[channel] = std::max(meter->Peak[channel], peak);
+		meter->SumSquares[channel] += sumSquares;
+	}
+	meter->Frames += audioData->frames;
+	meter->Muted.store(muted, std::memory_order_relaxed);
+
+	if (meter->Frames >= meter->WindowFrames.load(std::memory_order_relaxed)) {
+		for (uint32_t channel = 0; channel < channels; channel++) {
+			float rms = (float)std::sqrt(meter->SumSquares[channel] / meter->Frames);
+			meter->Levels[channel].store(PackLevels(meter->Peak[channel], rms), std::memory_order_relaxed);
+		}
+		meter->LastWindowAt.store(startedAt, std::memory_order_release);
+		meter->ResetAccumulators();
+	}
+
+	AudioMeters *parent = meter->Parent;
+	parent->_callbacks.fetch_add(1, std::memory_order_relaxed);
+	parent->_callbackTime.fetch_add(os_gettime_ns() - startedAt, std::memory_order_relaxed);
+}
+
+void AudioMeters::_TickLoop()
+{
+	QMutexLocker locker(&_metersMutex);
+	while (_running) {
+		unsigned long interval = _meters.empty() ? 1000 : (unsigned long)(1000.0 / _settings.Rate);
+		_tickCondition.wait(&_metersMutex, std::max(1ul, interval));
+		if (!_running)
+			break;
+		_Tick();
+	}
+}
+
+void AudioMeters::_Tick()
+{
+	for (auto &meter : _meters) {
+		if (meter->Source) {
+			OBSSourceAutoRelease source = obs_weak_source_get_source(meter->Source);
+			if (!source) {
+				// Destroyed sources drop their capture callbacks themselves
+				meter->Source = nullptr;
+				meter->LastWindowAt = 0;
+			} else if (obs_source_removed(source)) {
+				_Detach(meter.get());
+			}
+		}
+		if (!meter->Source)
+			_Attach(meter.get());
+	}
+
+	if (!_settings.Enabled || _meters.empty())
+		return;
+
+	auto websocketManager = GetWebsocketManager();
+	if (!websocketManager || !websocketManager->IsIdentified())
+		return;
+
+	uint64_t now = os_gettime_ns();
+	uint64_t windowDuration = (uint64_t)(1000000000.0 / _settings.Rate);
+	uint64_t activeTimeout = std::max(windowDuration * ACTIVE_WINDOW_COUNT, (uint64_t)500000000);
+
+	QByteArray payload;
+	payload.reserve(9 + (int)_meters.size() * (3 + MAX_AUDIO_CHANNELS * 4));
+	payload.resize(9);
+	qToLittleEndian<quint64>(now, (uchar*)payload.data());
+	uint8_t meterCount = 0;
+
+	for (size_t i = 0; i < _meters.size() && i < 256; i++) {
+		Meter *meter = _meters[i].get();
+		if (!meter->Source)
+			continue;
+
+		uint64_t lastWindowAt = meter->LastWindowAt.load(std::memory_order_acquire);
+		bool active = lastWindowAt && (now - lastWindowAt) < activeTimeout;
+		uint32_t channels = meter->Channels.load(std::memory_order_relaxed);
+
+		uchar header[3];
+		header[0] = (uchar)i;
+		header[1] = (active ? 1 : 0) | (meter->Muted.load(std::memory_order_relaxed) ? 2 : 0);
+		header[2] = (uchar)channels;
+		payload.append((const char*)header, sizeof(header));
+
+		for (uint32_t channel = 0; channel < channels; channel++) {
+			float peak = 0.0f, rms = 0.0f;
+			if (active)
+				UnpackLevels(meter->Levels[channel].load(std::memory_order_relaxed), peak, rms);
+			uchar levels[4];
+			qToLittleEndian<qint16>((qint16)std::lround(LinearToDb(peak) * 100.0), levels);
+			qToLittleEndian<qint16>((qint16)std::lround(LinearToDb(rms) * 100.0), levels + 2);
+			payload.append((const char*)levels, sizeof(levels));
+		}
+		meterCount++;
+	}
+	payload[8] = (char)meterCount;
+
+	websocketManager->BroadcastBinary(EventSubscription::AudioLevels, BinaryFrameType::AudioLevels, ++_tickSequence, payload);
+	_framesSent++;
+}
+
+void AudioMeters::_Attach(Meter *meter)
+{
+	OBSSourceAutoRelease source = obs_get_source_by_name(QT_TO_UTF8(meter->SourceName));
+	if (!source || !(obs_source_get_output_flags(source) & OBS_SOURCE_AUDIO))
+		return;
+
+	meter->Channels = std::min((uint32_t)audio_output_get_channels(obs_get_audio()), (uint32_t)MAX_AUDIO_CHANNELS);
+	meter->ResetAccumulators();
+	meter->LastWindowAt = 0;
+	meter->Source = OBSGetWeakRef(source);
+	obs_source_add_audio_capture_callback(source, AudioCaptureCallback, meter);
+
+#ifdef DEBUG_MODE
+	blog(LOG_INFO, "[AudioMeters::_Attach] Metering source `%s` with %u channels.", QT_TO_UTF8(meter->SourceName), meter->Channels.load());
+#endif
+}
+
+void AudioMeters::_Detach(Meter *meter)
+{
+	if (!meter->Source)
+		return;
+
+	// Once this returns the audio thread is no longer inside the callback for this meter
+	OBSSourceAutoRelease source = obs_weak_source_get_source(meter->Source);
+	if (source)
+		obs_source_remove_audio_capture_callback(source, AudioCaptureCallback, meter);
+	meter->Source = nullptr;
+	meter->LastWindowAt = 0;
+}
+
+QJsonObject AudioMeters::_GetMeterLevels(Meter *meter, uint64_t now)
+{
+	QJsonObject ret;
+	ret["sourceName"] = meter->SourceName;
+	ret["sourceOk"] = (bool)meter->Source;
+
+	uint64_t windowDuration = (uint64_t)(1000000000.0 / _settings.Rate);
+	uint64_t activeTimeout = std::max(windowDuration * ACTIVE_WINDOW_COUNT, (uint64_t)500000000);
+	uint64_t lastWindowAt = meter->LastWindowAt.load(std::memory_order_acquire);
+	bool active = meter->Source && lastWindowAt && (now - lastWindowAt) < activeTimeout;
+	ret["audioActive"] = active;
+	ret["muted"] = meter->Muted.load(std::memory_order_relaxed);
+
+	QJsonArray channels;
+	uint32_t channelCount = meter->Source ? meter->Channels.load(std::memory_order_relaxed) : 0;
+	for (uint32_t channel = 0; channel < channelCount; channel++) {
+		float peak = 0.0f, rms = 0.0f;
+		if (active)
+			UnpackLevels(meter->Levels[channel].load(std::memory_order_relaxed), peak, rms);
+		QJsonObject channelLevels;
+		channelLevels["peak"] = LinearToDb(peak);
+		channelLevels["rms"] = LinearToDb(rms);
+		channels.append(channelLevels);
+	}
+	ret["channels"] = channels;
+
+	return ret;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <obs.hpp>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QWaitCondition>
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include "../plugin-main.h"
+
+struct AudioMeterSettings {
+	// Push level frames to sessions subscribed to `EventSubscription::AudioLevels`
+	bool Enabled = false;
+	// Level updates per second
+	double Rate = 20.0;
+	QStringList SourceNames;
+};
+
+// Taps each metered source with an audio capture callback. Peak and sum of squares are accumulated with the
+// SIMD kernel on the audio thread, and once per decimation window the result is published to per-channel atomics.
+// A separate tick thread reads those at the configured rate, re-attaches to sources that were (re)created and
+// pushes a single compact binary frame for all meters.
+class AudioMeters {
+	public:
+		AudioMeters();
+		~AudioMeters();
+
+		void SetSettings(const AudioMeterSettings &settings);
+		AudioMeterSettings GetSettings();
+
+		// Returns false if `sourceName` is not metered
+		bool GetLevels(const QString &sourceName, QJsonObject &levels);
+		QJsonArray GetAllLevels();
+
+		QJsonObject GetStats();
+
+	private:
+		struct Meter;
+
+		static void AudioCaptureCallback(void *param, obs_source_t *source, const struct audio_data *audioData, bool muted);
+		void _TickLoop();
+		void _Tick();
+		void _Attach(Meter *meter);
+		void _Detach(Meter *meter);
+		QJsonObject _GetMeterLevels(Meter *meter, uint64_t now);
+
+		// Guards the settings and the meter list. Never taken on the audio thread.
+		QMutex _metersMutex;
+		QWaitCondition _tickCondition;
+		AudioMeterSettings _settings;
+		std::vector<std::unique_ptr<Meter>> _meters;
+		bool _running;
+		std::thread _tickThread;
+
+		uint64_t _createdAt;
+		uint32_t _tickSequence;
+		std::atomic<uint64_t> _callbacks;
+		std::atomic<uint64_t> _callbackTime;
+		std::atomic<uint64_t> _framesSent;
+};
+
+typedef std::shared_ptr<AudioMeters> AudioMetersPtr;
@@ -0,0 +1,85 @@
+#include "FilterSettingsCoalescer.h"
+
+FilterSettingsCoalescer::FilterSettingsCoalescer() :
+	_queued(0),
+	_coalesced(0),
+	_applied(0)
+{
+	obs_add_tick_callback(FilterSettingsCoalescer::TickCallback, this);
+}
+
+FilterSettingsCoalescer::~FilterSettingsCoalescer()
+{
+	// Waits for a running tick callback, since libobs holds its callback lock while calling them
+	obs_remove_tick_callback(FilterSettingsCoalescer::TickCallback, this);
+}
+
+void FilterSettingsCoalescer::Queue(obs_source_t *filter, obs_data_t *settings, bool overlay)
+{
+	QMutexLocker locker(&_mutex);
+	_queued++;
+
+	for (auto &pending : _pending) {
+		// The pointer alone could belong to a new filter that reused the memory of a removed one
+		if (pending.Filter != filter || !obs_weak_source_references_source(pending.WeakFilter, filter))
+			continue;
+
+		if (!overlay) {
+			OBSDataAutoRelease replacement = obs_data_create();
+			pending.Settings = replacement.Get();
+			pending.Overlay = false;
+		}
+		obs_data_apply(pending.Settings, settings);
+		_coalesced++;
+		return;
+	}
+
+	// A private copy, so later overlays can be merged into it
+	OBSDataAutoRelease pendingSettings = obs_data_create();
+	obs_data_apply(pendingSettings, settings);
+
+	PendingUpdate pending;
+	pending.Filter = filter;
+	pending.WeakFilter = OBSGetWeakRef(filter);
+	pending.Settings = pendingSettings.Get();
+	pending.Overlay = overlay;
+	_pending.push_back(pending);
+}
+
+QJsonObject FilterSettingsCoalescer::GetStats()
+{
+	QJsonObject ret;
+	ret["queued"] = (double)_queued;
+	ret["coalesced"] = (double)_coalesced;
+	ret["applied"] = (double)_applied;
+	return ret;
+}
+
+void FilterSettingsCoalescer::TickCallback(void *param, float)
+{
+	static_cast<FilterSettingsCoalescer*>(param)->_Apply();
+}
+
+void FilterSettingsCoalescer::_Apply()
+{
+	std::vector<PendingUpdate> pending;
+	{
+		QMutexLocker locker(&_mutex);
+		if (_pending.empty())
+			return;
+		pending.swap(_pending);
+	}
+
+	for (auto &update : pending) {
+		OBSSourceAutoRelease filter = obs_weak_source_get_source(update.WeakFilter);
+		if (!filter)
+			continue;
+
+		if (!update.Overlay) {
+			OBSDataAutoRelease currentSettings = obs_source_get_settings(filter);
+			obs_data_clear(currentSettings);
+		}
+		obs_source_update(filter, update.Settings);
+		_applied++;
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <obs.hpp>
+#include <QtCore/QMutex>
+#include <QJsonObject>
+
+#include "../plugin-main.h"
+
+// Collects filter settings updates and applies them from an `obs_add_tick_callback()` callback, so a filter is
+// updated at most once per rendered frame no matter how fast a client scrubs a value. Updates queued for the same
+// filter within one frame are merged: overlays are applied onto the pending settings, a replacement discards them.
+class FilterSettingsCoalescer {
+	public:
+		FilterSettingsCoalescer();
+		~FilterSettingsCoalescer();
+
+		// `overlay` applies `settings` on top of the current settings instead of replacing them
+		void Queue(obs_source_t *filter, obs_data_t *settings, bool overlay);
+
+		QJsonObject GetStats();
+
+	private:
+		struct PendingUpdate {
+			obs_source_t *Filter;
+			OBSWeakSource WeakFilter;
+			OBSData Settings;
+			bool Overlay;
+		};
+
+		static void TickCallback(void *param, float seconds);
+		void _Apply();
+
+		QMutex _mutex;
+		std::vector<PendingUpdate> _pending;
+
+		std::atomic<uint64_t> _queued;
+		std::atomic<uint64_t> _coalesced;
+		std::atomic<uint64_t> _applied;
+};
+
+typedef std::shared_ptr<FilterSettingsCoalescer> FilterSettingsCoalescerPtr;
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#include "SimdKernels.h"
+
+const char *SimdKernels::InstructionSet()
+{
+#if defined(SIMD_SSE2)
+	return "sse2";
+#elif defined(SIMD_NEON)
+	return "neon";
+#else
+	return "scalar";
+#endif
+}
+
+// acc[i] += row[i] for `count` bytes. uint16 accumulators are safe for up to 257 rows.
+static inline void AccumulateRow(uint16_t *acc, const uint8_t *row, size_t count)
+{
+	size_t i = 0;
+#if defined(SIMD_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16) {
+		__m128i pixels = _mm_loadu_si128((const __m128i*)(row + i));
+		__m128i accLo = _mm_loadu_si128((const __m128i*)(acc + i));
+		__m128i accHi = _mm_loadu_si128((const __m128i*)(acc + i + 8));
+		_mm_storeu_si128((__m128i*)(acc + i), _mm_add_epi16(accLo, _mm_unpacklo_epi8(pixels, zero)));
+		_mm_storeu_si128((__m128i*)(acc + i + 8), _mm_add_epi16(accHi, _mm_unpackhi_epi8(pixels, zero)));
+	}
+#elif defined(SIMD_NEON)
+	for (; i + 16 <= count; i += 16) {
+		uint8x16_t pixels = vld1q_u8(row + i);
+		vst1q_u16(acc + i, vaddw_u8(vld1q_u16(acc + i), vget_low_u8(pixels)));
+		vst1q_u16(acc + i + 8, vaddw_u8(vld1q_u16(acc + i + 8), vget_high_u8(pixels)));
+	}
+#endif
+	for (; i < count; i++)
+		acc[i] += row[i];
+}
+
+void SimdKernels::DownscalePlane(const uint8_t *src, uint32_t srcStride, uint32_t srcWidth, uint32_t srcHeight,
+	uint8_t *dst, uint32_t dstStride, uint32_t dstWidth, uint32_t dstHeight, uint32_t channels)
+{
+	if (!src || !dst || !srcWidth || !srcHeight || !dstWidth || !dstHeight || !channels)
+		return;
+
+	size_t rowLength = (size_t)srcWidth * channels;
+	std::vector<uint16_t> columnSums(rowLength);
+
+	for (uint32_t y = 0; y < dstHeight; y++) {
+		uint32_t y0 = (uint32_t)(((uint64_t)y * srcHeight) / dstHeight);
+		uint32_t y1 = (uint32_t)(((uint64_t)(y + 1) * srcHeight) / dstHeight);
+		if (y1 <= y0)
+			y1 = y0 + 1;
+		if (y1 - y0 > 256)
+			y1 = y0 + 256;
+
+		// Vertical pass: sum the source rows covered by this destination row (the bulk of the memory traffic)
+		std::fill(columnSums.begin(), columnSums.end(), 0);
+		for (uint32_t row = y0; row < y1; row++)
+			AccumulateRow(columnSums.data(), src + (size_t)row * srcStride, rowLength);
+
+		// Horizontal pass over the much smaller column sums
+		uint32_t rows = y1 - y0;
+		uint8_t *dstRow = dst + (size_t)y * dstStride;
+		for (uint32_t x = 0; x < dstWidth; x++) {
+			uint32_t x0 = (uint32_t)(((uint64_t)x * srcWidth) / dstWidth);
+			uint32_t x1 = (uint32_t)(((uint64_t)(x + 1) * srcWidth) / dstWidth);
+			if (x1 <= x0)
+				x1 = x0 + 1;
+
+			uint32_t area = (x1 - x0) * rows;
+			for (uint32_t c = 0; c < channels; c++) {
+				uint32_t sum = 0;
+				for (uint32_t column = x0; column < x1; column++)
+					sum += columnSums[(size_t)column * channels + c];
+				dstRow[(size_t)x * channels + c] = (uint8_t)((sum + area / 2) / area);
+			}
+		}
+	}
+}
+
+void SimdKernels::PeakAndSumSquares(const float *samples, size_t count, float *peak, float *sumSquares)
+{
+	size_t i = 0;
+	float peakValue = 0.0f;
+	float sumValue = 0.0f;
+
+#if defined(SIMD_SSE2)
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	__m128 peakVec = _mm_setzero_ps();
+	__m128 sumVec = _mm_setzero_ps();
+	for (; i + 4 <= count; i += 4) {
+		__m128 block = _mm_loadu_ps(samples + i);
+		peakVec = _mm_max_ps(peakVec, _mm_and_ps(block, absMask));
+		sumVec = _mm_add_ps(sumVec, _mm_mul_ps(block, block));
+	}
+	float lanes[4];
+	_mm_storeu_ps(lanes, peakVec);
+	peakValue = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+	_mm_storeu_ps(lanes, sumVec);
+	sumValue = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(SIMD_NEON)
+	float32x4_t peakVec = vdupq_n_f32(0.0f);
+	float32x4_t sumVec = vdupq_n_f32(0.0f);
+	for (; i + 4 <= count; i += 4) {
+		float32x4_t block = vld1q_f32(samples + i);
+		peakVec = vmaxq_f32(peakVec, vabsq_f32(block));
+		sumVec = vmlaq_f32(sumVec, block, block);
+	}
+	float lanes[4];
+	vst1q_f32(lanes, peakVec);
+	peakValue = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+	vst1q_f32(lanes, sumVec);
+	sumValue = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+
+	for (; i < count; i++) {
+		float sample = samples[i];
+		peakValue = std::max(peakValue, std::fabs(sample));
+		sumValue += sample * sample;
+	}
+
+	*peak = peakValue;
+	*sumSquares = sumValue;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Hot loops that run on libobs' video and audio threads. Each kernel has an SSE2 (x86/x64) or NEON (arm64)
+// implementation with a scalar fallback for the remainder and for other architectures.
+namespace SimdKernels {
+	const char *InstructionSet();
+
+	// Box-filter downscale of an 8-bit plane holding `channels` interleaved components per pixel.
+	// Supports any ratio, but each destination pixel may cover at most 256 source rows.
+	void DownscalePlane(const uint8_t *src, uint32_t srcStride, uint32_t srcWidth, uint32_t srcHeight,
+		uint8_t *dst, uint32_t dstStride, uint32_t dstWidth, uint32_t dstHeight, uint32_t channels);
+
+	// Absolute peak and sum of squares of a block of float samples, for peak/RMS level metering.
+	void PeakAndSumSquares(const float *samples, size_t count, float *peak, float *sumSquares);
+};
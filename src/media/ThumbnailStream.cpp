@@ -0,0 +1,361 @@
+#include <util/platform.h>
+#include <QtCore/QBuffer>
+#include <QtCore/QDeadlineTimer>
+#include <QtConcurrent/QtConcurrent>
+#include <QtGui/QImageWriter>
+
+#include "ThumbnailStream.h"
+#include "SimdKernels.h"
+#include "../BinaryFrame.h"
+#include "../WebsocketManager.h"
+
+static inline uint8_t ClampToByte(float value)
+{
+	if (value <= 0.0f)
+		return 0;
+	if (value >= 255.0f)
+		return 255;
+	return (uint8_t)(value + 0.5f);
+}
+
+// Converts the downscaled planes into a 32-bit BGRX image. Only runs on thumbnail sized data, so it is kept scalar.
+static void ConvertYuvToRgb32(QImage &image, const uint8_t *lumaPlane, const uint8_t *uPlane, const uint8_t *vPlane,
+	uint32_t chromaStride, uint32_t chromaStep, uint32_t chromaShift, bool bt709, bool fullRange)
+{
+	float kr = bt709 ? 1.5748f : 1.402f;
+	float kgu = bt709 ? 0.1873f : 0.344136f;
+	float kgv = bt709 ? 0.4681f : 0.714136f;
+	float kb = bt709 ? 1.8556f : 1.772f;
+	float lumaScale = fullRange ? 1.0f : 255.0f / 219.0f;
+	float lumaOffset = fullRange ? 0.0f : 16.0f;
+	float chromaScale = fullRange ? 1.0f : 255.0f / 224.0f;
+
+	int width = image.width();
+	int height = image.height();
+	for (int y = 0; y < height; y++) {
+		uint8_t *dstRow = image.scanLine(y);
+		const uint8_t *lumaRow = lumaPlane + (size_t)y * width;
+		size_t chromaRow = (size_t)(y >> chromaShift) * chromaStride;
+		for (int x = 0; x < width; x++) {
+			size_t chromaIndex = chromaRow + (size_t)(x >> chromaShift) * chromaStep;
+			float luma = ((float)lumaRow[x] - lumaOffset) * lumaScale;
+			float u = ((float)uPlane[chromaIndex] - 128.0f) * chromaScale;
+			float v = ((float)vPlane[chromaIndex] - 128.0f) * chromaScale;
+
+			dstRow[x * 4 + 0] = ClampToByte(luma + kb * u);
+			dstRow[x * 4 + 1] = ClampToByte(luma - kgu * u - kgv * v);
+			dstRow[x * 4 + 2] = ClampToByte(luma + kr * v);
+			dstRow[x * 4 + 3] = 0xFF;
+		}
+	}
+}
+
+ThumbnailStream::ThumbnailStream() :
+	_callbackActive(false),
+	_oneShotRequests(0),
+	_broadcast(false),
+	_videoInfo(),
+	_thumbnailWidth(0),
+	_thumbnailHeight(0),
+	_frameInterval(0),
+	_quality(-1),
+	_lastCaptureTime(0),
+	_encoding(false),
+	_lastEncodeFailed(false),
+	_capturedFrames(0),
+	_droppedFrames(0),
+	_encodedFrames(0),
+	_encodeFailures(0),
+	_captureTime(0),
+	_encodeTime(0)
+{
+	_encodePool.setMaxThreadCount(1);
+}
+
+ThumbnailStream::~ThumbnailStream()
+{
+	{
+		QMutexLocker locker(&_settingsMutex);
+		_Stop();
+	}
+	_encodePool.waitForDone();
+}
+
+void ThumbnailStream::SetSettings(const ThumbnailSettings &settings)
+{
+	QMutexLocker locker(&_settingsMutex);
+	_settings = settings;
+	_broadcast = settings.Enabled;
+
+	// Restart so that the new size/rate (and any video reset since the last start) is picked up
+	_Stop();
+	if (_settings.Enabled || _oneShotRequests > 0)
+		_Start();
+}
+
+ThumbnailSettings ThumbnailStream::GetSettings()
+{
+	QMutexLocker locker(&_settingsMutex);
+	return _settings;
+}
+
+bool ThumbnailStream::GetThumbnail(Thumbnail &thumbnail, int timeoutMs)
+{
+	uint32_t previousSequence;
+	{
+		QMutexLocker locker(&_thumbnailMutex);
+		previousSequence = _thumbnail.Sequence;
+	}
+
+	bool needsCapture;
+	{
+		QMutexLocker locker(&_settingsMutex);
+		needsCapture = !_settings.Enabled || previousSequence == 0;
+		if (needsCapture) {
+			_oneShotRequests++;
+			if (!_callbackActive && !_Start()) {
+				_oneShotRequests--;
+				return false;
+			}
+		}
+	}
+
+	bool ret = true;
+	{
+		QMutexLocker locker(&_thumbnailMutex);
+		if (needsCapture) {
+			QDeadlineTimer deadline(timeoutMs);
+			while (_thumbnail.Sequence == previousSequence) {
+				if (!_thumbnailCondition.wait(&_thumbnailMutex, deadline))
+					break;
+			}
+			ret = _thumbnail.Sequence != previousSequence;
+		}
+		if (ret)
+			thumbnail = _thumbnail;
+	}
+
+	if (needsCapture) {
+		QMutexLocker locker(&_settingsMutex);
+		_oneShotRequests--;
+		if (!_settings.Enabled && _oneShotRequests == 0)
+			_Stop();
+	}
+
+	return ret;
+}
+
+QJsonObject ThumbnailStream::GetStats()
+{
+	QJsonObject ret;
+
+	uint64_t capturedFrames = _capturedFrames;
+	uint64_t encodedFrames = _encodedFrames;
+
+	ret["kernel"] = SimdKernels::InstructionSet();
+	ret["capturedFrames"] = (double)capturedFrames;
+	ret["droppedFrames"] = (double)_droppedFrames;
+	ret["encodedFrames"] = (double)encodedFrames;
+	ret["encodeFailures"] = (double)_encodeFailures;
+	ret["averageCaptureTime"] = capturedFrames ? ((double)_captureTime / capturedFrames) / 1000000.0 : 0.0;
+	ret["averageEncodeTime"] = encodedFrames ? ((double)_encodeTime / encodedFrames) / 1000000.0 : 0.0;
+
+	return ret;
+}
+
+void ThumbnailStream::RawVideoCallback(void *param, struct video_data *frame)
+{
+	auto thumbnailStream = static_cast<ThumbnailStream*>(param);
+	thumbnailStream->_ProcessFrame(frame);
+}
+
+bool ThumbnailStream::_Start()
+{
+	if (_callbackActive)
+		return true;
+
+	if (!obs_get_video_info(&_videoInfo)) {
+		blog(LOG_WARNING, "[ThumbnailStream::_Start] Video is not initialized, unable to start the thumbnail stream.");
+		return false;
+	}
+
+	switch (_videoInfo.output_format) {
+		case VIDEO_FORMAT_NV12:
+		case VIDEO_FORMAT_I420:
+		case VIDEO_FORMAT_I444:
+		case VIDEO_FORMAT_BGRA:
+		case VIDEO_FORMAT_BGRX:
+		case VIDEO_FORMAT_RGBA:
+			break;
+		default:
+			blog(LOG_WARNING, "[ThumbnailStream::_Start] Unsupported output video format: %s", get_video_format_name(_videoInfo.output_format));
+			return false;
+	}
+
+	uint32_t outputWidth = _videoInfo.output_width;
+	uint32_t outputHeight = _videoInfo.output_height;
+
+	// The downscale kernel is limited to 256 source rows per destination row, hence the lower bound
+	uint32_t minimumWidth = std::max<uint32_t>(32, outputWidth / 256 + 1);
+	uint32_t minimumHeight = std::max<uint32_t>(32, outputHeight / 256 + 1);
+	_thumbnailWidth = std::max<uint32_t>(minimumWidth, std::min<uint32_t>(_settings.Width, outputWidth));
+	if (_settings.Height > 0)
+		_thumbnailHeight = _settings.Height;
+	else
+		_thumbnailHeight = (uint32_t)(((uint64_t)_thumbnailWidth * outputHeight) / outputWidth);
+	_thumbnailHeight = std::max<uint32_t>(minimumHeight, std::min<uint32_t>(_thumbnailHeight, outputHeight));
+
+	_frameInterval = (uint64_t)(1000000000.0 / std::max(0.01, _settings.Fps));
+	_format = _settings.Format;
+	_quality = _settings.Quality;
+	_lastCaptureTime = 0;
+
+	// No conversion is requested: letting libobs convert would run swscale on every frame at full resolution.
+	obs_add_raw_video_callback(nullptr, RawVideoCallback, this);
+	_callbackActive = true;
+
+#ifdef DEBUG_MODE
+	blog(LOG_INFO, "[ThumbnailStream::_Start] Thumbnail stream started at %ux%u (%s kernel).", _thumbnailWidth, _thumbnailHeight, SimdKernels::InstructionSet());
+#endif
+
+	return true;
+}
+
+void ThumbnailStream::_Stop()
+{
+	if (!_callbackActive)
+		return;
+
+	// Blocks until any in-progress callback has returned
+	obs_remove_raw_video_callback(RawVideoCallback, this);
+	_callbackActive = false;
+}
+
+void ThumbnailStream::_ProcessFrame(struct video_data *frame)
+{
+	if (_lastCaptureTime && frame->timestamp - _lastCaptureTime < _frameInterval)
+		return;
+
+	if (_encoding) {
+		_droppedFrames++;
+		return;
+	}
+	_lastCaptureTime = frame->timestamp;
+
+	uint64_t startTime = os_gettime_ns();
+
+	uint32_t srcWidth = _videoInfo.output_width;
+	uint32_t srcHeight = _videoInfo.output_height;
+	uint32_t dstWidth = _thumbnailWidth;
+	uint32_t dstHeight = _thumbnailHeight;
+	bool bt709 = _videoInfo.colorspace != VIDEO_CS_601;
+	bool fullRange = _videoInfo.range == VIDEO_RANGE_FULL;
+
+	QImage image;
+	switch (_videoInfo.output_format) {
+		case VIDEO_FORMAT_NV12: {
+			uint32_t chromaWidth = (dstWidth + 1) / 2;
+			uint32_t chromaHeight = (dstHeight + 1) / 2;
+			_lumaBuffer.resize((size_t)dstWidth * dstHeight);
+			_chromaBuffer[0].resize((size_t)chromaWidth * chromaHeight * 2);
+			SimdKernels::DownscalePlane(frame->data[0], frame->linesize[0], srcWidth, srcHeight, _lumaBuffer.data(), dstWidth, dstWidth, dstHeight, 1);
+			SimdKernels::DownscalePlane(frame->data[1], frame->linesize[1], srcWidth / 2, srcHeight / 2, _chromaBuffer[0].data(), chromaWidth * 2, chromaWidth, chromaHeight, 2);
+			image = QImage(dstWidth, dstHeight, QImage::Format_RGB32);
+			ConvertYuvToRgb32(image, _lumaBuffer.data(), _chromaBuffer[0].data(), _chromaBuffer[0].data() + 1, chromaWidth * 2, 2, 1, bt709, fullRange);
+			break;
+		}
+		case VIDEO_FORMAT_I420:
+		case VIDEO_FORMAT_I444: {
+			bool subsampled = _videoInfo.output_format == VIDEO_FORMAT_I420;
+			uint32_t chromaShift = subsampled ? 1 : 0;
+			uint32_t chromaWidth = subsampled ? (dstWidth + 1) / 2 : dstWidth;
+			uint32_t chromaHeight = subsampled ? (dstHeight + 1) / 2 : dstHeight;
+			_lumaBuffer.resize((size_t)dstWidth * dstHeight);
+			SimdKernels::DownscalePlane(frame->data[0], frame->linesize[0], srcWidth, srcHeight, _lumaBuffer.data(), dstWidth, dstWidth, dstHeight, 1);
+			for (size_t plane = 0; plane < 2; plane++) {
+				_chromaBuffer[plane].resize((size_t)chromaWidth * chromaHeight);
+				SimdKernels::DownscalePlane(frame->data[plane + 1], frame->linesize[plane + 1], srcWidth >> chromaShift, srcHeight >> chromaShift,
+					_chromaBuffer[plane].data(), chromaWidth, chromaWidth, chromaHeight, 1);
+			}
+			image = QImage(dstWidth, dstHeight, QImage::Format_RGB32);
+			ConvertYuvToRgb32(image, _lumaBuffer.data(), _chromaBuffer[0].data(), _chromaBuffer[1].data(), chromaWidth, 1, chromaShift, bt709, fullRange);
+			break;
+		}
+		default: {
+			// Packed 32-bit formats are downscaled straight into the image. The program alpha is meaningless, so it is made opaque.
+			bool rgba = _videoInfo.output_format == VIDEO_FORMAT_RGBA;
+			image = QImage(dstWidth, dstHeight, rgba ? QImage::Format_RGBX8888 : QImage::Format_RGB32);
+			SimdKernels::DownscalePlane(frame->data[0], frame->linesize[0], srcWidth, srcHeight, image.bits(), image.bytesPerLine(), dstWidth, dstHeight, 4);
+			for (uint32_t y = 0; y < dstHeight; y++) {
+				uint8_t *row = image.scanLine(y);
+				for (uint32_t x = 0; x < dstWidth; x++)
+					row[x * 4 + 3] = 0xFF;
+			}
+			break;
+		}
+	}
+
+	_capturedFrames++;
+	_captureTime += os_gettime_ns() - startTime;
+
+	_encoding = true;
+	uint64_t timestamp = frame->timestamp;
+	QString format = _format;
+	int quality = _quality;
+	QtConcurrent::run(&_encodePool, [=]() {
+		_EncodeFrame(image, timestamp, format, quality);
+		_encoding = false;
+	});
+}
+
+void ThumbnailStream::_EncodeFrame(QImage image, uint64_t timestamp, QString format, int quality)
+{
+	uint64_t startTime = os_gettime_ns();
+
+	QByteArray encodedImage;
+	QBuffer buffer(&encodedImage);
+	buffer.open(QBuffer::WriteOnly);
+	QImageWriter writer(&buffer, format.toLatin1());
+	writer.setQuality(quality);
+	if (!writer.write(image)) {
+		_encodeFailures++;
+		_lastEncodeFailed = true;
+		blog(LOG_WARNING, "[ThumbnailStream::_EncodeFrame] Failed to encode thumbnail: %s", QT_TO_UTF8(writer.errorString()));
+		return;
+	}
+	buffer.close();
+
+	_lastEncodeFailed = false;
+	_encodedFrames++;
+	_encodeTime += os_gettime_ns() - startTime;
+
+	uint32_t sequence;
+	{
+		QMutexLocker locker(&_thumbnailMutex);
+		_thumbnail.Sequence++;
+		if (_thumbnail.Sequence == 0)
+			_thumbnail.Sequence = 1;
+		_thumbnail.Timestamp = timestamp;
+		_thumbnail.Width = image.width();
+		_thumbnail.Height = image.height();
+		_thumbnail.Format = format;
+		_thumbnail.Data = encodedImage;
+		sequence = _thumbnail.Sequence;
+	}
+	_thumbnailCondition.wakeAll();
+
+	if (!_broadcast)
+		return;
+
+	auto websocketManager = GetWebsocketManager();
+	if (!websocketManager)
+		return;
+
+	QByteArray payload(12, Qt::Uninitialized);
+	qToLittleEndian<quint64>(timestamp, (uchar*)payload.data());
+	qToLittleEndian<quint16>(image.width(), (uchar*)payload.data() + 8);
+	qToLittleEndian<quint16>(image.height(), (uchar*)payload.data() + 10);
+	payload.append(encodedImage);
+
+	websocketManager->BroadcastBinary(EventSubscription::ProgramThumbnails, BinaryFrameType::ProgramThumbnail, sequence, payload);
+}
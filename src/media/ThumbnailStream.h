@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <obs.hpp>
+#include <QtCore/QByteArray>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QThreadPool>
+#include <QtCore/QWaitCondition>
+#include <QtGui/QImage>
+#include <QJsonObject>
+
+#include "../plugin-main.h"
+
+struct ThumbnailSettings {
+	bool Enabled = false;
+	double Fps = 1.0;
+	int Width = 320;
+	// 0 keeps the aspect ratio of the program output
+	int Height = 0;
+	QString Format = "jpg";
+	int Quality = 70;
+};
+
+struct Thumbnail {
+	uint64_t Timestamp = 0;
+	uint32_t Sequence = 0;
+	int Width = 0;
+	int Height = 0;
+	QString Format;
+	QByteArray Data;
+};
+
+// Taps the program output with a raw video callback, downscales the frames on the video thread with
+// the SIMD box filter and encodes them on a dedicated single-thread pool. Frames arriving while the
+// previous one is still being encoded are dropped rather than queued.
+class ThumbnailStream {
+	public:
+		ThumbnailStream();
+		~ThumbnailStream();
+
+		void SetSettings(const ThumbnailSettings &settings);
+		ThumbnailSettings GetSettings();
+
+		// Returns the most recent thumbnail. If the stream is disabled, a single frame is captured first.
+		bool GetThumbnail(Thumbnail &thumbnail, int timeoutMs);
+
+		bool LastEncodeFailed()
+		{
+			return _lastEncodeFailed;
+		}
+
+		QJsonObject GetStats();
+
+	private:
+		static void RawVideoCallback(void *param, struct video_data *frame);
+		bool _Start();
+		void _Stop();
+		void _ProcessFrame(struct video_data *frame);
+		void _EncodeFrame(QImage image, uint64_t timestamp, QString format, int quality);
+
+		QMutex _settingsMutex;
+		ThumbnailSettings _settings;
+		bool _callbackActive;
+		int _oneShotRequests;
+		std::atomic<bool> _broadcast;
+
+		// Written by `_Start()` while the callback is disconnected, read on the video thread
+		struct obs_video_info _videoInfo;
+		uint32_t _thumbnailWidth;
+		uint32_t _thumbnailHeight;
+		uint64_t _frameInterval;
+		QString _format;
+		int _quality;
+
+		// Video thread only
+		uint64_t _lastCaptureTime;
+		std::vector<uint8_t> _lumaBuffer;
+		std::vector<uint8_t> _chromaBuffer[2];
+
+		std::atomic<bool> _encoding;
+		std::atomic<bool> _lastEncodeFailed;
+		QThreadPool _encodePool;
+
+		QMutex _thumbnailMutex;
+		QWaitCondition _thumbnailCondition;
+		Thumbnail _thumbnail;
+
+		std::atomic<uint64_t> _capturedFrames;
+		std::atomic<uint64_t> _droppedFrames;
+		std::atomic<uint64_t> _encodedFrames;
+		std::atomic<uint64_t> _encodeFailures;
+		std::atomic<uint64_t> _captureTime;
+		std::atomic<uint64_t> _encodeTime;
+};
+
+typedef std::shared_ptr<ThumbnailStream> ThumbnailStreamPtr;
@@ -0,0 +1,125 @@
+#include <util/platform.h>
+#include <QtCore/QFileInfo>
+
+#include "ReplayBuffer.h"
+#include "../WebsocketManager.h"
+
+ReplayBuffer::ReplayBuffer() :
+	_saveCount(0),
+	_lastSavedAt(0)
+{
+	obs_frontend_add_event_callback(ReplayBuffer::FrontendEventCallback, this);
+}
+
+ReplayBuffer::~ReplayBuffer()
+{
+	obs_frontend_remove_event_callback(ReplayBuffer::FrontendEventCallback, this);
+}
+
+uint64_t ReplayBuffer::GetSaveCount()
+{
+	QMutexLocker locker(&_mutex);
+	return _saveCount;
+}
+
+bool ReplayBuffer::WaitForSave(uint64_t previousSaveCount, int timeoutMs)
+{
+	QMutexLocker locker(&_mutex);
+	uint64_t deadline = os_gettime_ns() + (uint64_t)timeoutMs * 1000000;
+
+	while (_saveCount <= previousSaveCount) {
+		uint64_t now = os_gettime_ns();
+		if (now >= deadline)
+			return false;
+		_condition.wait(&_mutex, (unsigned long)((deadline - now + 999999) / 1000000));
+	}
+	return true;
+}
+
+QString ReplayBuffer::GetLastReplayPath()
+{
+	QMutexLocker locker(&_mutex);
+	return _lastReplayPath;
+}
+
+QJsonObject ReplayBuffer::GetLastReplay()
+{
+	QMutexLocker locker(&_mutex);
+	if (_lastReplayPath.isEmpty())
+		return QJsonObject();
+
+	QFileInfo fileInfo(_lastReplayPath);
+	QJsonObject ret;
+	ret["savedReplayPath"] = _lastReplayPath;
+	// The file may have been moved or deleted since
+	ret["fileExists"] = fileInfo.isFile();
+	ret["fileSize"] = (double)fileInfo.size();
+	ret["timestamp"] = (double)(_lastSavedAt / 1000000);
+	return ret;
+}
+
+QJsonObject ReplayBuffer::GetStats()
+{
+	QMutexLocker locker(&_mutex);
+	QJsonObject ret;
+	ret["savedReplays"] = (double)_saveCount;
+	return ret;
+}
+
+void ReplayBuffer::FrontendEventCallback(enum obs_frontend_event event, void *param)
+{
+	auto replayBuffer = static_cast<ReplayBuffer*>(param);
+
+	switch (event) {
+		case OBS_FRONTEND_EVENT_REPLAY_BUFFER_SAVED:
+			replayBuffer->_Saved(os_gettime_ns());
+			break;
+		case OBS_FRONTEND_EVENT_REPLAY_BUFFER_STARTED:
+		case OBS_FRONTEND_EVENT_REPLAY_BUFFER_STOPPED: {
+			QJsonObject eventData;
+			eventData["outputActive"] = event == OBS_FRONTEND_EVENT_REPLAY_BUFFER_STARTED;
+			replayBuffer->_Broadcast("ReplayBufferStateChanged", eventData);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+void ReplayBuffer::_Saved(uint64_t now)
+{
+	// The replay output reports the file it just wrote through its `get_last_replay` procedure
+	QString path;
+	OBSOutputAutoRelease replayOutput = obs_frontend_get_replay_buffer_output();
+	if (replayOutput) {
+		calldata_t calldata = {0};
+		proc_handler_t *procHandler = obs_output_get_proc_handler(replayOutput);
+		proc_handler_call(procHandler, "get_last_replay", &calldata);
+		path = QString::fromUtf8(calldata_string(&calldata, "path"));
+		calldata_free(&calldata);
+	}
+
+	if (path.isEmpty()) {
+		blog(LOG_WARNING, "[ReplayBuffer::_Saved] The replay buffer did not report the path of the saved replay.");
+		return;
+	}
+
+	{
+		QMutexLocker locker(&_mutex);
+		_lastReplayPath = path;
+		_lastSavedAt = now;
+		_saveCount++;
+		_condition.wakeAll();
+	}
+
+	_Broadcast("ReplayBufferSaved", GetLastReplay());
+}
+
+void ReplayBuffer::_Broadcast(const char *eventType, const QJsonObject &eventData)
+{
+	auto websocketManager = GetWebsocketManager();
+	if (!websocketManager)
+		return;
+
+	websocketManager->BroadcastEvent(EventSubscription::Outputs, eventType, eventData);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <obs.hpp>
+#include <obs-frontend-api.h>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QWaitCondition>
+#include <QJsonObject>
+
+#include "../plugin-main.h"
+
+// Follows the frontend replay buffer and remembers the last saved replay, so that a save request can wait for its file
+// and the file can be fetched afterwards. Every save is reported with a `ReplayBufferSaved` event.
+class ReplayBuffer {
+	public:
+		ReplayBuffer();
+		~ReplayBuffer();
+
+		// Number of replays saved so far, to pass to `WaitForSave()`
+		uint64_t GetSaveCount();
+		// Blocks until a replay after `previousSaveCount` was saved, or until the timeout elapses. Returns false on timeout.
+		bool WaitForSave(uint64_t previousSaveCount, int timeoutMs);
+
+		// Empty if no replay was saved since OBS started
+		QString GetLastReplayPath();
+		QJsonObject GetLastReplay();
+
+		QJsonObject GetStats();
+
+	private:
+		static void FrontendEventCallback(enum obs_frontend_event event, void *param);
+
+		void _Saved(uint64_t now);
+		void _Broadcast(const char *eventType, const QJsonObject &eventData);
+
+		QMutex _mutex;
+		QWaitCondition _condition;
+		uint64_t _saveCount;
+		QString _lastReplayPath;
+		uint64_t _lastSavedAt;
+};
+
+typedef std::shared_ptr<ReplayBuffer> ReplayBufferPtr;
@@ -0,0 +1,256 @@
+#include <obs-frontend-api.h>
+#include <util/platform.h>
+
+#include "SimulcastOutputs.h"
+#include "../stats/StreamSupervisor.h"
+
+struct SimulcastOutputs::Destination {
+	SimulcastOutputs *Parent = nullptr;
+	QString Name;
+	SimulcastOutputSettings Settings;
+	OBSService Service;
+	OBSOutput Output;
+
+	uint64_t StartedAt = 0;
+	uint64_t StoppedAt = 0;
+	uint64_t StartCount = 0;
+	int LastStopCode = 0;
+	QString LastError;
+};
+
+SimulcastOutputs::SimulcastOutputs() :
+	_starts(0),
+	_failedStarts(0)
+{
+}
+
+SimulcastOutputs::~SimulcastOutputs()
+{
+	for (auto &entry : _destinations) {
+		Destination *destination = entry.second.get();
+		signal_handler_t *signalHandler = obs_output_get_signal_handler(destination->Output);
+		signal_handler_disconnect(signalHandler, "start", SimulcastOutputs::StartCallback, destination);
+		signal_handler_disconnect(signalHandler, "stop", SimulcastOutputs::StopCallback, destination);
+		obs_output_force_stop(destination->Output);
+	}
+}
+
+RequestStatus SimulcastOutputs::CreateOutput(const QString &outputName, const SimulcastOutputSettings &settings, QString &comment)
+{
+	QString outputType = OutputType(settings.ServerUrl);
+	if (outputType.isEmpty()) {
+		comment = "Parameter: serverUrl\nOnly rtmp://, rtmps:// and srt:// destinations are supported.";
+		return RequestStatus::InvalidRequestParameter;
+	}
+
+	QMutexLocker locker(&_mutex);
+	if (_destinations.count(outputName)) {
+		comment = "An output with that name already exists.";
+		return RequestStatus::InvalidRequestParameter;
+	}
+
+	// `rtmp_custom` only carries the URL and key, which is also how the frontend configures SRT destinations
+	OBSDataAutoRelease serviceSettings = obs_data_create();
+	obs_data_set_string(serviceSettings, "server", QT_TO_UTF8(settings.ServerUrl));
+	obs_data_set_string(serviceSettings, "key", QT_TO_UTF8(settings.StreamKey));
+	QString objectName = QString("irltk_simulcast_%1").arg(outputName);
+	OBSServiceAutoRelease service = obs_service_create("rtmp_custom", QT_TO_UTF8(objectName), serviceSettings, nullptr);
+	OBSOutputAutoRelease output = obs_output_create(QT_TO_UTF8(outputType), QT_TO_UTF8(objectName), nullptr, nullptr);
+	if (!service || !output) {
+		comment = "Creating the output failed.";
+		return RequestStatus::RequestProcessingFailed;
+	}
+	obs_output_set_service(output, service);
+	obs_output_set_reconnect_settings(output, settings.MaxRetries, settings.RetryDelay);
+
+	auto destination = std::unique_ptr<Destination>(new Destination());
+	destination->Parent = this;
+	destination->Name = outputName;
+	destination->Settings = settings;
+	destination->Service = service.Get();
+	destination->Output = output.Get();
+
+	signal_handler_t *signalHandler = obs_output_get_signal_handler(output);
+	signal_handler_connect(signalHandler, "start", SimulcastOutputs::StartCallback, destination.get());
+	signal_handler_connect(signalHandler, "stop", SimulcastOutputs::StopCallback, destination.get());
+
+	_destinations[outputName] = std::move(destination);
+	return RequestStatus::NoError;
+}
+
+RequestStatus SimulcastOutputs::RemoveOutput(const QString &outputName)
+{
+	std::unique_ptr<Destination> destination;
+	{
+		QMutexLocker locker(&_mutex);
+		auto it = _destinations.find(outputName);
+		if (it == _destinations.end())
+			return RequestStatus::OutputNotFound;
+		destination = std::move(it->second);
+		_destinations.erase(it);
+	}
+
+	// The signal callbacks take `_mutex`, so they are disconnected without it
+	signal_handler_t *signalHandler = obs_output_get_signal_handler(destination->Output);
+	signal_handler_disconnect(signalHandler, "start", SimulcastOutputs::StartCallback, destination.get());
+	signal_handler_disconnect(signalHandler, "stop", SimulcastOutputs::StopCallback, destination.get());
+	if (obs_output_active(destination->Output))
+		obs_output_stop(destination->Output);
+
+	return RequestStatus::NoError;
+}
+
+RequestStatus SimulcastOutputs::StartOutput(const QString &outputName, QString &comment)
+{
+	OBSOutput output;
+	{
+		QMutexLocker locker(&_mutex);
+		auto it = _destinations.find(outputName);
+		if (it == _destinations.end())
+			return RequestStatus::OutputNotFound;
+		output = it->second->Output;
+	}
+
+	if (obs_output_active(output))
+		return RequestStatus::OutputRunning;
+
+	// The frontend attaches its encoders to the streaming output when it first starts streaming
+	OBSOutputAutoRelease streamOutput = obs_frontend_get_streaming_output();
+	obs_encoder_t *videoEncoder = streamOutput ? obs_output_get_video_encoder(streamOutput) : nullptr;
+	obs_encoder_t *audioEncoder = streamOutput ? obs_output_get_audio_encoder(streamOutput, 0) : nullptr;
+	if (!videoEncoder || !audioEncoder) {
+		comment = "The streaming output has no encoders to share yet. Start the main stream once first.";
+		return RequestStatus::OutputStartFailed;
+	}
+
+	obs_output_set_video_encoder(output, videoEncoder);
+	obs_output_set_audio_encoder(output, audioEncoder, 0);
+
+	_starts++;
+	if (!obs_output_start(output)) {
+		const char *lastError = obs_output_get_last_error(output);
+		comment = (lastError && *lastError) ? QString("Starting the output failed: %1").arg(lastError) : QString("Starting the output failed.");
+		_failedStarts++;
+		return RequestStatus::OutputStartFailed;
+	}
+
+	return RequestStatus::NoError;
+}
+
+RequestStatus SimulcastOutputs::StopOutput(const QString &outputName)
+{
+	OBSOutput output;
+	{
+		QMutexLocker locker(&_mutex);
+		auto it = _destinations.find(outputName);
+		if (it == _destinations.end())
+			return RequestStatus::OutputNotFound;
+		output = it->second->Output;
+	}
+
+	if (!obs_output_active(output))
+		return RequestStatus::OutputNotRunning;
+
+	obs_output_stop(output);
+	return RequestStatus::NoError;
+}
+
+QJsonArray SimulcastOutputs::GetOutputs(const QString &outputName)
+{
+	QMutexLocker locker(&_mutex);
+	uint64_t now = os_gettime_ns();
+
+	QJsonArray ret;
+	for (auto &entry : _destinations) {
+		if (!outputName.isEmpty() && entry.first != outputName)
+			continue;
+		ret.append(_GetDestinationJson(entry.second.get(), now));
+	}
+	return ret;
+}
+
+QJsonObject SimulcastOutputs::GetStats()
+{
+	QMutexLocker locker(&_mutex);
+
+	size_t activeOutputs = 0;
+	for (auto &entry : _destinations) {
+		if (obs_output_active(entry.second->Output))
+			activeOutputs++;
+	}
+
+	QJsonObject ret;
+	ret["outputs"] = (double)_destinations.size();
+	ret["activeOutputs"] = (double)activeOutputs;
+	ret["starts"] = (double)_starts;
+	ret["failedStarts"] = (double)_failedStarts;
+	return ret;
+}
+
+void SimulcastOutputs::StartCallback(void *param, calldata_t *)
+{
+	auto destination = static_cast<Destination*>(param);
+	QMutexLocker locker(&destination->Parent->_mutex);
+	destination->StartedAt = os_gettime_ns();
+	destination->StoppedAt = 0;
+	destination->StartCount++;
+}
+
+void SimulcastOutputs::StopCallback(void *param, calldata_t *data)
+{
+	auto destination = static_cast<Destination*>(param);
+	int code = (int)calldata_int(data, "code");
+	const char *lastError = obs_output_get_last_error(destination->Output);
+
+	QMutexLocker locker(&destination->Parent->_mutex);
+	destination->StoppedAt = os_gettime_ns();
+	destination->LastStopCode = code;
+	destination->LastError = lastError ? lastError : "";
+
+	if (code != OBS_OUTPUT_SUCCESS)
+		blog(LOG_WARNING, "[SimulcastOutputs::StopCallback] Output `%s` stopped (reason `%s`).", QT_TO_UTF8(destination->Name), StreamSupervisor::StopCodeName(code));
+}
+
+QString SimulcastOutputs::OutputType(const QString &serverUrl)
+{
+	if (serverUrl.startsWith("rtmp://", Qt::CaseInsensitive) || serverUrl.startsWith("rtmps://", Qt::CaseInsensitive))
+		return "rtmp_output";
+	if (serverUrl.startsWith("srt://", Qt::CaseInsensitive))
+		return "ffmpeg_mpegts_muxer";
+	return QString();
+}
+
+QJsonObject SimulcastOutputs::_GetDestinationJson(Destination *destination, uint64_t now)
+{
+	obs_output_t *output = destination->Output;
+	bool active = obs_output_active(output);
+
+	QJsonObject ret;
+	ret["outputName"] = destination->Name;
+	// The stream key is never echoed back
+	ret["serverUrl"] = destination->Settings.ServerUrl;
+	ret["outputKind"] = obs_output_get_id(output);
+	ret["maxRetries"] = destination->Settings.MaxRetries;
+	ret["retryDelay"] = destination->Settings.RetryDelay;
+
+	uint64_t totalBytes = obs_output_get_total_bytes(output);
+	uint64_t duration = (active && destination->StartedAt) ? now - destination->StartedAt : 0;
+	ret["outputActive"] = active;
+	ret["outputReconnecting"] = obs_output_reconnecting(output);
+	ret["outputBytes"] = (double)totalBytes;
+	ret["outputTotalFrames"] = obs_output_get_total_frames(output);
+	ret["outputDroppedFrames"] = obs_output_get_frames_dropped(output);
+	ret["outputCongestion"] = obs_output_get_congestion(output);
+	ret["outputConnectTime"] = obs_output_get_connect_time_ms(output);
+	ret["outputDuration"] = (double)(duration / 1000000);
+	ret["averageBitrate"] = duration ? ((double)totalBytes * 8.0 / 1000.0) / ((double)duration / 1000000000.0) : 0.0;
+
+	ret["startCount"] = (double)destination->StartCount;
+	if (destination->StoppedAt) {
+		ret["lastStopTimestamp"] = (double)(destination->StoppedAt / 1000000);
+		ret["lastStopReason"] = StreamSupervisor::StopCodeName(destination->LastStopCode);
+		if (!destination->LastError.isEmpty())
+			ret["lastError"] = destination->LastError;
+	}
+	return ret;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <obs.hpp>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include "../rpc/Request.h"
+#include "../plugin-main.h"
+
+struct SimulcastOutputSettings {
+	// `rtmp://`, `rtmps://` or `srt://` URL of the destination
+	QString ServerUrl;
+	QString StreamKey;
+	// Reconnect attempts after the connection dropped. 0 disables reconnecting.
+	int MaxRetries = 20;
+	// Seconds between two reconnect attempts
+	int RetryDelay = 2;
+};
+
+// Additional streaming destinations that are fed by the encoders of the frontend streaming output. libobs lets any
+// number of outputs share one encoder, so each destination only costs its connection and no extra encode. The
+// encoders are looked up on every start since the frontend recreates them whenever its output settings change.
+class SimulcastOutputs {
+	public:
+		SimulcastOutputs();
+		~SimulcastOutputs();
+
+		RequestStatus CreateOutput(const QString &outputName, const SimulcastOutputSettings &settings, QString &comment);
+		RequestStatus RemoveOutput(const QString &outputName);
+		RequestStatus StartOutput(const QString &outputName, QString &comment);
+		RequestStatus StopOutput(const QString &outputName);
+
+		// Settings and statistics of every destination, or only of `outputName` if not empty
+		QJsonArray GetOutputs(const QString &outputName = QString());
+
+		QJsonObject GetStats();
+
+	private:
+		struct Destination;
+
+		static void StartCallback(void *param, calldata_t *);
+		static void StopCallback(void *param, calldata_t *data);
+		static QString OutputType(const QString &serverUrl);
+		QJsonObject _GetDestinationJson(Destination *destination, uint64_t now);
+
+		QMutex _mutex;
+		std::map<QString, std::unique_ptr<Destination>> _destinations;
+
+		std::atomic<uint64_t> _starts;
+		std::atomic<uint64_t> _failedStarts;
+};
+
+typedef std::shared_ptr<SimulcastOutputs> SimulcastOutputsPtr;
@@ -10,6 +10,20 @@
 #include "Config.h"
 #include "WebsocketManager.h"
 #include "RequestHandler.h"
+#include "media/ThumbnailStream.h"
+#include "media/AudioMeters.h"
+#include "media/FilterSettingsCoalescer.h"
+#include "stats/IngestHealthSampler.h"
+#include "stats/OutputStatsSampler.h"
+#include "stats/StreamSupervisor.h"
+#include "stats/SceneSwitchTracker.h"
+#include "outputs/SimulcastOutputs.h"
+#include "outputs/ReplayBuffer.h"
+#include "FileTransfers.h"
+#include "ResponseCache.h"
+#include "automation/AutoSceneSwitcher.h"
+#include "automation/IngestWatchdog.h"
+#include "automation/BitrateController.h"
 #include "forms/settings-dialog.h"
 
 #include "plugin-main.h"
@@ -19,6 +33,7 @@ void ___sceneitem_dummy_addref(obs_sceneitem_t*) {}
 void ___data_dummy_addref(obs_data_t*) {}
 void ___data_array_dummy_addref(obs_data_array_t*) {}
 void ___output_dummy_addref(obs_output_t*) {}
+void ___service_dummy_addref(obs_service_t*) {}
 
 void ___data_item_dummy_addref(obs_data_item_t*) {}
 void ___data_item_release(obs_data_item_t* dataItem) {
@@ -32,13 +47,59 @@ ConfigPtr _config;
 
 WebsocketManagerPtr _websocketManager;
 
+ThumbnailStreamPtr _thumbnailStream;
+
+AudioMetersPtr _audioMeters;
+
+FilterSettingsCoalescerPtr _filterSettingsCoalescer;
+
+IngestHealthSamplerPtr _ingestHealthSampler;
+
+OutputStatsSamplerPtr _outputStatsSampler;
+
+StreamSupervisorPtr _streamSupervisor;
+
+SimulcastOutputsPtr _simulcastOutputs;
+
+SceneSwitchTrackerPtr _sceneSwitchTracker;
+
+ReplayBufferPtr _replayBuffer;
+
+FileTransfersPtr _fileTransfers;
+
+ResponseCachePtr _responseCache;
+
+AutoSceneSwitcherPtr _autoSceneSwitcher;
+
+IngestWatchdogPtr _ingestWatchdog;
+
+BitrateControllerPtr _bitrateController;
+
 bool obs_module_load(void)
 {
 	_config = ConfigPtr(new Config());
 	_config->Load();
 
 	_websocketManager = WebsocketManagerPtr(new WebsocketManager());
-	_websocketManager->SessionKey = _config->SessionKey;
+	_websocketManager->SetSessionKeys(_config->SessionKey, _config->AdditionalSessionKeys);
+	_websocketManager->GetWorkerPool()->Configure(_config->GetWorkerPoolSettings());
+
+	_thumbnailStream = ThumbnailStreamPtr(new ThumbnailStream());
+	_audioMeters = AudioMetersPtr(new AudioMeters());
+	_filterSettingsCoalescer = FilterSettingsCoalescerPtr(new FilterSettingsCoalescer());
+	// Must exist before the ingest health sampler thread starts feeding it
+	_autoSceneSwitcher = AutoSceneSwitcherPtr(new AutoSceneSwitcher());
+	_ingestHealthSampler = IngestHealthSamplerPtr(new IngestHealthSampler());
+	_ingestWatchdog = IngestWatchdogPtr(new IngestWatchdog());
+	// Must exist before the output stats sampler thread starts feeding it
+	_bitrateController = BitrateControllerPtr(new BitrateController());
+	_responseCache = ResponseCachePtr(new ResponseCache());
+	_outputStatsSampler = OutputStatsSamplerPtr(new OutputStatsSampler());
+	_streamSupervisor = StreamSupervisorPtr(new StreamSupervisor());
+	_simulcastOutputs = SimulcastOutputsPtr(new SimulcastOutputs());
+	_sceneSwitchTracker = SceneSwitchTrackerPtr(new SceneSwitchTracker());
+	_replayBuffer = ReplayBufferPtr(new ReplayBuffer());
+	_fileTransfers = FileTransfersPtr(new FileTransfers());
 
 	obs_frontend_push_ui_translation(obs_module_get_string);
 	QMainWindow* mainWindow = (QMainWindow*)obs_frontend_get_main_window();
@@ -76,8 +137,26 @@ bool obs_module_load(void)
 
 void obs_module_unload()
 {
+	// The socket thread keeps handing requests to the pool until the socket is closed, and those requests use the
+	// components below. So the socket is closed first, then the pool is drained, and only then are the components
+	// released. Their own threads are stopped by their destructors, samplers before the automation they feed.
+	QMetaObject::invokeMethod(_websocketManager.get(), "Disconnect", Qt::BlockingQueuedConnection);
 	_websocketManager->GetThreadPool()->waitForDone();
-	QMetaObject::invokeMethod(_websocketManager.get(), "Disconnect");
+	_fileTransfers.reset();
+	_replayBuffer.reset();
+	_sceneSwitchTracker.reset();
+	_simulcastOutputs.reset();
+	_streamSupervisor.reset();
+	_outputStatsSampler.reset();
+	// Refreshed from the output stats sampler thread
+	_responseCache.reset();
+	_bitrateController.reset();
+	_ingestWatchdog.reset();
+	_ingestHealthSampler.reset();
+	_autoSceneSwitcher.reset();
+	_filterSettingsCoalescer.reset();
+	_audioMeters.reset();
+	_thumbnailStream.reset();
 	_websocketManager.reset();
 	_config.reset();
 	blog(LOG_INFO, "Finished unloading.");
@@ -89,4 +168,60 @@ ConfigPtr GetConfig() {
 
 WebsocketManagerPtr GetWebsocketManager() {
 	return _websocketManager;
+}
+
+ThumbnailStreamPtr GetThumbnailStream() {
+	return _thumbnailStream;
+}
+
+AudioMetersPtr GetAudioMeters() {
+	return _audioMeters;
+}
+
+FilterSettingsCoalescerPtr GetFilterSettingsCoalescer() {
+	return _filterSettingsCoalescer;
+}
+
+IngestHealthSamplerPtr GetIngestHealthSampler() {
+	return _ingestHealthSampler;
+}
+
+OutputStatsSamplerPtr GetOutputStatsSampler() {
+	return _outputStatsSampler;
+}
+
+StreamSupervisorPtr GetStreamSupervisor() {
+	return _streamSupervisor;
+}
+
+SimulcastOutputsPtr GetSimulcastOutputs() {
+	return _simulcastOutputs;
+}
+
+SceneSwitchTrackerPtr GetSceneSwitchTracker() {
+	return _sceneSwitchTracker;
+}
+
+ReplayBufferPtr GetReplayBuffer() {
+	return _replayBuffer;
+}
+
+FileTransfersPtr GetFileTransfers() {
+	return _fileTransfers;
+}
+
+ResponseCachePtr GetResponseCache() {
+	return _responseCache;
+}
+
+AutoSceneSwitcherPtr GetAutoSceneSwitcher() {
+	return _autoSceneSwitcher;
+}
+
+IngestWatchdogPtr GetIngestWatchdog() {
+	return _ingestWatchdog;
+}
+
+BitrateControllerPtr GetBitrateController() {
+	return _bitrateController;
 }
\ No newline at end of file
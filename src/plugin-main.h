@@ -1,40 +1,113 @@
-#include <obs.hpp>
-#include <memory>
-#include <QJsonDocument>
-#include "plugin-macros.generated.h"
-
-#define DEBUG_MODE
-
-#define QT_TO_UTF8(str) str.toUtf8().constData()
-
-void ___source_dummy_addref(obs_source_t*);
-void ___sceneitem_dummy_addref(obs_sceneitem_t*);
-void ___data_dummy_addref(obs_data_t*);
-void ___data_array_dummy_addref(obs_data_array_t*);
-void ___output_dummy_addref(obs_output_t*);
-
-using OBSSourceAutoRelease =
-	OBSRef<obs_source_t*, ___source_dummy_addref, obs_source_release>;
-using OBSSceneItemAutoRelease =
-	OBSRef<obs_sceneitem_t*, ___sceneitem_dummy_addref, obs_sceneitem_release>;
-using OBSDataAutoRelease =
-	OBSRef<obs_data_t*, ___data_dummy_addref, obs_data_release>;
-using OBSDataArrayAutoRelease =
-	OBSRef<obs_data_array_t*, ___data_array_dummy_addref, obs_data_array_release>;
-using OBSOutputAutoRelease =
-	OBSRef<obs_output_t*, ___output_dummy_addref, obs_output_release>;
-
-void ___data_item_dummy_addref(obs_data_item_t*);
-void ___data_item_release(obs_data_item_t*);
-using OBSDataItemAutoRelease =
-	OBSRef<obs_data_item_t*, ___data_item_dummy_addref, ___data_item_release>;
-
-class Config;
-typedef std::shared_ptr<Config> ConfigPtr;
-
-class WebsocketManager;
-typedef std::shared_ptr<WebsocketManager> WebsocketManagerPtr;
-
-ConfigPtr GetConfig();
-
-WebsocketManagerPtr GetWebsocketManager();
\ No newline at end of file
+#include <obs.hpp>
+#include <memory>
+#include <QJsonDocument>
+#include "plugin-macros.generated.h"
+
+#define DEBUG_MODE
+
+#define QT_TO_UTF8(str) str.toUtf8().constData()
+
+void ___source_dummy_addref(obs_source_t*);
+void ___sceneitem_dummy_addref(obs_sceneitem_t*);
+void ___data_dummy_addref(obs_data_t*);
+void ___data_array_dummy_addref(obs_data_array_t*);
+void ___output_dummy_addref(obs_output_t*);
+void ___service_dummy_addref(obs_service_t*);
+
+using OBSSourceAutoRelease =
+	OBSRef<obs_source_t*, ___source_dummy_addref, obs_source_release>;
+using OBSSceneItemAutoRelease =
+	OBSRef<obs_sceneitem_t*, ___sceneitem_dummy_addref, obs_sceneitem_release>;
+using OBSDataAutoRelease =
+	OBSRef<obs_data_t*, ___data_dummy_addref, obs_data_release>;
+using OBSDataArrayAutoRelease =
+	OBSRef<obs_data_array_t*, ___data_array_dummy_addref, obs_data_array_release>;
+using OBSOutputAutoRelease =
+	OBSRef<obs_output_t*, ___output_dummy_addref, obs_output_release>;
+using OBSServiceAutoRelease =
+	OBSRef<obs_service_t*, ___service_dummy_addref, obs_service_release>;
+
+void ___data_item_dummy_addref(obs_data_item_t*);
+void ___data_item_release(obs_data_item_t*);
+using OBSDataItemAutoRelease =
+	OBSRef<obs_data_item_t*, ___data_item_dummy_addref, ___data_item_release>;
+
+class Config;
+typedef std::shared_ptr<Config> ConfigPtr;
+
+class WebsocketManager;
+typedef std::shared_ptr<WebsocketManager> WebsocketManagerPtr;
+
+class ThumbnailStream;
+typedef std::shared_ptr<ThumbnailStream> ThumbnailStreamPtr;
+
+class AudioMeters;
+typedef std::shared_ptr<AudioMeters> AudioMetersPtr;
+
+class FilterSettingsCoalescer;
+typedef std::shared_ptr<FilterSettingsCoalescer> FilterSettingsCoalescerPtr;
+
+class IngestHealthSampler;
+typedef std::shared_ptr<IngestHealthSampler> IngestHealthSamplerPtr;
+
+class OutputStatsSampler;
+typedef std::shared_ptr<OutputStatsSampler> OutputStatsSamplerPtr;
+
+class StreamSupervisor;
+typedef std::shared_ptr<StreamSupervisor> StreamSupervisorPtr;
+
+class SimulcastOutputs;
+typedef std::shared_ptr<SimulcastOutputs> SimulcastOutputsPtr;
+
+class SceneSwitchTracker;
+typedef std::shared_ptr<SceneSwitchTracker> SceneSwitchTrackerPtr;
+
+class ReplayBuffer;
+typedef std::shared_ptr<ReplayBuffer> ReplayBufferPtr;
+
+class FileTransfers;
+typedef std::shared_ptr<FileTransfers> FileTransfersPtr;
+
+class ResponseCache;
+typedef std::shared_ptr<ResponseCache> ResponseCachePtr;
+
+class AutoSceneSwitcher;
+typedef std::shared_ptr<AutoSceneSwitcher> AutoSceneSwitcherPtr;
+
+class IngestWatchdog;
+typedef std::shared_ptr<IngestWatchdog> IngestWatchdogPtr;
+
+class BitrateController;
+typedef std::shared_ptr<BitrateController> BitrateControllerPtr;
+
+ConfigPtr GetConfig();
+
+WebsocketManagerPtr GetWebsocketManager();
+
+ThumbnailStreamPtr GetThumbnailStream();
+
+AudioMetersPtr GetAudioMeters();
+
+FilterSettingsCoalescerPtr GetFilterSettingsCoalescer();
+
+IngestHealthSamplerPtr GetIngestHealthSampler();
+
+OutputStatsSamplerPtr GetOutputStatsSampler();
+
+StreamSupervisorPtr GetStreamSupervisor();
+
+SimulcastOutputsPtr GetSimulcastOutputs();
+
+SceneSwitchTrackerPtr GetSceneSwitchTracker();
+
+ReplayBufferPtr GetReplayBuffer();
+
+FileTransfersPtr GetFileTransfers();
+
+ResponseCachePtr GetResponseCache();
+
+AutoSceneSwitcherPtr GetAutoSceneSwitcher();
+
+IngestWatchdogPtr GetIngestWatchdog();
+
+BitrateControllerPtr GetBitrateController();
\ No newline at end of file
@@ -1,112 +1,162 @@
-#include "Request.h"
-
-Request::Request(const QString& requestType, const QString& requestId, QJsonObject requestData) :
-	_requestType(requestType),
-	_requestId(requestId)
-{
-	if (!requestData.empty())
-		_requestData.swap(requestData);
-}
-
-const RequestStatus Request::ValidateBasic(const QString keyName, QString *comment) const
-{
-	if (!HasRequestData()) {
-		if (comment)
-			*comment = "Parameter: requestData";
-		return RequestStatus::MissingRequestParameter;
-	}
-
-	if (!_requestData.contains(keyName)) {
-		if (comment)
-			*comment = QString("Parameter: %1").arg(keyName);
-		return RequestStatus::MissingRequestParameter;
-	}
-
-	return RequestStatus::NoError;
-}
-
-const RequestStatus Request::ValidateDouble(const QString keyName, QString *comment, double minValue, double maxValue) const
-{
-	RequestStatus basicValidation = ValidateBasic(keyName, comment);
-	if (basicValidation != RequestStatus::NoError)
-		return basicValidation;
-
-	if (!_requestData[keyName].isDouble()) {
-		if (comment)
-			*comment = QString("Parameter: %1\nRequired: double").arg(keyName);
-		return RequestStatus::InvalidRequestParameterDataType;
-	}
-
-	double value = _requestData[keyName].toDouble();
-	if (value < minValue) {
-		if (comment)
-			*comment = QString("Parameter: %1\nMinimum: %2").arg(keyName).arg(minValue);
-		return RequestStatus::RequestParameterOutOfRange;
-	} else if (value > maxValue) {
-		if (comment)
-			*comment = QString("Parameter: %1\nMaximum: %2").arg(keyName).arg(maxValue);
-		return RequestStatus::RequestParameterOutOfRange;
-	}
-
-	return RequestStatus::NoError;
-}
-
-const RequestStatus Request::ValidateString(const QString keyName, QString *comment) const
-{
-	RequestStatus basicValidation = ValidateBasic(keyName, comment);
-	if (basicValidation != RequestStatus::NoError)
-		return basicValidation;
-
-	if (!_requestData[keyName].isString()) {
-		if (comment)
-			*comment = QString("Parameter: %1\nRequired: string").arg(keyName);
-		return RequestStatus::InvalidRequestParameterDataType;
-	}
-
-	return RequestStatus::NoError;
-}
-
-const RequestStatus Request::ValidateBool(const QString keyName, QString *comment) const
-{
-	RequestStatus basicValidation = ValidateBasic(keyName, comment);
-	if (basicValidation != RequestStatus::NoError)
-		return basicValidation;
-
-	if (!_requestData[keyName].isBool()) {
-		if (comment)
-			*comment = QString("Parameter: %1\nRequired: bool").arg(keyName);
-		return RequestStatus::InvalidRequestParameterDataType;
-	}
-
-	return RequestStatus::NoError;
-}
-
-const RequestStatus Request::ValidateObject(const QString keyName, QString *comment) const
-{
-	RequestStatus basicValidation = ValidateBasic(keyName, comment);
-	if (basicValidation != RequestStatus::NoError)
-		return basicValidation;
-
-	if (!_requestData[keyName].isObject()) {
-		if (comment)
-			*comment = QString("Parameter: %1\nRequired: object").arg(keyName);
-		return RequestStatus::InvalidRequestParameterDataType;
-	}
-
-	return RequestStatus::NoError;
-}
-
-const RequestStatus Request::ValidateArray(const QString keyName, QString *comment) const
-{
-	RequestStatus basicValidation = ValidateBasic(keyName, comment);
-	if (basicValidation != RequestStatus::NoError)
-		return basicValidation;
-
-	if (!_requestData[keyName].isArray()) {
-		if (comment)
-			*comment = QString("Parameter: %1\nRequired: array").arg(keyName);
-		return RequestStatus::InvalidRequestParameterDataType;
-	}
-
-	return RequestStatus::NoError;
+#include <util/platform.h>
+
+#include "Request.h"
+
+Request::Request(const QString& requestType, const QString& requestId, QJsonObject requestData, uint64_t receivedAt, uint16_t channelId) :
+	_requestType(requestType),
+	_requestId(requestId),
+	_receivedAt(receivedAt ? receivedAt : os_gettime_ns()),
+	_channelId(channelId),
+	_hasFieldMask(false)
+{
+	if (!requestData.empty())
+		_requestData.swap(requestData);
+
+	// Malformed masks are reported by `ValidateFieldMask()`
+	QJsonValue fieldMask = _requestData.value("fieldMask");
+	if (fieldMask.isArray()) {
+		_hasFieldMask = true;
+		for (auto field : fieldMask.toArray())
+			_fieldMask.append(field.toString());
+	}
+}
+
+const RequestStatus Request::ValidateBasic(const QString keyName, QString *comment) const
+{
+	if (!HasRequestData()) {
+		if (comment)
+			*comment = "Parameter: requestData";
+		return RequestStatus::MissingRequestParameter;
+	}
+
+	if (!_requestData.contains(keyName)) {
+		if (comment)
+			*comment = QString("Parameter: %1").arg(keyName);
+		return RequestStatus::MissingRequestParameter;
+	}
+
+	return RequestStatus::NoError;
+}
+
+const RequestStatus Request::ValidateDouble(const QString keyName, QString *comment, double minValue, double maxValue) const
+{
+	RequestStatus basicValidation = ValidateBasic(keyName, comment);
+	if (basicValidation != RequestStatus::NoError)
+		return basicValidation;
+
+	if (!_requestData[keyName].isDouble()) {
+		if (comment)
+			*comment = QString("Parameter: %1\nRequired: double").arg(keyName);
+		return RequestStatus::InvalidRequestParameterDataType;
+	}
+
+	double value = _requestData[keyName].toDouble();
+	if (value < minValue) {
+		if (comment)
+			*comment = QString("Parameter: %1\nMinimum: %2").arg(keyName).arg(minValue);
+		return RequestStatus::RequestParameterOutOfRange;
+	} else if (value > maxValue) {
+		if (comment)
+			*comment = QString("Parameter: %1\nMaximum: %2").arg(keyName).arg(maxValue);
+		return RequestStatus::RequestParameterOutOfRange;
+	}
+
+	return RequestStatus::NoError;
+}
+
+const RequestStatus Request::ValidateString(const QString keyName, QString *comment) const
+{
+	RequestStatus basicValidation = ValidateBasic(keyName, comment);
+	if (basicValidation != RequestStatus::NoError)
+		return basicValidation;
+
+	if (!_requestData[keyName].isString()) {
+		if (comment)
+			*comment = QString("Parameter: %1\nRequired: string").arg(keyName);
+		return RequestStatus::InvalidRequestParameterDataType;
+	}
+
+	return RequestStatus::NoError;
+}
+
+const RequestStatus Request::ValidateBool(const QString keyName, QString *comment) const
+{
+	RequestStatus basicValidation = ValidateBasic(keyName, comment);
+	if (basicValidation != RequestStatus::NoError)
+		return basicValidation;
+
+	if (!_requestData[keyName].isBool()) {
+		if (comment)
+			*comment = QString("Parameter: %1\nRequired: bool").arg(keyName);
+		return RequestStatus::InvalidRequestParameterDataType;
+	}
+
+	return RequestStatus::NoError;
+}
+
+const RequestStatus Request::ValidateObject(const QString keyName, QString *comment) const
+{
+	RequestStatus basicValidation = ValidateBasic(keyName, comment);
+	if (basicValidation != RequestStatus::NoError)
+		return basicValidation;
+
+	if (!_requestData[keyName].isObject()) {
+		if (comment)
+			*comment = QString("Parameter: %1\nRequired: object").arg(keyName);
+		return RequestStatus::InvalidRequestParameterDataType;
+	}
+
+	return RequestStatus::NoError;
+}
+
+const RequestStatus Request::ValidateArray(const QString keyName, QString *comment) const
+{
+	RequestStatus basicValidation = ValidateBasic(keyName, comment);
+	if (basicValidation != RequestStatus::NoError)
+		return basicValidation;
+
+	if (!_requestData[keyName].isArray()) {
+		if (comment)
+			*comment = QString("Parameter: %1\nRequired: array").arg(keyName);
+		return RequestStatus::InvalidRequestParameterDataType;
+	}
+
+	return RequestStatus::NoError;
+}
+
+const RequestStatus Request::ValidateFieldMask(QString *comment) const
+{
+	RequestStatus checkStatus = ValidateArray("fieldMask", comment);
+	if (checkStatus == RequestStatus::MissingRequestParameter)
+		return RequestStatus::NoError;
+	else if (checkStatus != RequestStatus::NoError)
+		return checkStatus;
+
+	for (auto field : _requestData["fieldMask"].toArray()) {
+		if (!field.isString() || field.toString().isEmpty()) {
+			if (comment)
+				*comment = "Parameter: fieldMask\nEvery field must be a non-empty string.";
+			return RequestStatus::InvalidRequestParameter;
+		}
+	}
+
+	return RequestStatus::NoError;
+}
+
+bool Request::WantsField(const QString &fieldPath, bool byDefault) const
+{
+	if (!_hasFieldMask)
+		return byDefault;
+
+	for (auto &field : _fieldMask) {
+		if (field == fieldPath)
+			return true;
+		// A parent selects all of its children, and a child needs its parents to be computed
+		if (fieldPath.startsWith(field) && fieldPath[field.size()] == '.')
+			return true;
+		if (field.startsWith(fieldPath) && field[fieldPath.size()] == '.')
+			return true;
+	}
+
+	return false;
 }
\ No newline at end of file
@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <util/platform.h>
+
+#include "IngestHealthSampler.h"
+#include "../automation/AutoSceneSwitcher.h"
+
+// Keys filled by `obs_source_media_irltk_get_stats()`
+#define STATS_READ_BYTES "read_bytes"
+#define STATS_LOST_PICTURES "lost_pictures"
+
+struct IngestHealthSampler::Ingest {
+	RingBuffer<IngestSample, HistorySize> Samples;
+
+	// Rolling window over the newest `WindowCount` bitrates
+	size_t WindowCount = 0;
+	double WindowSum = 0.0;
+	double WindowSumSquares = 0.0;
+
+	uint64_t StallStartedAt = 0;
+	uint64_t StallCount = 0;
+	uint64_t TotalStallDuration = 0;
+	uint64_t LongestStallDuration = 0;
+	bool StatsAvailable = false;
+};
+
+struct IngestHealthSampler::IngestReading {
+	QString SourceName;
+	enum obs_media_state MediaState = OBS_MEDIA_STATE_NONE;
+	bool StatsAvailable = false;
+	uint64_t ReadBytes = 0;
+	uint64_t LostPictures = 0;
+};
+
+const char *IngestHealthSampler::MediaStateName(uint8_t mediaState)
+{
+	switch (mediaState) {
+		case OBS_MEDIA_STATE_NONE:
+			return "none";
+		case OBS_MEDIA_STATE_PLAYING:
+			return "playing";
+		case OBS_MEDIA_STATE_OPENING:
+			return "opening";
+		case OBS_MEDIA_STATE_BUFFERING:
+			return "buffering";
+		case OBS_MEDIA_STATE_PAUSED:
+			return "paused";
+		case OBS_MEDIA_STATE_STOPPED:
+			return "stopped";
+		case OBS_MEDIA_STATE_ENDED:
+			return "ended";
+		case OBS_MEDIA_STATE_ERROR:
+			return "error";
+		default:
+			return "unknown";
+	}
+}
+
+IngestHealthSampler::IngestHealthSampler() :
+	_running(true),
+	_samplePasses(0),
+	_sampleTime(0)
+{
+	_samplerThread = std::thread(&IngestHealthSampler::_SampleLoop, this);
+}
+
+IngestHealthSampler::~IngestHealthSampler()
+{
+	{
+		QMutexLocker locker(&_mutex);
+		_running = false;
+		_condition.wakeAll();
+	}
+	_samplerThread.join();
+}
+
+void IngestHealthSampler::SetSettings(const IngestHealthSettings &settings)
+{
+	QMutexLocker locker(&_mutex);
+	_settings = settings;
+	if (!_settings.Enabled)
+		_ingests.clear();
+	_condition.wakeAll();
+}
+
+IngestHealthSettings IngestHealthSampler::GetSettings()
+{
+	QMutexLocker locker(&_mutex);
+	return _settings;
+}
+
+QJsonArray IngestHealthSampler::GetIngestHealth(const QString &sourceName, size_t sampleCount)
+{
+	QMutexLocker locker(&_mutex);
+	uint64_t now = os_gettime_ns();
+
+	QJsonArray ret;
+	for (auto &ingest : _ingests) {
+		if (!sourceName.isEmpty() && ingest.first != sourceName)
+			continue;
+		ret.append(_GetIngestHealth(ingest.first, ingest.second.get(), sampleCount, now));
+	}
+	return ret;
+}
+
+bool IngestHealthSampler::GetSnapshot(const QString &sourceName, IngestHealthSnapshot &snapshot)
+{
+	QMutexLocker locker(&_mutex);
+	auto it = _ingests.find(sourceName);
+	if (it == _ingests.end())
+		return false;
+
+	snapshot = _GetSnapshot(it->first, it->second.get(), os_gettime_ns());
+	return true;
+}
+
+QJsonObject IngestHealthSampler::GetStats()
+{
+	QMutexLocker locker(&_mutex);
+
+	QJsonObject ret;
+	ret["sampledIngests"] = (double)_ingests.size();
+	ret["samplePasses"] = (double)_samplePasses;
+	ret["averageSampleTime"] = _samplePasses ? ((double)_sampleTime / _samplePasses) / 1000000.0 : 0.0;
+	return ret;
+}
+
+void IngestHealthSampler::_SampleLoop()
+{
+	QMutexLocker locker(&_mutex);
+	while (_running) {
+		_condition.wait(&_mutex, (unsigned long)std::max(1, _settings.Interval));
+		if (!_running)
+			break;
+		if (!_settings.Enabled)
+			continue;
+
+		// Stats are read without holding the lock so that queries never wait on libobs
+		locker.unlock();
+		_Sample();
+		locker.relock();
+	}
+}
+
+void IngestHealthSampler::_Sample()
+{
+	uint64_t startedAt = os_gettime_ns();
+
+	auto enumCallback = [](void *param, obs_source_t *source) {
+		auto sources = static_cast<std::vector<OBSSource>*>(param);
+		if (strcmp(obs_source_get_id(source), "vlc_source") == 0)
+			sources->push_back(source);
+		return true;
+	};
+	std::vector<OBSSource> sources;
+	obs_enum_sources(enumCallback, &sources);
+
+	std::vector<IngestReading> readings;
+	readings.reserve(sources.size());
+	for (auto &source : sources) {
+		IngestReading reading;
+		reading.SourceName = obs_source_get_name(source);
+		reading.MediaState = obs_source_media_get_state(source);
+#ifdef IRLTK_CLOUD
+		OBSDataAutoRelease statsData = obs_data_create();
+		obs_source_media_irltk_get_stats(source, statsData);
+		reading.StatsAvailable = true;
+		reading.ReadBytes = (uint64_t)obs_data_get_int(statsData, STATS_READ_BYTES);
+		reading.LostPictures = (uint64_t)obs_data_get_int(statsData, STATS_LOST_PICTURES);
+#endif
+		readings.push_back(reading);
+	}
+
+	QMutexLocker locker(&_mutex);
+	if (!_settings.Enabled)
+		return;
+
+	uint64_t now = os_gettime_ns();
+	std::map<QString, std::unique_ptr<Ingest>> ingests;
+	for (auto &reading : readings) {
+		auto it = _ingests.find(reading.SourceName);
+		std::unique_ptr<Ingest> ingest;
+		if (it != _ingests.end())
+			ingest = std::move(it->second);
+		else
+			ingest = std::unique_ptr<Ingest>(new Ingest());
+
+		_ApplyReading(ingest.get(), reading, now);
+		ingests[reading.SourceName] = std::move(ingest);
+	}
+	// Ingests which no longer exist (or were renamed) are dropped along with their history
+	_ingests = std::move(ingests);
+
+	std::vector<IngestHealthSnapshot> snapshots;
+	snapshots.reserve(_ingests.size());
+	for (auto &ingest : _ingests)
+		snapshots.push_back(_GetSnapshot(ingest.first, ingest.second.get(), now));
+
+	_samplePasses++;
+	_sampleTime += os_gettime_ns() - startedAt;
+	locker.unlock();
+
+	// Rules are evaluated on every sample, so the sample interval bounds the switching latency
+	auto autoSceneSwitcher = GetAutoSceneSwitcher();
+	if (autoSceneSwitcher)
+		autoSceneSwitcher->ProcessIngestHealth(snapshots, now);
+}
+
+void IngestHealthSampler::_ApplyReading(Ingest *ingest, const IngestReading &reading, uint64_t now)
+{
+	IngestSample sample;
+	sample.Timestamp = now;
+	sample.ReadBytes = reading.ReadBytes;
+	sample.LostPictures = reading.LostPictures;
+	sample.MediaState = (uint8_t)reading.MediaState;
+
+	bool hasPrevious = ingest->Samples.Written() > 0;
+	bool progressing = true;
+	if (hasPrevious && reading.StatsAvailable) {
+		const IngestSample &previous = ingest->Samples.Peek(0);
+		// The byte counter restarts whenever the media is reopened
+		if (sample.ReadBytes >= previous.ReadBytes && now > previous.Timestamp) {
+			double seconds = (double)(now - previous.Timestamp) / 1000000000.0;
+			sample.Bitrate = ((double)(sample.ReadBytes - previous.ReadBytes) * 8.0 / 1000.0) / seconds;
+		}
+		progressing = sample.ReadBytes != previous.ReadBytes;
+	}
+
+	switch (reading.MediaState) {
+		case OBS_MEDIA_STATE_PLAYING:
+			sample.Stalled = !progressing;
+			break;
+		case OBS_MEDIA_STATE_OPENING:
+		case OBS_MEDIA_STATE_BUFFERING:
+		case OBS_MEDIA_STATE_ENDED:
+		case OBS_MEDIA_STATE_ERROR:
+			sample.Stalled = true;
+			break;
+		default:
+			// Idle, paused or stopped on purpose
+			sample.Stalled = false;
+			break;
+	}
+
+	if (sample.Stalled && !ingest->StallStartedAt) {
+		ingest->StallStartedAt = now;
+		ingest->StallCount++;
+	} else if (!sample.Stalled && ingest->StallStartedAt) {
+		uint64_t stallDuration = now - ingest->StallStartedAt;
+		ingest->TotalStallDuration += stallDuration;
+		ingest->LongestStallDuration = std::max(ingest->LongestStallDuration, stallDuration);
+		ingest->StallStartedAt = 0;
+	}
+
+	ingest->StatsAvailable = reading.StatsAvailable;
+	ingest->Samples.Push(sample);
+
+	ingest->WindowSum += sample.Bitrate;
+	ingest->WindowSumSquares += sample.Bitrate * sample.Bitrate;
+	ingest->WindowCount++;
+	size_t windowSize = (size_t)std::max(1, _settings.WindowSize);
+	while (ingest->WindowCount > windowSize) {
+		double evicted = ingest->Samples.Peek(ingest->WindowCount - 1).Bitrate;
+		ingest->WindowSum -= evicted;
+		ingest->WindowSumSquares -= evicted * evicted;
+		ingest->WindowCount--;
+	}
+
+	// Rebuild the sums once per lap of the history so that floating point error cannot accumulate
+	if (ingest->Samples.Written() % HistorySize == 0) {
+		ingest->WindowSum = 0.0;
+		ingest->WindowSumSquares = 0.0;
+		for (size_t age = 0; age < ingest->WindowCount; age++) {
+			double bitrate = ingest->Samples.Peek(age).Bitrate;
+			ingest->WindowSum += bitrate;
+			ingest->WindowSumSquares += bitrate * bitrate;
+		}
+	}
+}
+
+QJsonObject IngestHealthSampler::_GetIngestHealth(const QString &sourceName, Ingest *ingest, size_t sampleCount, uint64_t now)
+{
+	QJsonObject ret;
+	ret["sourceName"] = sourceName;
+	ret["statsAvailable"] = ingest->StatsAvailable;
+	ret["sampleCount"] = (double)ingest->Samples.Size();
+
+	IngestSample latest;
+	if (ingest->Samples.Latest(latest)) {
+		ret["mediaState"] = MediaStateName(latest.MediaState);
+		ret["bitrate"] = latest.Bitrate;
+		ret["stalled"] = latest.Stalled;
+	}
+
+	size_t windowCount = ingest->WindowCount;
+	double averageBitrate = windowCount ? ingest->WindowSum / windowCount : 0.0;
+	double variance = windowCount ? (ingest->WindowSumSquares / windowCount) - (averageBitrate * averageBitrate) : 0.0;
+	ret["windowSize"] = (double)windowCount;
+	ret["averageBitrate"] = averageBitrate;
+	// Standard deviation of the per-sample bitrate over the window
+	ret["bitrateJitter"] = std::sqrt(std::max(0.0, variance));
+	if (windowCount) {
+		const IngestSample &oldest = ingest->Samples.Peek(windowCount - 1);
+		ret["lostPictures"] = (double)(latest.LostPictures >= oldest.LostPictures ? latest.LostPictures - oldest.LostPictures : latest.LostPictures);
+	}
+
+	uint64_t currentStallDuration = ingest->StallStartedAt ? now - ingest->StallStartedAt : 0;
+	ret["currentStallDuration"] = (double)(currentStallDuration / 1000000);
+	ret["stallCount"] = (double)ingest->StallCount;
+	ret["totalStallDuration"] = (double)((ingest->TotalStallDuration + currentStallDuration) / 1000000);
+	ret["longestStallDuration"] = (double)(std::max(ingest->LongestStallDuration, currentStallDuration) / 1000000);
+
+	if (sampleCount) {
+		QJsonArray samples;
+		for (auto &sample : ingest->Samples.Snapshot(sampleCount)) {
+			QJsonObject sampleJson;
+			sampleJson["timestamp"] = (double)(sample.Timestamp / 1000000);
+			sampleJson["mediaState"] = MediaStateName(sample.MediaState);
+			sampleJson["bitrate"] = sample.Bitrate;
+			sampleJson["lostPictures"] = (double)sample.LostPictures;
+			sampleJson["stalled"] = sample.Stalled;
+			samples.append(sampleJson);
+		}
+		ret["samples"] = samples;
+	}
+
+	return ret;
+}
+
+IngestHealthSnapshot IngestHealthSampler::_GetSnapshot(const QString &sourceName, Ingest *ingest, uint64_t now)
+{
+	IngestHealthSnapshot snapshot;
+	snapshot.SourceName = sourceName;
+	snapshot.Latest = ingest->Samples.Peek(0);
+	snapshot.AverageBitrate = ingest->WindowCount ? ingest->WindowSum / ingest->WindowCount : 0.0;
+	snapshot.StallDuration = ingest->StallStartedAt ? now - ingest->StallStartedAt : 0;
+	snapshot.StatsAvailable = ingest->StatsAvailable;
+	return snapshot;
+}
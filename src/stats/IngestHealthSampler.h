@@ -0,0 +1,89 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <thread>
+#include <obs.hpp>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QWaitCondition>
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include "RingBuffer.h"
+#include "../plugin-main.h"
+
+struct IngestHealthSettings {
+	bool Enabled = true;
+	// Milliseconds between two samples
+	int Interval = 1000;
+	// Number of samples covered by the rolling bitrate and jitter
+	int WindowSize = 10;
+};
+
+struct IngestSample {
+	uint64_t Timestamp = 0;
+	uint64_t ReadBytes = 0;
+	uint64_t LostPictures = 0;
+	// Kbps over the interval ending at `Timestamp`
+	double Bitrate = 0.0;
+	uint8_t MediaState = OBS_MEDIA_STATE_NONE;
+	bool Stalled = false;
+};
+
+// Latest state of one ingest, handed to the automation after every sample pass
+struct IngestHealthSnapshot {
+	QString SourceName;
+	IngestSample Latest;
+	double AverageBitrate = 0.0;
+	// Nanoseconds the current stall has lasted, 0 if not stalled
+	uint64_t StallDuration = 0;
+	bool StatsAvailable = false;
+};
+
+// Samples every `vlc_source` input on its own thread and keeps a fixed-size history per ingest. The rolling
+// bitrate, jitter and stall durations are updated incrementally as samples arrive, so a query only formats
+// the current values (and optionally copies the raw series).
+class IngestHealthSampler {
+	public:
+		static const size_t HistorySize = 1024;
+
+		IngestHealthSampler();
+		~IngestHealthSampler();
+
+		void SetSettings(const IngestHealthSettings &settings);
+		IngestHealthSettings GetSettings();
+
+		// An empty `sourceName` returns every ingest. `sampleCount` raw samples are included per ingest.
+		QJsonArray GetIngestHealth(const QString &sourceName, size_t sampleCount);
+
+		// Returns false if the source is not (yet) being sampled
+		bool GetSnapshot(const QString &sourceName, IngestHealthSnapshot &snapshot);
+
+		QJsonObject GetStats();
+
+		static const char *MediaStateName(uint8_t mediaState);
+
+	private:
+		struct Ingest;
+		struct IngestReading;
+
+		void _SampleLoop();
+		void _Sample();
+		void _ApplyReading(Ingest *ingest, const IngestReading &reading, uint64_t now);
+		IngestHealthSnapshot _GetSnapshot(const QString &sourceName, Ingest *ingest, uint64_t now);
+		QJsonObject _GetIngestHealth(const QString &sourceName, Ingest *ingest, size_t sampleCount, uint64_t now);
+
+		// Guards the settings, the ingest map and the per-ingest rolling state
+		QMutex _mutex;
+		QWaitCondition _condition;
+		IngestHealthSettings _settings;
+		std::map<QString, std::unique_ptr<Ingest>> _ingests;
+		bool _running;
+		std::thread _samplerThread;
+
+		uint64_t _samplePasses;
+		uint64_t _sampleTime;
+};
+
+typedef std::shared_ptr<IngestHealthSampler> IngestHealthSamplerPtr;
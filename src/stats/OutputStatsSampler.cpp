@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cstring>
+#include <obs-frontend-api.h>
+#include <util/platform.h>
+
+#include "OutputStatsSampler.h"
+#include "../WebsocketManager.h"
+#include "../automation/BitrateController.h"
+#include "../ResponseCache.h"
+
+OutputStatsSampler::OutputStatsSampler() :
+	_running(true),
+	_interval(_settings.Interval),
+	_window(_settings.Window),
+	_outputs{
+		{"stream", obs_frontend_get_streaming_output, {}},
+		{"record", obs_frontend_get_recording_output, {}},
+	},
+	_samplePasses(0),
+	_sampleTime(0)
+{
+	_samplerThread = std::thread(&OutputStatsSampler::_SampleLoop, this);
+}
+
+OutputStatsSampler::~OutputStatsSampler()
+{
+	{
+		QMutexLocker locker(&_settingsMutex);
+		_running = false;
+		_settingsCondition.wakeAll();
+	}
+	_samplerThread.join();
+}
+
+void OutputStatsSampler::SetSettings(const OutputStatsSettings &settings)
+{
+	QMutexLocker locker(&_settingsMutex);
+	_settings = settings;
+	_interval = settings.Interval;
+	_window = settings.Window;
+	_settingsCondition.wakeAll();
+}
+
+OutputStatsSettings OutputStatsSampler::GetSettings()
+{
+	QMutexLocker locker(&_settingsMutex);
+	return _settings;
+}
+
+QJsonObject OutputStatsSampler::GetOutputStats(const QString &outputName)
+{
+	for (auto &trackedOutput : _outputs) {
+		if (outputName == trackedOutput.Name)
+			return _GetOutputStats(trackedOutput);
+	}
+	return QJsonObject();
+}
+
+QJsonObject OutputStatsSampler::GetStats()
+{
+	uint64_t samplePasses = _samplePasses;
+
+	QJsonObject ret;
+	ret["samplePasses"] = (double)samplePasses;
+	ret["averageSampleTime"] = samplePasses ? ((double)_sampleTime / samplePasses) / 1000000.0 : 0.0;
+	return ret;
+}
+
+void OutputStatsSampler::_SampleLoop()
+{
+	QMutexLocker locker(&_settingsMutex);
+	while (_running) {
+		_settingsCondition.wait(&_settingsMutex, (unsigned long)std::max(1, _settings.Interval));
+		if (!_running)
+			break;
+
+		locker.unlock();
+		_Sample();
+		locker.relock();
+	}
+}
+
+void OutputStatsSampler::_Sample()
+{
+	uint64_t startedAt = os_gettime_ns();
+	auto websocketManager = GetWebsocketManager();
+
+	for (auto &trackedOutput : _outputs) {
+		OBSOutputAutoRelease output = trackedOutput.GetOutput();
+
+		OutputSample sample;
+		sample.Timestamp = os_gettime_ns();
+		sample.Active = output && obs_output_active(output);
+		if (output) {
+			sample.TotalBytes = obs_output_get_total_bytes(output);
+			sample.TotalFrames = (uint32_t)std::max(0, obs_output_get_total_frames(output));
+			sample.DroppedFrames = (uint32_t)std::max(0, obs_output_get_frames_dropped(output));
+			sample.Congestion = obs_output_get_congestion(output);
+			sample.ConnectTime = obs_output_get_connect_time_ms(output);
+			sample.Reconnecting = obs_output_reconnecting(output);
+		}
+
+		OutputSample previous;
+		if (trackedOutput.Samples.Written())
+			previous = trackedOutput.Samples.Peek(0);
+		bool wasActive = previous.Active;
+		trackedOutput.Samples.Push(sample);
+
+		if (output && strcmp(trackedOutput.Name, "stream") == 0) {
+			auto bitrateController = GetBitrateController();
+			if (bitrateController)
+				bitrateController->ProcessStreamSample(output, previous, sample);
+		}
+
+		// Push every active sample, plus the one where the output went inactive
+		if ((sample.Active || wasActive) && websocketManager && websocketManager->IsIdentified()) {
+			QJsonObject eventData = _GetOutputStats(trackedOutput);
+			eventData["outputName"] = trackedOutput.Name;
+			websocketManager->BroadcastEvent(EventSubscription::OutputStats, "OutputStats", eventData);
+		}
+	}
+
+	// The frontend has no event for changed video settings, so the response cache checks them on this tick
+	auto responseCache = GetResponseCache();
+	if (responseCache)
+		responseCache->RefreshVideoFingerprint();
+
+	_samplePasses++;
+	_sampleTime += os_gettime_ns() - startedAt;
+}
+
+QJsonObject OutputStatsSampler::_GetOutputStats(const TrackedOutput &trackedOutput)
+{
+	int interval = std::max(1, _interval.load());
+	int window = std::max(interval, _window.load());
+	std::vector<OutputSample> samples = trackedOutput.Samples.Snapshot((size_t)(window / interval) + 2);
+
+	QJsonObject ret;
+	if (samples.empty())
+		return ret;
+
+	const OutputSample &latest = samples.back();
+	ret["outputActive"] = latest.Active;
+	ret["outputReconnecting"] = latest.Reconnecting;
+	ret["outputBytes"] = (double)latest.TotalBytes;
+	ret["outputTotalFrames"] = (double)latest.TotalFrames;
+	ret["outputDroppedFrames"] = (double)latest.DroppedFrames;
+	ret["outputCongestion"] = latest.Congestion;
+	ret["outputConnectTime"] = latest.ConnectTime;
+	ret["sampleTimestamp"] = (double)(latest.Timestamp / 1000000);
+
+	// The window starts at the oldest sample that is within `window` of the newest one and belongs to the
+	// same output session (counters only reset when the output is restarted)
+	size_t first = samples.size() - 1;
+	while (first > 0) {
+		const OutputSample &candidate = samples[first - 1];
+		const OutputSample &next = samples[first];
+		if (!candidate.Active || latest.Timestamp - candidate.Timestamp > (uint64_t)window * 1000000)
+			break;
+		if (candidate.TotalBytes > next.TotalBytes || candidate.TotalFrames > next.TotalFrames)
+			break;
+		first--;
+	}
+
+	auto rates = [](const OutputSample &from, const OutputSample &to, double &bitrate, double &dropRate) {
+		bitrate = 0.0;
+		dropRate = 0.0;
+		if (to.Timestamp <= from.Timestamp)
+			return;
+		double seconds = (double)(to.Timestamp - from.Timestamp) / 1000000000.0;
+		bitrate = ((double)(to.TotalBytes - from.TotalBytes) * 8.0 / 1000.0) / seconds;
+		uint32_t frames = to.TotalFrames - from.TotalFrames;
+		uint32_t dropped = to.DroppedFrames >= from.DroppedFrames ? to.DroppedFrames - from.DroppedFrames : 0;
+		dropRate = frames ? (double)dropped / frames : 0.0;
+	};
+
+	double bitrate = 0.0, dropRate = 0.0;
+	if (latest.Active && first < samples.size() - 1)
+		rates(samples[samples.size() - 2], latest, bitrate, dropRate);
+	ret["bitrate"] = bitrate;
+	ret["dropRate"] = dropRate;
+
+	double windowBitrate = 0.0, windowDropRate = 0.0;
+	double congestionSum = 0.0;
+	float maxCongestion = 0.0f;
+	for (size_t i = first; i < samples.size(); i++) {
+		congestionSum += samples[i].Congestion;
+		maxCongestion = std::max(maxCongestion, samples[i].Congestion);
+	}
+	if (latest.Active)
+		rates(samples[first], latest, windowBitrate, windowDropRate);
+	ret["windowDuration"] = (double)((latest.Timestamp - samples[first].Timestamp) / 1000000);
+	ret["windowBitrate"] = windowBitrate;
+	ret["windowDropRate"] = windowDropRate;
+	ret["windowCongestion"] = latest.Active ? congestionSum / (samples.size() - first) : 0.0;
+	ret["windowMaxCongestion"] = latest.Active ? maxCongestion : 0.0f;
+
+	return ret;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <obs.hpp>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QWaitCondition>
+#include <QJsonObject>
+
+#include "RingBuffer.h"
+#include "../plugin-main.h"
+
+struct OutputStatsSettings {
+	// Milliseconds between two samples
+	int Interval = 1000;
+	// Milliseconds covered by the windowed rates
+	int Window = 10000;
+};
+
+struct OutputSample {
+	uint64_t Timestamp = 0;
+	uint64_t TotalBytes = 0;
+	uint32_t TotalFrames = 0;
+	uint32_t DroppedFrames = 0;
+	float Congestion = 0.0f;
+	int32_t ConnectTime = 0;
+	bool Active = false;
+	bool Reconnecting = false;
+};
+
+// Samples the frontend stream and record outputs on its own thread. The sampler thread is the only writer
+// of each output's ring, so `GetOutputStats()` reads the history and derives the rates without any locking.
+// Every sample of an active output is also pushed as an `OutputStats` event.
+class OutputStatsSampler {
+	public:
+		static const size_t HistorySize = 1024;
+
+		OutputStatsSampler();
+		~OutputStatsSampler();
+
+		void SetSettings(const OutputStatsSettings &settings);
+		OutputStatsSettings GetSettings();
+
+		// `outputName` is `stream` or `record`. Returns an empty object for unknown outputs.
+		QJsonObject GetOutputStats(const QString &outputName);
+
+		QJsonObject GetStats();
+
+	private:
+		struct TrackedOutput {
+			const char *Name;
+			obs_output_t *(*GetOutput)();
+			RingBuffer<OutputSample, HistorySize> Samples;
+		};
+
+		void _SampleLoop();
+		void _Sample();
+		QJsonObject _GetOutputStats(const TrackedOutput &trackedOutput);
+
+		QMutex _settingsMutex;
+		QWaitCondition _settingsCondition;
+		OutputStatsSettings _settings;
+		bool _running;
+		// Copies of the settings for the lock-free readers
+		std::atomic<int> _interval;
+		std::atomic<int> _window;
+
+		TrackedOutput _outputs[2];
+		std::thread _samplerThread;
+
+		std::atomic<uint64_t> _samplePasses;
+		std::atomic<uint64_t> _sampleTime;
+};
+
+typedef std::shared_ptr<OutputStatsSampler> OutputStatsSamplerPtr;
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Fixed-size single-writer ring of trivially copyable samples. The writer never blocks and never allocates.
+// Every slot is a seqlock: its sequence is odd while the writer fills it and `2 * (index + 1)` once sample
+// `index` is complete. Readers on any thread copy the newest entries without locking and drop any slot whose
+// sequence is not the expected one before and after the copy, so a snapshot only ever contains fully written
+// samples. The payload is kept in relaxed atomic words so that a copy racing a push is not a data race.
+template<typename T, size_t Capacity>
+class RingBuffer {
+	static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "RingBuffer capacity must be a power of two");
+	static_assert(std::is_trivially_copyable<T>::value, "RingBuffer samples must be trivially copyable");
+
+	public:
+		RingBuffer() :
+			_written(0)
+		{
+		}
+
+		// Writer thread only
+		void Push(const T &value)
+		{
+			uint64_t index = _written.load(std::memory_order_relaxed);
+			Slot &slot = _slots[index & (Capacity - 1)];
+
+			slot.Sequence.store(2 * index + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			uint64_t words[WordCount] = {};
+			memcpy(words, &value, sizeof(T));
+			for (size_t i = 0; i < WordCount; i++)
+				slot.Words[i].store(words[i], std::memory_order_relaxed);
+
+			slot.Sequence.store(2 * (index + 1), std::memory_order_release);
+			_written.store(index + 1, std::memory_order_release);
+		}
+
+		// Returns the sample pushed `age` pushes ago (0 is the newest). Only valid on the writer thread, or
+		// while the caller otherwise excludes concurrent pushes.
+		T Peek(size_t age) const
+		{
+			T ret;
+			_Load(_slots[(_written.load(std::memory_order_relaxed) - 1 - age) & (Capacity - 1)], ret);
+			return ret;
+		}
+
+		// Total number of samples ever pushed
+		uint64_t Written() const
+		{
+			return _written.load(std::memory_order_acquire);
+		}
+
+		size_t Size() const
+		{
+			uint64_t written = Written();
+			return written < Capacity ? (size_t)written : Capacity;
+		}
+
+		static constexpr size_t MaxSize()
+		{
+			return Capacity;
+		}
+
+		// Copies up to `maxCount` of the newest samples, oldest first
+		std::vector<T> Snapshot(size_t maxCount = Capacity) const
+		{
+			std::vector<T> ret;
+			uint64_t end = _written.load(std::memory_order_acquire);
+			uint64_t count = std::min<uint64_t>(std::min<uint64_t>(end, maxCount), Capacity);
+			uint64_t begin = end - count;
+
+			ret.reserve((size_t)count);
+			T value;
+			for (uint64_t i = begin; i < end; i++) {
+				// The writer lapped this slot before or during the copy
+				if (_Load(_slots[i & (Capacity - 1)], value) != 2 * (i + 1))
+					continue;
+				ret.push_back(value);
+			}
+
+			return ret;
+		}
+
+		// Copies the newest sample. Returns false if nothing was pushed yet.
+		bool Latest(T &value) const
+		{
+			std::vector<T> latest = Snapshot(1);
+			if (latest.empty())
+				return false;
+			value = latest.front();
+			return true;
+		}
+
+	private:
+		static constexpr size_t WordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+		struct Slot {
+			std::atomic<uint64_t> Sequence{0};
+			std::atomic<uint64_t> Words[WordCount] = {};
+		};
+
+		// Copies the slot into `value`. Returns the slot's sequence, or 1 (never a complete sample) if a push
+		// raced the copy.
+		static uint64_t _Load(const Slot &slot, T &value)
+		{
+			uint64_t sequence = slot.Sequence.load(std::memory_order_acquire);
+
+			uint64_t words[WordCount];
+			for (size_t i = 0; i < WordCount; i++)
+				words[i] = slot.Words[i].load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (sequence & 1 || slot.Sequence.load(std::memory_order_relaxed) != sequence)
+				return 1;
+
+			memcpy(&value, words, sizeof(T));
+			return sequence;
+		}
+
+		Slot _slots[Capacity];
+		std::atomic<uint64_t> _written;
+};
@@ -0,0 +1,415 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <util/platform.h>
+#include <QtCore/QDateTime>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QStringList>
+
+#include "SceneSwitchTracker.h"
+#include "../WebsocketManager.h"
+
+// Nanoseconds after which a dispatched switch that never led to a scene change is given up on. The frontend
+// does not report switches to the scene that is already on program.
+#define PENDING_SWITCH_TIMEOUT 5000000000ULL
+// Stinger media larger than this is left to the decoder
+#define PREFETCH_MAX_FILE_SIZE (256LL * 1024 * 1024)
+#define PREFETCH_CHUNK_SIZE (1024 * 1024)
+
+static double DurationMs(uint64_t from, uint64_t to)
+{
+	return (from && to >= from) ? (double)(to - from) / 1000000.0 : 0.0;
+}
+
+SceneSwitchTracker::SceneSwitchTracker() :
+	_nextId(0),
+	_overrideActive(false),
+	_overrideSwitchId(0),
+	_switchCount(0),
+	_requestedSwitches(0),
+	_overriddenSwitches(0),
+	_interruptedSwitches(0),
+	_lastSwitchLatency(0),
+	_maxSwitchLatency(0),
+	_prefetches(0),
+	_prefetchedBytes(0)
+{
+	obs_frontend_add_event_callback(SceneSwitchTracker::FrontendEventCallback, this);
+}
+
+SceneSwitchTracker::~SceneSwitchTracker()
+{
+	obs_frontend_remove_event_callback(SceneSwitchTracker::FrontendEventCallback, this);
+}
+
+uint64_t SceneSwitchTracker::SwitchScene(obs_source_t *scene, uint64_t requestedAt, obs_source_t *transition, int duration)
+{
+	// The frontend queues each of these calls to the UI thread, so holding the dispatch lock keeps the overrides and
+	// scene changes of concurrent switches in the order they were requested. The frontend blocks until the UI thread
+	// ran them, and the UI thread takes `_mutex` from the event callbacks, so `_mutex` is released before dispatching.
+	QMutexLocker dispatchLocker(&_dispatchMutex);
+
+	// The frontend emits no event for a switch to the scene already on program, so it is recorded as done right away.
+	// Its transition override is not applied, as nothing would ever restore it.
+	OBSSourceAutoRelease currentScene = obs_frontend_get_current_scene();
+	if (currentScene == scene) {
+		SceneSwitch sceneSwitch;
+		QMutexLocker locker(&_mutex);
+		uint64_t now = os_gettime_ns();
+		sceneSwitch.Id = ++_nextId;
+		sceneSwitch.RequestedAt = requestedAt;
+		sceneSwitch.DispatchedAt = now;
+		sceneSwitch.SceneChangedAt = now;
+		sceneSwitch.TransitionEndedAt = now;
+		sceneSwitch.AlreadyOnProgram = true;
+		snprintf(sceneSwitch.SceneName, sizeof(sceneSwitch.SceneName), "%s", obs_source_get_name(scene));
+		_requestedSwitches++;
+		_Finish(sceneSwitch);
+		return sceneSwitch.Id;
+	}
+
+	OBSSourceAutoRelease currentTransition;
+	int currentDuration = 0;
+	if (transition) {
+		currentTransition = obs_frontend_get_current_transition();
+		currentDuration = obs_frontend_get_transition_duration();
+	}
+
+	SceneSwitch sceneSwitch;
+	TransitionRestore restore;
+	bool restoreNeeded = false;
+	{
+		QMutexLocker locker(&_mutex);
+		uint64_t now = os_gettime_ns();
+
+		while (!_pending.empty() && now - _pending.front().DispatchedAt > PENDING_SWITCH_TIMEOUT) {
+			_Finish(_pending.front());
+			_pending.pop_front();
+		}
+
+		sceneSwitch.Id = ++_nextId;
+		sceneSwitch.RequestedAt = requestedAt;
+		snprintf(sceneSwitch.SceneName, sizeof(sceneSwitch.SceneName), "%s", obs_source_get_name(scene));
+
+		if (transition) {
+			// Only the transition that was in place before the first of several overridden switches is restored
+			if (!_overrideActive) {
+				_restore.Transition = OBSGetWeakRef(currentTransition);
+				_restore.Duration = currentDuration;
+				_overrideActive = true;
+			}
+			_overrideSwitchId = sceneSwitch.Id;
+			sceneSwitch.TransitionOverridden = true;
+			_overriddenSwitches++;
+		} else {
+			restoreNeeded = _TakeRestore(restore);
+		}
+
+		sceneSwitch.DispatchedAt = now;
+		_pending.push_back(sceneSwitch);
+		_requestedSwitches++;
+	}
+
+	if (transition) {
+		obs_frontend_set_current_transition(transition);
+		if (duration >= 0)
+			obs_frontend_set_transition_duration(duration);
+	} else if (restoreNeeded) {
+		_ApplyRestore(restore);
+	}
+	obs_frontend_set_current_scene(scene);
+
+	return sceneSwitch.Id;
+}
+
+SceneSwitch SceneSwitchTracker::WaitForTransitionEnd(uint64_t switchId, int timeoutMs)
+{
+	QMutexLocker locker(&_mutex);
+	uint64_t deadline = os_gettime_ns() + (uint64_t)timeoutMs * 1000000;
+
+	// Switches only reach the history once their transition ended, was interrupted or was given up on
+	while (true) {
+		for (auto &sceneSwitch : _switches.Snapshot()) {
+			if (sceneSwitch.Id == switchId)
+				return sceneSwitch;
+		}
+		uint64_t now = os_gettime_ns();
+		if (now >= deadline)
+			break;
+		_condition.wait(&_mutex, (unsigned long)((deadline - now + 999999) / 1000000));
+	}
+
+	if (_current.Id == switchId)
+		return _current;
+	for (auto &sceneSwitch : _pending) {
+		if (sceneSwitch.Id == switchId)
+			return sceneSwitch;
+	}
+	return SceneSwitch();
+}
+
+QJsonObject SceneSwitchTracker::GetHistory()
+{
+	QMutexLocker locker(&_mutex);
+
+	QJsonObject ret;
+	if (_current.Id && !_current.TransitionEndedAt)
+		ret["currentSwitch"] = SwitchToJson(_current);
+
+	QJsonArray pendingSwitches;
+	for (auto &sceneSwitch : _pending)
+		pendingSwitches.append(SwitchToJson(sceneSwitch));
+	ret["pendingSwitches"] = pendingSwitches;
+
+	QJsonArray switches;
+	for (auto &sceneSwitch : _switches.Snapshot())
+		switches.append(SwitchToJson(sceneSwitch));
+	ret["switches"] = switches;
+
+	return ret;
+}
+
+void SceneSwitchTracker::PrefetchTransitionMedia(obs_source_t *transition)
+{
+	if (!transition || strcmp(obs_source_get_id(transition), "obs_stinger_transition") != 0)
+		return;
+
+	auto websocketManager = GetWebsocketManager();
+	if (!websocketManager)
+		return;
+
+	OBSDataAutoRelease settings = obs_source_get_settings(transition);
+	QStringList paths;
+	paths << QString::fromUtf8(obs_data_get_string(settings, "path"));
+	if (obs_data_get_bool(settings, "track_matte_enabled"))
+		paths << QString::fromUtf8(obs_data_get_string(settings, "track_matte_path"));
+
+	for (auto &path : paths) {
+		QFileInfo fileInfo(path);
+		if (path.isEmpty() || !fileInfo.isFile() || fileInfo.size() > PREFETCH_MAX_FILE_SIZE)
+			continue;
+
+		{
+			QMutexLocker locker(&_prefetchMutex);
+			qint64 modifiedAt = fileInfo.lastModified().toMSecsSinceEpoch();
+			auto it = _prefetchedFiles.constFind(path);
+			if (it != _prefetchedFiles.constEnd() && it.value() == modifiedAt)
+				continue;
+			_prefetchedFiles[path] = modifiedAt;
+		}
+
+		_prefetches++;
+		websocketManager->GetWorkerPool()->Run([path]() {
+			QFile file(path);
+			if (!file.open(QIODevice::ReadOnly)) {
+				blog(LOG_WARNING, "[SceneSwitchTracker::PrefetchTransitionMedia] Unable to open `%s`.", QT_TO_UTF8(path));
+				return;
+			}
+
+			// Reading the file through leaves it in the OS page cache, where the stinger's decoder finds it
+			std::vector<char> buffer(PREFETCH_CHUNK_SIZE);
+			qint64 total = 0;
+			qint64 read;
+			while ((read = file.read(buffer.data(), (qint64)buffer.size())) > 0)
+				total += read;
+
+			auto sceneSwitchTracker = GetSceneSwitchTracker();
+			if (sceneSwitchTracker)
+				sceneSwitchTracker->_prefetchedBytes += (uint64_t)total;
+#ifdef DEBUG_MODE
+			blog(LOG_INFO, "[SceneSwitchTracker::PrefetchTransitionMedia] Read ahead %lld bytes of `%s`.", (long long)total, QT_TO_UTF8(path));
+#endif
+		});
+	}
+}
+
+QJsonObject SceneSwitchTracker::GetStats()
+{
+	QJsonObject ret;
+	ret["switches"] = (double)_switchCount;
+	ret["requestedSwitches"] = (double)_requestedSwitches;
+	ret["overriddenSwitches"] = (double)_overriddenSwitches;
+	ret["interruptedSwitches"] = (double)_interruptedSwitches;
+	ret["lastSwitchLatency"] = (double)_lastSwitchLatency / 1000000.0;
+	ret["maxSwitchLatency"] = (double)_maxSwitchLatency / 1000000.0;
+	ret["mediaPrefetches"] = (double)_prefetches;
+	ret["mediaPrefetchedBytes"] = (double)_prefetchedBytes;
+	return ret;
+}
+
+QJsonObject SceneSwitchTracker::SwitchToJson(const SceneSwitch &sceneSwitch)
+{
+	QJsonObject ret;
+	ret["id"] = (double)sceneSwitch.Id;
+	ret["sceneName"] = sceneSwitch.SceneName;
+	ret["transitionName"] = sceneSwitch.TransitionName;
+	ret["transitionDuration"] = sceneSwitch.TransitionDuration;
+	ret["transitionOverridden"] = sceneSwitch.TransitionOverridden;
+	ret["requested"] = sceneSwitch.RequestedAt != 0;
+	ret["completed"] = sceneSwitch.TransitionEndedAt != 0;
+	ret["interrupted"] = sceneSwitch.Interrupted;
+	ret["alreadyOnProgram"] = sceneSwitch.AlreadyOnProgram;
+	ret["timestamp"] = (double)((sceneSwitch.RequestedAt ? sceneSwitch.RequestedAt : sceneSwitch.SceneChangedAt) / 1000000);
+
+	// Request arrival until the switch was handed to the frontend
+	ret["queueDuration"] = DurationMs(sceneSwitch.RequestedAt, sceneSwitch.DispatchedAt);
+	// Handed to the frontend until it started the transition
+	ret["sceneChangeDuration"] = DurationMs(sceneSwitch.DispatchedAt, sceneSwitch.SceneChangedAt);
+	ret["transitionTime"] = DurationMs(sceneSwitch.SceneChangedAt, sceneSwitch.TransitionEndedAt);
+	// Request arrival, or the scene change for switches not made by a request, until the scene was fully on program
+	uint64_t startedAt = sceneSwitch.RequestedAt ? sceneSwitch.RequestedAt : sceneSwitch.SceneChangedAt;
+	ret["totalDuration"] = sceneSwitch.SceneChangedAt ? DurationMs(startedAt, sceneSwitch.TransitionEndedAt) : 0.0;
+
+	return ret;
+}
+
+void SceneSwitchTracker::FrontendEventCallback(enum obs_frontend_event event, void *param)
+{
+	auto sceneSwitchTracker = static_cast<SceneSwitchTracker*>(param);
+	uint64_t now = os_gettime_ns();
+
+	switch (event) {
+		case OBS_FRONTEND_EVENT_SCENE_CHANGED:
+			sceneSwitchTracker->_SceneChanged(now);
+			break;
+		case OBS_FRONTEND_EVENT_TRANSITION_STOPPED:
+			sceneSwitchTracker->_TransitionStopped(now);
+			break;
+		case OBS_FRONTEND_EVENT_FINISHED_LOADING:
+		case OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGED:
+		case OBS_FRONTEND_EVENT_TRANSITION_LIST_CHANGED:
+			sceneSwitchTracker->_PrefetchTransitions();
+			break;
+		case OBS_FRONTEND_EVENT_TRANSITION_CHANGED: {
+			OBSSourceAutoRelease transition = obs_frontend_get_current_transition();
+			sceneSwitchTracker->PrefetchTransitionMedia(transition);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+void SceneSwitchTracker::_SceneChanged(uint64_t now)
+{
+	OBSSourceAutoRelease scene = obs_frontend_get_current_scene();
+	if (!scene)
+		return;
+	const char *sceneName = obs_source_get_name(scene);
+	OBSSourceAutoRelease transition = obs_frontend_get_current_transition();
+
+	QMutexLocker locker(&_mutex);
+
+	if (_current.Id && !_current.TransitionEndedAt) {
+		_current.Interrupted = true;
+		_interruptedSwitches++;
+		_Finish(_current);
+	}
+
+	while (!_pending.empty() && now - _pending.front().DispatchedAt > PENDING_SWITCH_TIMEOUT) {
+		_Finish(_pending.front());
+		_pending.pop_front();
+	}
+
+	// The frontend applies switches in the order they were dispatched. Earlier pending switches that did not
+	// lead to a scene change targeted the scene that was already on program.
+	SceneSwitch sceneSwitch;
+	auto match = std::find_if(_pending.begin(), _pending.end(), [sceneName](const SceneSwitch &candidate) {
+		return strcmp(candidate.SceneName, sceneName) == 0;
+	});
+	if (match != _pending.end()) {
+		sceneSwitch = *match;
+		for (auto it = _pending.begin(); it != match; ++it)
+			_Finish(*it);
+		_pending.erase(_pending.begin(), match + 1);
+	} else {
+		sceneSwitch.Id = ++_nextId;
+		snprintf(sceneSwitch.SceneName, sizeof(sceneSwitch.SceneName), "%s", sceneName);
+	}
+
+	sceneSwitch.SceneChangedAt = now;
+	if (transition) {
+		snprintf(sceneSwitch.TransitionName, sizeof(sceneSwitch.TransitionName), "%s", obs_source_get_name(transition));
+		sceneSwitch.TransitionDuration = obs_transition_fixed(transition) ? 0 : obs_frontend_get_transition_duration();
+	}
+	_current = sceneSwitch;
+	_switchCount++;
+	_condition.wakeAll();
+}
+
+void SceneSwitchTracker::_TransitionStopped(uint64_t now)
+{
+	SceneSwitch finished;
+	TransitionRestore restore;
+	bool restoreNeeded = false;
+	{
+		QMutexLocker locker(&_mutex);
+		if (!_current.Id || _current.TransitionEndedAt)
+			return;
+
+		_current.TransitionEndedAt = now;
+		if (_current.RequestedAt) {
+			uint64_t latency = now - _current.RequestedAt;
+			_lastSwitchLatency = latency;
+			if (latency > _maxSwitchLatency)
+				_maxSwitchLatency = latency;
+		}
+		finished = _current;
+		_Finish(_current);
+
+		// Later overridden switches that are still pending keep the override in place
+		if (_overrideActive && _overrideSwitchId <= finished.Id)
+			restoreNeeded = _TakeRestore(restore);
+	}
+
+	// On the UI thread the frontend applies the restore synchronously and emits its events from within, so the lock must not be held
+	if (restoreNeeded)
+		_ApplyRestore(restore);
+
+	_Broadcast(finished);
+}
+
+void SceneSwitchTracker::_Finish(SceneSwitch &sceneSwitch)
+{
+	_switches.Push(sceneSwitch);
+	_condition.wakeAll();
+}
+
+bool SceneSwitchTracker::_TakeRestore(TransitionRestore &restore)
+{
+	if (!_overrideActive)
+		return false;
+
+	restore = _restore;
+	_restore = TransitionRestore();
+	_overrideActive = false;
+	_overrideSwitchId = 0;
+	return true;
+}
+
+void SceneSwitchTracker::_ApplyRestore(const TransitionRestore &restore)
+{
+	OBSSourceAutoRelease transition = obs_weak_source_get_source(restore.Transition);
+	if (transition)
+		obs_frontend_set_current_transition(transition);
+	obs_frontend_set_transition_duration(restore.Duration);
+}
+
+void SceneSwitchTracker::_PrefetchTransitions()
+{
+	struct obs_frontend_source_list transitions = {};
+	obs_frontend_get_transitions(&transitions);
+	for (size_t i = 0; i < transitions.sources.num; i++)
+		PrefetchTransitionMedia(transitions.sources.array[i]);
+	obs_frontend_source_list_free(&transitions);
+}
+
+void SceneSwitchTracker::_Broadcast(const SceneSwitch &sceneSwitch)
+{
+	auto websocketManager = GetWebsocketManager();
+	if (!websocketManager)
+		return;
+
+	websocketManager->BroadcastEvent(EventSubscription::Transitions, "SceneTransitionEnded", SwitchToJson(sceneSwitch));
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <obs.hpp>
+#include <obs-frontend-api.h>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QWaitCondition>
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include "RingBuffer.h"
+#include "../plugin-main.h"
+
+// One program scene switch. Timestamps are `os_gettime_ns()`, 0 if the phase was not reached.
+struct SceneSwitch {
+	uint64_t Id = 0;
+	// Arrival of the `SetCurrentProgramScene` request. 0 when the scene was switched from the UI or another plugin.
+	uint64_t RequestedAt = 0;
+	// The switch was handed to the frontend
+	uint64_t DispatchedAt = 0;
+	// `OBS_FRONTEND_EVENT_SCENE_CHANGED`, when the transition to the scene starts
+	uint64_t SceneChangedAt = 0;
+	// `OBS_FRONTEND_EVENT_TRANSITION_STOPPED`, when the scene is fully on program
+	uint64_t TransitionEndedAt = 0;
+	// The transition was replaced by another switch before it ended
+	bool Interrupted = false;
+	bool TransitionOverridden = false;
+	// The scene already was on program, so nothing was switched
+	bool AlreadyOnProgram = false;
+	int TransitionDuration = 0;
+	char SceneName[128] = {};
+	char TransitionName[128] = {};
+};
+
+// Times every program scene switch from the request's arrival through the frontend's scene change to the end of the
+// transition, and applies per-switch transition overrides. An overridden transition and duration are restored once
+// the overridden switch's transition ends, or before the next switch that does not override them.
+// Stinger media is read ahead into the OS cache whenever the transition list changes, so the first switch through
+// a stinger does not wait on the disk.
+class SceneSwitchTracker {
+	public:
+		static const size_t HistorySize = 64;
+
+		SceneSwitchTracker();
+		~SceneSwitchTracker();
+
+		// Switches the program scene on behalf of a request that arrived at `requestedAt`. A `transition` and
+		// `duration` (milliseconds, -1 keeps the current duration) only apply to this switch. Returns the switch id.
+		uint64_t SwitchScene(obs_source_t *scene, uint64_t requestedAt, obs_source_t *transition = nullptr, int duration = -1);
+		// Blocks until the switch's transition ended or was interrupted, or until the timeout elapses. Returns the
+		// switch as it was at that point, with an `Id` of 0 if the switch is no longer known.
+		SceneSwitch WaitForTransitionEnd(uint64_t switchId, int timeoutMs);
+
+		QJsonObject GetHistory();
+
+		void PrefetchTransitionMedia(obs_source_t *transition);
+
+		QJsonObject GetStats();
+
+		static QJsonObject SwitchToJson(const SceneSwitch &sceneSwitch);
+
+	private:
+		struct TransitionRestore {
+			OBSWeakSource Transition;
+			int Duration = 0;
+		};
+
+		static void FrontendEventCallback(enum obs_frontend_event event, void *param);
+
+		void _SceneChanged(uint64_t now);
+		void _TransitionStopped(uint64_t now);
+		void _Finish(SceneSwitch &sceneSwitch);
+		bool _TakeRestore(TransitionRestore &restore);
+		void _ApplyRestore(const TransitionRestore &restore);
+		void _PrefetchTransitions();
+		void _Broadcast(const SceneSwitch &sceneSwitch);
+
+		// Serializes `SwitchScene()` calls around their frontend calls. Never taken by the frontend event callbacks.
+		QMutex _dispatchMutex;
+		QMutex _mutex;
+		QWaitCondition _condition;
+		uint64_t _nextId;
+		// Requested switches handed to the frontend whose scene change has not been seen yet, oldest first
+		std::deque<SceneSwitch> _pending;
+		// The switch whose transition is running
+		SceneSwitch _current;
+		// Finished switches. Only pushed to with `_mutex` held.
+		RingBuffer<SceneSwitch, HistorySize> _switches;
+
+		// Set while an overridden transition is in place
+		bool _overrideActive;
+		uint64_t _overrideSwitchId;
+		TransitionRestore _restore;
+
+		QMutex _prefetchMutex;
+		// Last modification time of every file already read ahead, by path
+		QHash<QString, qint64> _prefetchedFiles;
+
+		std::atomic<uint64_t> _switchCount;
+		std::atomic<uint64_t> _requestedSwitches;
+		std::atomic<uint64_t> _overriddenSwitches;
+		std::atomic<uint64_t> _interruptedSwitches;
+		std::atomic<uint64_t> _lastSwitchLatency;
+		std::atomic<uint64_t> _maxSwitchLatency;
+		std::atomic<uint64_t> _prefetches;
+		std::atomic<uint64_t> _prefetchedBytes;
+};
+
+typedef std::shared_ptr<SceneSwitchTracker> SceneSwitchTrackerPtr;
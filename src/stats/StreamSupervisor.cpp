@@ -0,0 +1,456 @@
+#include <util/platform.h>
+
+#include "StreamSupervisor.h"
+#include "../WebsocketManager.h"
+
+// Milliseconds between two checks of the output's byte counter while waiting for the first frame
+#define FIRST_FRAME_POLL_INTERVAL 10
+// Nanoseconds after which a `StartStream` request that never led to a start is no longer attributed to one
+#define PENDING_REQUEST_TIMEOUT 60000000000ULL
+
+static double DurationMs(uint64_t from, uint64_t to)
+{
+	return (from && to >= from) ? (double)(to - from) / 1000000.0 : 0.0;
+}
+
+StreamSupervisor::StreamSupervisor() :
+	_pendingRequestAt(0),
+	_running(true),
+	_starts(0),
+	_failedStarts(0),
+	_reconnectAttempts(0),
+	_reconnectCount(0),
+	_lastConnectTime(0),
+	_lastFirstFrameTime(0)
+{
+	// The frontend only creates its outputs once all modules are loaded, so attaching waits for `FINISHED_LOADING`
+	obs_frontend_add_event_callback(StreamSupervisor::FrontendEventCallback, this);
+	_superviseThread = std::thread(&StreamSupervisor::_SuperviseLoop, this);
+}
+
+StreamSupervisor::~StreamSupervisor()
+{
+	obs_frontend_remove_event_callback(StreamSupervisor::FrontendEventCallback, this);
+
+	OBSOutputAutoRelease output = obs_weak_output_get_output(_output);
+	if (output)
+		_Disconnect(output);
+
+	{
+		QMutexLocker locker(&_mutex);
+		_running = false;
+		_condition.wakeAll();
+	}
+	_superviseThread.join();
+}
+
+uint64_t StreamSupervisor::BeginStart()
+{
+	QMutexLocker locker(&_mutex);
+
+	// A start that is still connecting is the one the request will end up waiting for
+	if (_current.Id && !_current.ConnectedAt && !_current.StoppedAt)
+		return _current.Id - 1;
+
+	_pendingRequestAt = os_gettime_ns();
+	return _current.Id;
+}
+
+StreamStartAttempt StreamSupervisor::WaitForActive(uint64_t previousAttemptId, int timeoutMs)
+{
+	QMutexLocker locker(&_mutex);
+	uint64_t deadline = os_gettime_ns() + (uint64_t)timeoutMs * 1000000;
+
+	while (_running) {
+		if (_current.Id > previousAttemptId && (_current.FirstFrameAt || _current.StoppedAt))
+			break;
+		uint64_t now = os_gettime_ns();
+		if (now >= deadline)
+			break;
+		_condition.wait(&_mutex, (unsigned long)((deadline - now + 999999) / 1000000));
+	}
+
+	if (_current.Id > previousAttemptId)
+		return _current;
+	return StreamStartAttempt();
+}
+
+QJsonObject StreamSupervisor::GetLatestAttempt()
+{
+	QMutexLocker locker(&_mutex);
+	if (!_current.Id)
+		return QJsonObject();
+	return AttemptToJson(_current);
+}
+
+QJsonObject StreamSupervisor::GetHistory()
+{
+	QMutexLocker locker(&_mutex);
+
+	QJsonObject ret;
+	if (_current.Id)
+		ret["latestAttempt"] = AttemptToJson(_current);
+
+	QJsonArray attempts;
+	for (auto &attempt : _attempts.Snapshot())
+		attempts.append(AttemptToJson(attempt));
+	ret["attempts"] = attempts;
+
+	QJsonArray reconnects;
+	for (auto &reconnect : _reconnects.Snapshot()) {
+		QJsonObject reconnectJson;
+		reconnectJson["timestamp"] = (double)(reconnect.StartedAt / 1000000);
+		reconnectJson["duration"] = DurationMs(reconnect.StartedAt, reconnect.EndedAt);
+		reconnectJson["attempts"] = (double)reconnect.Attempts;
+		reconnectJson["succeeded"] = reconnect.Succeeded;
+		reconnects.append(reconnectJson);
+	}
+	ret["reconnects"] = reconnects;
+
+	return ret;
+}
+
+QJsonObject StreamSupervisor::GetStats()
+{
+	QJsonObject ret;
+	ret["starts"] = (double)_starts;
+	ret["failedStarts"] = (double)_failedStarts;
+	ret["reconnectAttempts"] = (double)_reconnectAttempts;
+	ret["reconnects"] = (double)_reconnectCount;
+	ret["lastConnectTime"] = (double)_lastConnectTime / 1000000.0;
+	ret["lastFirstFrameTime"] = (double)_lastFirstFrameTime / 1000000.0;
+	return ret;
+}
+
+QJsonObject StreamSupervisor::AttemptToJson(const StreamStartAttempt &attempt)
+{
+	uint64_t now = os_gettime_ns();
+	uint64_t startedAt = attempt.RequestedAt ? attempt.RequestedAt : attempt.StartingAt;
+
+	QJsonObject ret;
+	ret["attemptId"] = (double)attempt.Id;
+	ret["requested"] = attempt.RequestedAt != 0;
+	ret["timestamp"] = (double)(startedAt / 1000000);
+	ret["connected"] = attempt.ConnectedAt != 0;
+	ret["firstFrameSent"] = attempt.FirstFrameAt != 0;
+	ret["stopped"] = attempt.StoppedAt != 0;
+
+	// Breakdown of the start latency. Each phase is 0 until it completes.
+	ret["queueDuration"] = DurationMs(attempt.RequestedAt, attempt.StartingAt);
+	ret["connectDuration"] = attempt.ConnectedAt ? DurationMs(attempt.StartingAt, attempt.ConnectedAt) : 0.0;
+	ret["firstFrameDuration"] = attempt.FirstFrameAt ? DurationMs(attempt.ConnectedAt, attempt.FirstFrameAt) : 0.0;
+	ret["startDuration"] = attempt.FirstFrameAt ? DurationMs(startedAt, attempt.FirstFrameAt) : 0.0;
+
+	uint64_t endedAt = attempt.StoppedAt ? attempt.StoppedAt : now;
+	ret["activeDuration"] = attempt.ConnectedAt ? DurationMs(attempt.ConnectedAt, endedAt) : 0.0;
+	ret["reconnecting"] = attempt.ReconnectingSince != 0;
+	ret["reconnectAttempts"] = (double)attempt.ReconnectAttempts;
+	ret["reconnects"] = (double)attempt.Reconnects;
+	ret["reconnectDuration"] = (double)attempt.ReconnectDuration / 1000000.0 + DurationMs(attempt.ReconnectingSince, endedAt);
+	if (attempt.StoppedAt) {
+		ret["stopCode"] = attempt.StopCode;
+		ret["stopReason"] = StopCodeName(attempt.StopCode);
+	}
+	return ret;
+}
+
+const char *StreamSupervisor::StopCodeName(int code)
+{
+	switch (code) {
+		case OBS_OUTPUT_SUCCESS:
+			return "success";
+		case OBS_OUTPUT_BAD_PATH:
+			return "badPath";
+		case OBS_OUTPUT_CONNECT_FAILED:
+			return "connectFailed";
+		case OBS_OUTPUT_INVALID_STREAM:
+			return "invalidStream";
+		case OBS_OUTPUT_DISCONNECTED:
+			return "disconnected";
+		case OBS_OUTPUT_UNSUPPORTED:
+			return "unsupported";
+		case OBS_OUTPUT_NO_SPACE:
+			return "noSpace";
+		case OBS_OUTPUT_ENCODE_ERROR:
+			return "encodeError";
+		default:
+			return "error";
+	}
+}
+
+void StreamSupervisor::FrontendEventCallback(enum obs_frontend_event event, void *param)
+{
+	auto supervisor = static_cast<StreamSupervisor*>(param);
+	uint64_t now = os_gettime_ns();
+
+	switch (event) {
+		case OBS_FRONTEND_EVENT_FINISHED_LOADING:
+		case OBS_FRONTEND_EVENT_PROFILE_CHANGED:
+			supervisor->_Attach();
+			break;
+		case OBS_FRONTEND_EVENT_STREAMING_STARTING:
+			supervisor->_Attach();
+			supervisor->_Starting(now);
+			break;
+		// The frontend may have replaced the output after `STREAMING_STARTING`, in which case its signals were missed
+		// and these events are the only record of the start and stop
+		case OBS_FRONTEND_EVENT_STREAMING_STARTED:
+			supervisor->_Attach();
+			supervisor->_Connected(now);
+			break;
+		case OBS_FRONTEND_EVENT_STREAMING_STOPPED:
+			supervisor->_Stopped(now, OBS_OUTPUT_SUCCESS, nullptr);
+			supervisor->_Attach();
+			break;
+		default:
+			break;
+	}
+}
+
+void StreamSupervisor::StartingCallback(void *param, calldata_t *)
+{
+	static_cast<StreamSupervisor*>(param)->_Starting(os_gettime_ns());
+}
+
+void StreamSupervisor::StartCallback(void *param, calldata_t *)
+{
+	static_cast<StreamSupervisor*>(param)->_Connected(os_gettime_ns());
+}
+
+void StreamSupervisor::ReconnectCallback(void *param, calldata_t *data)
+{
+	int retryDelay = (int)calldata_int(data, "timeout_sec") * 1000;
+	static_cast<StreamSupervisor*>(param)->_Reconnecting(os_gettime_ns(), retryDelay);
+}
+
+void StreamSupervisor::ReconnectSuccessCallback(void *param, calldata_t *)
+{
+	static_cast<StreamSupervisor*>(param)->_Reconnected(os_gettime_ns());
+}
+
+void StreamSupervisor::StopCallback(void *param, calldata_t *data)
+{
+	uint64_t now = os_gettime_ns();
+	int code = (int)calldata_int(data, "code");
+	auto output = static_cast<obs_output_t*>(calldata_ptr(data, "output"));
+	const char *lastError = output ? obs_output_get_last_error(output) : nullptr;
+	static_cast<StreamSupervisor*>(param)->_Stopped(now, code, lastError);
+}
+
+void StreamSupervisor::_Attach()
+{
+	QMutexLocker attachLocker(&_attachMutex);
+
+	OBSOutputAutoRelease output = obs_frontend_get_streaming_output();
+	OBSWeakOutput previousWeakOutput;
+	{
+		QMutexLocker locker(&_mutex);
+		OBSOutputAutoRelease attachedOutput = obs_weak_output_get_output(_output);
+		if (attachedOutput.Get() == output.Get())
+			return;
+		previousWeakOutput = _output;
+		_output = OBSGetWeakRef(output.Get());
+	}
+
+	// libobs holds the signal lock while calling the callbacks, which take `_mutex`, so (dis)connecting happens without it
+	OBSOutputAutoRelease previousOutput = obs_weak_output_get_output(previousWeakOutput);
+	if (previousOutput)
+		_Disconnect(previousOutput);
+	if (output)
+		_Connect(output);
+
+#ifdef DEBUG_MODE
+	blog(LOG_INFO, "[StreamSupervisor::_Attach] Attached to streaming output `%s`.", output ? obs_output_get_name(output) : "(none)");
+#endif
+}
+
+void StreamSupervisor::_Connect(obs_output_t *output)
+{
+	signal_handler_t *signalHandler = obs_output_get_signal_handler(output);
+	signal_handler_connect(signalHandler, "starting", StreamSupervisor::StartingCallback, this);
+	signal_handler_connect(signalHandler, "start", StreamSupervisor::StartCallback, this);
+	signal_handler_connect(signalHandler, "reconnect", StreamSupervisor::ReconnectCallback, this);
+	signal_handler_connect(signalHandler, "reconnect_success", StreamSupervisor::ReconnectSuccessCallback, this);
+	signal_handler_connect(signalHandler, "stop", StreamSupervisor::StopCallback, this);
+}
+
+void StreamSupervisor::_Disconnect(obs_output_t *output)
+{
+	signal_handler_t *signalHandler = obs_output_get_signal_handler(output);
+	signal_handler_disconnect(signalHandler, "starting", StreamSupervisor::StartingCallback, this);
+	signal_handler_disconnect(signalHandler, "start", StreamSupervisor::StartCallback, this);
+	signal_handler_disconnect(signalHandler, "reconnect", StreamSupervisor::ReconnectCallback, this);
+	signal_handler_disconnect(signalHandler, "reconnect_success", StreamSupervisor::ReconnectSuccessCallback, this);
+	signal_handler_disconnect(signalHandler, "stop", StreamSupervisor::StopCallback, this);
+}
+
+void StreamSupervisor::_SuperviseLoop()
+{
+	QMutexLocker locker(&_mutex);
+	while (_running) {
+		bool awaitingFirstFrame = _current.ConnectedAt && !_current.FirstFrameAt && !_current.StoppedAt;
+		if (!awaitingFirstFrame) {
+			_condition.wait(&_mutex);
+			continue;
+		}
+
+		uint64_t attemptId = _current.Id;
+		OBSWeakOutput weakOutput = _output;
+		locker.unlock();
+		OBSOutputAutoRelease output = obs_weak_output_get_output(weakOutput);
+		bool firstFrameSent = output && obs_output_get_total_bytes(output) > 0;
+		uint64_t now = os_gettime_ns();
+		locker.relock();
+
+		if (!firstFrameSent || _current.Id != attemptId || _current.FirstFrameAt || _current.StoppedAt) {
+			_condition.wait(&_mutex, FIRST_FRAME_POLL_INTERVAL);
+			continue;
+		}
+
+		_current.FirstFrameAt = now;
+		_lastConnectTime = _current.ConnectedAt - _current.StartingAt;
+		_lastFirstFrameTime = now - _current.ConnectedAt;
+		_condition.wakeAll();
+
+		QJsonObject eventData = AttemptToJson(_current);
+		locker.unlock();
+		blog(LOG_INFO, "[StreamSupervisor::_SuperviseLoop] Stream started in %.1fms (queue %.1fms, connect %.1fms, first frame %.1fms).",
+			eventData["startDuration"].toDouble(), eventData["queueDuration"].toDouble(), eventData["connectDuration"].toDouble(), eventData["firstFrameDuration"].toDouble());
+		_Broadcast("StreamStarted", eventData);
+		locker.relock();
+	}
+}
+
+void StreamSupervisor::_BeginAttempt(uint64_t now)
+{
+	StreamStartAttempt attempt;
+	attempt.Id = _current.Id + 1;
+	if (_pendingRequestAt && now - _pendingRequestAt < PENDING_REQUEST_TIMEOUT)
+		attempt.RequestedAt = _pendingRequestAt;
+	attempt.StartingAt = now;
+	_pendingRequestAt = 0;
+	_current = attempt;
+	_starts++;
+	_condition.wakeAll();
+}
+
+void StreamSupervisor::_Starting(uint64_t now)
+{
+	QMutexLocker locker(&_mutex);
+	// `STREAMING_STARTING` and the output's `starting` signal both mark the same start
+	if (_current.Id && !_current.StoppedAt)
+		return;
+	_BeginAttempt(now);
+}
+
+void StreamSupervisor::_Connected(uint64_t now)
+{
+	QMutexLocker locker(&_mutex);
+	if (!_current.Id || _current.StoppedAt)
+		_BeginAttempt(now);
+	if (_current.ConnectedAt)
+		return;
+	_current.ConnectedAt = now;
+	_condition.wakeAll();
+}
+
+void StreamSupervisor::_Reconnecting(uint64_t now, int retryDelay)
+{
+	QJsonObject eventData;
+	{
+		QMutexLocker locker(&_mutex);
+		if (!_current.Id || _current.StoppedAt)
+			return;
+
+		if (!_current.ReconnectingSince) {
+			_current.ReconnectingSince = now;
+			_current.OutageAttempts = 0;
+		}
+		_current.OutageAttempts++;
+		_current.ReconnectAttempts++;
+		_reconnectAttempts++;
+
+		eventData["reconnectAttempt"] = (double)_current.OutageAttempts;
+		eventData["outageDuration"] = DurationMs(_current.ReconnectingSince, now);
+		eventData["retryDelay"] = retryDelay;
+	}
+
+	_Broadcast("StreamReconnecting", eventData);
+}
+
+void StreamSupervisor::_Reconnected(uint64_t now)
+{
+	StreamReconnect reconnect;
+	{
+		QMutexLocker locker(&_mutex);
+		if (!_current.ReconnectingSince || _current.StoppedAt)
+			return;
+
+		reconnect.StartedAt = _current.ReconnectingSince;
+		reconnect.EndedAt = now;
+		reconnect.Attempts = _current.OutageAttempts;
+		reconnect.Succeeded = true;
+		_reconnects.Push(reconnect);
+
+		_current.Reconnects++;
+		_current.ReconnectDuration += now - _current.ReconnectingSince;
+		_current.ReconnectingSince = 0;
+		_current.OutageAttempts = 0;
+		_reconnectCount++;
+	}
+
+	blog(LOG_INFO, "[StreamSupervisor::_Reconnected] Stream reconnected after %.1fms and %u attempt(s).", DurationMs(reconnect.StartedAt, reconnect.EndedAt), reconnect.Attempts);
+
+	QJsonObject eventData;
+	eventData["reconnectAttempts"] = (double)reconnect.Attempts;
+	eventData["reconnectDuration"] = DurationMs(reconnect.StartedAt, reconnect.EndedAt);
+	_Broadcast("StreamReconnected", eventData);
+}
+
+void StreamSupervisor::_Stopped(uint64_t now, int code, const char *lastError)
+{
+	QJsonObject eventData;
+	bool connected;
+	{
+		QMutexLocker locker(&_mutex);
+		if (!_current.Id || _current.StoppedAt)
+			return;
+
+		if (_current.ReconnectingSince) {
+			StreamReconnect reconnect;
+			reconnect.StartedAt = _current.ReconnectingSince;
+			reconnect.EndedAt = now;
+			reconnect.Attempts = _current.OutageAttempts;
+			_reconnects.Push(reconnect);
+			_current.ReconnectDuration += now - _current.ReconnectingSince;
+			_current.ReconnectingSince = 0;
+		}
+
+		_current.StoppedAt = now;
+		_current.StopCode = code;
+		_attempts.Push(_current);
+		connected = _current.ConnectedAt != 0;
+		if (!connected)
+			_failedStarts++;
+		_condition.wakeAll();
+
+		eventData = AttemptToJson(_current);
+	}
+
+	if (lastError && *lastError)
+		eventData["lastError"] = lastError;
+
+	if (!connected)
+		blog(LOG_WARNING, "[StreamSupervisor::_Stopped] Stream failed to start (reason `%s`).", StopCodeName(code));
+
+	_Broadcast(connected ? "StreamStopped" : "StreamStartFailed", eventData);
+}
+
+void StreamSupervisor::_Broadcast(const char *eventType, const QJsonObject &eventData)
+{
+	auto websocketManager = GetWebsocketManager();
+	if (!websocketManager)
+		return;
+
+	websocketManager->BroadcastEvent(EventSubscription::Outputs, eventType, eventData);
+}
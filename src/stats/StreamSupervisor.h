@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <obs.hpp>
+#include <obs-frontend-api.h>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include "RingBuffer.h"
+#include "../plugin-main.h"
+
+// One start of the streaming output, from the start request until it stops. Timestamps are `os_gettime_ns()`, 0 if the phase was not reached.
+struct StreamStartAttempt {
+	uint64_t Id = 0;
+	// Arrival of the `StartStream` request. 0 when the stream was started from the UI or another plugin.
+	uint64_t RequestedAt = 0;
+	uint64_t StartingAt = 0;
+	// The output connected and started capturing
+	uint64_t ConnectedAt = 0;
+	// The first encoded data was written to the connection
+	uint64_t FirstFrameAt = 0;
+	uint64_t StoppedAt = 0;
+	int StopCode = 0;
+
+	uint32_t ReconnectAttempts = 0;
+	uint32_t Reconnects = 0;
+	uint64_t ReconnectDuration = 0;
+	// Start of the current outage, 0 while connected
+	uint64_t ReconnectingSince = 0;
+	uint32_t OutageAttempts = 0;
+};
+
+struct StreamReconnect {
+	uint64_t StartedAt = 0;
+	uint64_t EndedAt = 0;
+	uint32_t Attempts = 0;
+	bool Succeeded = false;
+};
+
+// Follows the frontend streaming output through its `starting`, `start`, `reconnect`, `reconnect_success` and `stop`
+// signals and breaks every start down into queue, connect and first frame latency. The frontend may replace the output
+// whenever the service or output settings change, so the signals are re-attached on every streaming frontend event.
+// First frame detection polls the output's byte counter, which bounds its precision to `FIRST_FRAME_POLL_INTERVAL`.
+class StreamSupervisor {
+	public:
+		static const size_t HistorySize = 32;
+
+		StreamSupervisor();
+		~StreamSupervisor();
+
+		// Attributes the next start to a `StartStream` request. Returns the id to pass to `WaitForActive()`.
+		uint64_t BeginStart();
+		// Blocks until the first attempt after `previousAttemptId` has sent its first frame or stopped, or until the
+		// timeout elapses. Returns the attempt as it was at that point, with an `Id` of 0 if no attempt began.
+		StreamStartAttempt WaitForActive(uint64_t previousAttemptId, int timeoutMs);
+
+		QJsonObject GetLatestAttempt();
+		QJsonObject GetHistory();
+
+		QJsonObject GetStats();
+
+		static QJsonObject AttemptToJson(const StreamStartAttempt &attempt);
+		static const char *StopCodeName(int code);
+
+	private:
+		static void FrontendEventCallback(enum obs_frontend_event event, void *param);
+		static void StartingCallback(void *param, calldata_t *);
+		static void StartCallback(void *param, calldata_t *);
+		static void ReconnectCallback(void *param, calldata_t *data);
+		static void ReconnectSuccessCallback(void *param, calldata_t *);
+		static void StopCallback(void *param, calldata_t *data);
+
+		void _Attach();
+		void _Connect(obs_output_t *output);
+		void _Disconnect(obs_output_t *output);
+		void _SuperviseLoop();
+		void _Starting(uint64_t now);
+		void _Connected(uint64_t now);
+		void _Reconnecting(uint64_t now, int retryDelay);
+		void _Reconnected(uint64_t now);
+		void _Stopped(uint64_t now, int code, const char *lastError);
+		void _BeginAttempt(uint64_t now);
+		void _Broadcast(const char *eventType, const QJsonObject &eventData);
+
+		QMutex _mutex;
+		QWaitCondition _condition;
+		// Serializes re-attaching, which connects signals outside of `_mutex`
+		QMutex _attachMutex;
+		OBSWeakOutput _output;
+		uint64_t _pendingRequestAt;
+		StreamStartAttempt _current;
+		// Finished attempts and outages. Only pushed to with `_mutex` held.
+		RingBuffer<StreamStartAttempt, HistorySize> _attempts;
+		RingBuffer<StreamReconnect, 64> _reconnects;
+		bool _running;
+		std::thread _superviseThread;
+
+		std::atomic<uint64_t> _starts;
+		std::atomic<uint64_t> _failedStarts;
+		std::atomic<uint64_t> _reconnectAttempts;
+		std::atomic<uint64_t> _reconnectCount;
+		std::atomic<uint64_t> _lastConnectTime;
+		std::atomic<uint64_t> _lastFirstFrameTime;
+};
+
+typedef std::shared_ptr<StreamSupervisor> StreamSupervisorPtr;